@@ -32,6 +32,7 @@
 #include "whysynth_voice.h"
 #include "wave_tables.h"
 #include "agran_oscillator.h"
+#include "arena.h"
 
 #include "whysynth_voice_inline.h"
 
@@ -311,24 +312,22 @@ agran_oscillator(unsigned long sample_count,
 }
 
 int
-new_grain_array(y_synth_t *synth, int grain_count)
+new_grain_array(y_synth_t *synth, y_arena_t *arena, int grain_count)
 {
-    /* assumes voicelist is locked and any existing grains are freed */
+    /* adds grain_count grains from arena to the free grain list; assumes the
+     * voicelist is locked */
+    grain_t *grains;
     int i;
 
-    if (synth->grains)
-        free(synth->grains);
+    grains = (grain_t *)arena_alloc(arena, grain_count * sizeof(grain_t));
 
-    synth->free_grain_list = NULL;
-
-    synth->grains = (grain_t *)calloc(grain_count, sizeof(grain_t));
-
-    if (!synth->grains)
+    if (!grains)
         return 0;
 
-    synth->free_grain_list = synth->grains;
     for (i = 1; i < grain_count; i++)
-        synth->grains[i - 1].next = &synth->grains[i];
+        grains[i - 1].next = &grains[i];
+    grains[grain_count - 1].next = synth->free_grain_list;
+    synth->free_grain_list = grains;
 
     return 1;
 }
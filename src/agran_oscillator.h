@@ -27,7 +27,10 @@
 #include "whysynth.h"
 #include "whysynth_voice.h"
 
-#define AG_DEFAULT_GRAIN_COUNT  (Y_MAX_POLYPHONY * 10)
+/* grains are allocated along with voices, this many per voice, but never
+ * fewer than AG_MIN_GRAIN_COUNT in all */
+#define AG_GRAINS_PER_VOICE     10
+#define AG_MIN_GRAIN_COUNT     640
 
 #define AG_GRAIN_ENVELOPE_COUNT 31
 
@@ -90,7 +93,7 @@ extern grain_envelope_descriptor_t grain_envelope_descriptors[AG_GRAIN_ENVELOPE_
 void agran_oscillator(unsigned long sample_count,
                       y_synth_t *synth, y_sosc_t *sosc,
                       y_voice_t *voice, struct vosc *vosc, int index, float w);
-int  new_grain_array(y_synth_t *synth, int grain_count);
+int  new_grain_array(y_synth_t *synth, y_arena_t *arena, int grain_count);
 grain_envelope_data_t *
      create_grain_envelopes(unsigned long sample_rate);
 void free_grain_envelopes(grain_envelope_data_t *envelopes);
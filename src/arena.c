@@ -0,0 +1,192 @@
+/* WhySynth DSSI software synthesizer plugin
+ *
+ * Copyright (C) 2017 Sean Bolton and others.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/* Per-instance realtime memory arena.
+ *
+ * Everything the audio thread touches for an instance -- the y_synth_t
+ * itself, its voices, its grain array, and its effect buffer -- is carved
+ * out of one anonymous mapping, sized up front by y_instantiate().  Keeping
+ * it contiguous means fewer TLB entries and no allocator metadata between
+ * hot structures.  Arenas of at least one huge page use huge pages if the
+ * system has any reserved; otherwise transparent huge pages are requested.
+ * The whole mapping is then locked into memory if the memlock limit allows,
+ * or at least touched page by page, so the audio thread never takes a page
+ * fault on it.
+ *
+ * Allocations are never freed individually; the arena goes away all at once
+ * in y_cleanup().  Memory added later (more voices when the polyphony is
+ * raised) comes from further arenas chained to the first. */
+
+#define _DEFAULT_SOURCE 1
+#define _ISOC99_SOURCE  1
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "whysynth.h"
+#include "arena.h"
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifdef MAP_HUGETLB
+/*
+ * arena_huge_page_size
+ *
+ * Returns the system's default huge page size (the size MAP_HUGETLB maps
+ * in), from /proc/meminfo, or 0 if it can't be found.
+ */
+static size_t
+arena_huge_page_size(void)
+{
+    static size_t huge_page = (size_t)-1;  /* not yet looked up */
+    size_t found = 0;
+    char line[128];
+    unsigned long kb;
+    FILE *fp;
+
+    if (huge_page == (size_t)-1) {
+        if ((fp = fopen("/proc/meminfo", "r")) != NULL) {
+            while (fgets(line, sizeof(line), fp)) {
+                if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+                    found = (size_t)kb * 1024;
+                    break;
+                }
+            }
+            fclose(fp);
+        }
+        huge_page = found;
+    }
+    return huge_page;
+}
+#endif
+
+/*
+ * arena_create
+ *
+ * Maps a zero-filled arena with at least size bytes available to
+ * arena_alloc(), or returns NULL.
+ */
+y_arena_t *
+arena_create(size_t size)
+{
+    y_arena_t *arena;
+    char *base = MAP_FAILED;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t i;
+    int huge = 0;
+
+    size += arena_round(sizeof(y_arena_t));
+
+#ifdef MAP_HUGETLB
+    /* only ask for huge pages if the arena would fill at least one, so that
+     * small arenas (such as those for added voices) don't each take one */
+    {   size_t huge_page = arena_huge_page_size();
+
+        if (huge_page && size >= huge_page) {
+            size_t huge_size = (size + huge_page - 1) & ~(huge_page - 1);
+
+            base = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (base != MAP_FAILED) {
+                size = huge_size;
+                huge = 1;
+            }
+        }
+    }
+#endif
+    if (base == MAP_FAILED) {
+        size = (size + page - 1) & ~(page - 1);
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            YDB_MESSAGE(-1, " arena_create: could not map %lu bytes\n", (unsigned long)size);
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(base, size, MADV_HUGEPAGE);  /* a hint; failure is harmless */
+#endif
+    }
+
+    arena = (y_arena_t *)base;
+    arena->next = NULL;
+    arena->base = base;
+    arena->size = size;
+    arena->used = arena_round(sizeof(y_arena_t));
+    arena->huge = huge;
+
+    /* pre-fault the whole arena, and keep it resident if we may */
+    if (mlock(base, size) == 0) {
+        arena->locked = 1;
+    } else {
+        arena->locked = 0;
+        for (i = 0; i < size; i += page)
+            ((volatile char *)base)[i] = 0;
+    }
+
+    YDB_MESSAGE(YDB_DSSI, " arena_create: %lu bytes at %p%s%s\n", (unsigned long)size, base,
+                huge ? ", huge pages" : "", arena->locked ? ", locked" : "");
+
+    return arena;
+}
+
+/*
+ * arena_alloc
+ *
+ * Returns size bytes of zeroed, cache-line-aligned memory from the arena, or
+ * NULL if the arena was not sized to hold it.  Not for use from the audio
+ * thread.
+ */
+void *
+arena_alloc(y_arena_t *arena, size_t size)
+{
+    void *p;
+
+    size = arena_round(size);
+    if (arena->size - arena->used < size) {
+        YDB_MESSAGE(-1, " arena_alloc ERROR: arena exhausted!\n");
+        return NULL;
+    }
+    p = arena->base + arena->used;
+    arena->used += size;
+    return p;
+}
+
+/*
+ * arena_destroy
+ *
+ * Unmaps the arena and any arenas chained to it, and with them everything
+ * allocated from them.
+ */
+void
+arena_destroy(y_arena_t *arena)
+{
+    y_arena_t *next;
+
+    while (arena) {
+        next = arena->next;
+        munmap(arena->base, arena->size);  /* also unlocks */
+        arena = next;
+    }
+}
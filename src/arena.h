@@ -0,0 +1,56 @@
+/* WhySynth DSSI software synthesizer plugin
+ *
+ * Copyright (C) 2017 Sean Bolton and others.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+#include "whysynth_types.h"
+
+/* alignment of each arena allocation, one cache line */
+#define Y_ARENA_ALIGN  64
+
+struct _y_arena_t {
+    y_arena_t *next;  /* further arenas belonging to the same instance */
+    char   *base;     /* start of the mapping; the arena header lives here */
+    size_t  size;     /* size of the mapping */
+    size_t  used;     /* bytes handed out so far, including the header */
+    int     huge;     /* mapped with explicit huge pages */
+    int     locked;   /* locked into memory */
+};
+
+/*
+ * arena_round
+ *
+ * Returns size rounded up to a whole number of arena alignment units, for
+ * totalling up the size an arena needs.
+ */
+static inline size_t
+arena_round(size_t size)
+{
+    return (size + Y_ARENA_ALIGN - 1) & ~(size_t)(Y_ARENA_ALIGN - 1);
+}
+
+y_arena_t *arena_create(size_t size);
+void      *arena_alloc(y_arena_t *arena, size_t size);
+void       arena_destroy(y_arena_t *arena);
+
+#endif /* _ARENA_H */
@@ -21,8 +21,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
 #include <inttypes.h>
@@ -31,6 +33,7 @@
 #include "whysynth_types.h"
 #include "whysynth.h"
 #include "whysynth_voice.h"
+#include "common_data.h"
 
 y_patch_t y_init_voice = {
     "  <-->",
@@ -59,7 +62,7 @@ y_patch_t y_init_voice = {
 };
 
 int
-y_data_is_comment(char *buf)  /* line is blank, whitespace, or first non-whitespace character is '#' */
+y_data_is_comment(const char *buf)  /* line is blank, whitespace, or first non-whitespace character is '#' */
 {
     int i = 0;
 
@@ -139,31 +142,43 @@ y_ensure_valid_utf8(char *str, int maxlen)
     }
 }
 
+static inline int
+y_hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
 void
 y_data_parse_text(const char *buf, char *name, int maxlen)
 {
-    int i = 0, o = 0;
-    unsigned int t;
+    char *out = name, *end = name + maxlen;
+    int c, hi, lo, high = 0;
 
-    while (buf[i] && o < maxlen) {
-        if (buf[i] < 33 || buf[i] > 126) {
-            break;
-        } else if (buf[i] == '%') {
-            if (buf[i + 1] && buf[i + 2] && sscanf(buf + i + 1, "%2x", &t) == 1) {
-                name[o++] = (char)t;
-                i += 3;
-            } else {
+    while (out < end) {
+        c = (unsigned char)*buf;
+        if (c != '%') {
+            if (c < 33 || c > 126)  /* also stops at the terminating NUL */
                 break;
-            }
+            *out++ = c;
+            buf++;
+        } else if ((hi = y_hex_digit(buf[1])) >= 0 &&
+                   (lo = y_hex_digit(buf[2])) >= 0) {
+            *out++ = (char)((hi << 4) | lo);
+            high |= hi & 8;
+            buf += 3;
         } else {
-            name[o++] = buf[i++];
+            break;
         }
     }
     /* trim trailing spaces */
-    while (o && name[o - 1] == ' ') o--;
-    name[o] = '\0';
+    while (out > name && out[-1] == ' ') out--;
+    *out = '\0';
 
-    y_ensure_valid_utf8(name, maxlen);
+    if (high)  /* only escaped characters may be outside ASCII */
+        y_ensure_valid_utf8(name, maxlen);
 }
 
 /* y_sscanf.c - dual-locale sscanf
@@ -512,60 +527,561 @@ y_sscanf(const char *str, const char *format, ...)
 
 /* end of y_sscanf.c */
 
+/* ==== patch text parser ==== */
+
+/* y_data_read_file() pads the text it reads with this many NULs past its
+ * terminator, so that the scanners below may always load eight characters
+ * at once */
+#define Y_DATA_TEXT_PADDING  8
+
+/* Loads eight characters, the first in the least significant byte
+ * (compilers turn this into a single load on little-endian hosts). */
+static inline uint64_t
+y_load8(const char *p)
+{
+    const unsigned char *u = (const unsigned char *)p;
+
+    return ((uint64_t)u[0]       | (uint64_t)u[1] << 8  |
+            (uint64_t)u[2] << 16 | (uint64_t)u[3] << 24 |
+            (uint64_t)u[4] << 32 | (uint64_t)u[5] << 40 |
+            (uint64_t)u[6] << 48 | (uint64_t)u[7] << 56);
+}
+
+/* Returns the length of the token at 'p', that is, the number of
+ * characters before the first whitespace, control character or NUL, or 8
+ * if it is eight or more characters long. */
+static inline int
+y_token_length(const char *p)
+{
+    uint64_t x = y_load8(p), blank;
+
+    /* set the high bit of the first byte below '!' (and maybe of some
+     * bytes after it, which don't matter) */
+    blank = (x - 0x2121212121212121ULL) & ~x & 0x8080808080808080ULL;
+    return blank ? __builtin_ctzll(blank) >> 3 : 8;
+}
+
+/* The patch file keywords are looked up with a perfect hash of the first
+ * two characters and the length of the first word on each line, so each
+ * line is dispatched after one string comparison, then parsed in a
+ * single pass.  A new keyword must keep the hash collision-free. */
+
+enum y_data_keyword {
+    Y_KW_NONE = 0,
+    Y_KW_WHYSYNTH,
+    Y_KW_NAME,
+    Y_KW_CATEGORY,
+    Y_KW_COMMENT,
+    Y_KW_OSCY,
+    Y_KW_VCFY,
+    Y_KW_MIX,
+    Y_KW_VOLUME,
+    Y_KW_EFFECTS,
+    Y_KW_GLIDE,
+    Y_KW_BEND,
+    Y_KW_LFOY,
+    Y_KW_MLFO,
+    Y_KW_EGY,
+    Y_KW_MODMIX
+};
+
+static const struct {
+    char        word[9];  /* padded, for y_load8() */
+    int         length;
+    int         keyword;
+} y_data_keywords[32] = {
+    { "vcfY",     4, Y_KW_VCFY     },  /*  0 */
+    { "",         0, Y_KW_NONE     },  /*  1 */
+    { "mix",      3, Y_KW_MIX      },  /*  2 */
+    { "",         0, Y_KW_NONE     },  /*  3 */
+    { "glide",    5, Y_KW_GLIDE    },  /*  4 */
+    { "",         0, Y_KW_NONE     },  /*  5 */
+    { "",         0, Y_KW_NONE     },  /*  6 */
+    { "",         0, Y_KW_NONE     },  /*  7 */
+    { "comment",  7, Y_KW_COMMENT  },  /*  8 */
+    { "mlfo",     4, Y_KW_MLFO     },  /*  9 */
+    { "",         0, Y_KW_NONE     },  /* 10 */
+    { "",         0, Y_KW_NONE     },  /* 11 */
+    { "",         0, Y_KW_NONE     },  /* 12 */
+    { "category", 8, Y_KW_CATEGORY },  /* 13 */
+    { "",         0, Y_KW_NONE     },  /* 14 */
+    { "WhySynth", 8, Y_KW_WHYSYNTH },  /* 15 */
+    { "bend",     4, Y_KW_BEND     },  /* 16 */
+    { "modmix",   6, Y_KW_MODMIX   },  /* 17 */
+    { "",         0, Y_KW_NONE     },  /* 18 */
+    { "",         0, Y_KW_NONE     },  /* 19 */
+    { "name",     4, Y_KW_NAME     },  /* 20 */
+    { "",         0, Y_KW_NONE     },  /* 21 */
+    { "egY",      3, Y_KW_EGY      },  /* 22 */
+    { "",         0, Y_KW_NONE     },  /* 23 */
+    { "effects",  7, Y_KW_EFFECTS  },  /* 24 */
+    { "oscY",     4, Y_KW_OSCY     },  /* 25 */
+    { "volume",   6, Y_KW_VOLUME   },  /* 26 */
+    { "",         0, Y_KW_NONE     },  /* 27 */
+    { "lfoY",     4, Y_KW_LFOY     },  /* 28 */
+    { "",         0, Y_KW_NONE     },  /* 29 */
+    { "",         0, Y_KW_NONE     },  /* 30 */
+    { "",         0, Y_KW_NONE     },  /* 31 */
+};
+
+static int
+y_data_keyword(const char *word, int length)
+{
+    int h;
+
+    if (length < 3 || length > 8)
+        return Y_KW_NONE;
+    h = ((unsigned char)word[0] + 2 * (unsigned char)word[1] + length) & 31;
+    if (y_data_keywords[h].length == length &&
+        !((y_load8(word) ^ y_load8(y_data_keywords[h].word)) &
+          (~0ULL >> (64 - 8 * length))))
+        return y_data_keywords[h].keyword;
+    return Y_KW_NONE;
+}
+
+static inline int
+_is_blank(char c)  /* whitespace other than newline */
+{
+    return (c == ' ' || (c >= '\t' && c <= '\r' && c != '\n'));
+}
+
+/* The y_scan_*() functions each skip blanks, then scan one item from
+ * the current line, returning a pointer past it, or NULL if it is not
+ * there.  Each also returns NULL if passed NULL, so a run of them need
+ * only be checked at the end. */
+
+static const char *
+y_scan_word(const char *p, const char **word, int *length)
+{
+    int n;
+
+    if (!p) return NULL;
+    while (_is_blank(*p)) p++;
+    *word = p;
+    while (1) {  /* eight characters at a time */
+        n = y_token_length(p);
+        p += n;
+        if (n == 8)
+            continue;
+        if (!*p || _is_whitespace(*p))
+            break;
+        p++;  /* a control character, which is part of the word */
+    }
+    *length = p - *word;
+    return (*length ? p : NULL);
+}
+
+/* Returns the keyword at the start of 'line', setting '*end' past it, or
+ * Y_KW_NONE if the first word is not a keyword.  Sets '*end' to NULL if
+ * the line is blank.  This is y_scan_word() followed by y_data_keyword(),
+ * short-cut for the usual line, which starts with the keyword. */
+static inline int
+y_data_line_keyword(const char *line, const char **end)
+{
+    uint64_t x = y_load8(line);
+    const char *word;
+    int n, h;
+
+    n = y_token_length(line);
+    if (n >= 3 && (!line[n] || _is_whitespace(line[n]))) {
+        h = ((unsigned char)line[0] + 2 * (unsigned char)line[1] + n) & 31;
+        if (y_data_keywords[h].length == n &&
+            !((x ^ y_load8(y_data_keywords[h].word)) & (~0ULL >> (64 - 8 * n)))) {
+            *end = line + n;
+            return y_data_keywords[h].keyword;
+        }
+    }
+    /* leading blanks, or not a keyword */
+    if (!(*end = y_scan_word(line, &word, &n)))
+        return Y_KW_NONE;
+    return y_data_keyword(word, n);
+}
+
+static const char *
+y_scan_char(const char *p, char *c)
+{
+    if (!p) return NULL;
+    while (_is_blank(*p)) p++;
+    if (!*p || *p == '\n') return NULL;
+    *c = *p;
+    return p + 1;
+}
+
+/* Scans a run of up to eight decimal digits at once, returning the
+ * length of the run, and its value in *value. */
+static inline int
+y_scan_digits(const char *p, uint32_t *value)
+{
+    uint64_t x, nondigit;
+    int n;
+
+    /* map '0'-'9' to 0-9, then set the high bit of each byte which is not
+     * now 0-9 */
+    x = y_load8(p) ^ 0x3030303030303030ULL;
+    nondigit = (((x & 0x7f7f7f7f7f7f7f7fULL) + 0x7676767676767676ULL) | x) &
+                   0x8080808080808080ULL;
+    n = nondigit ? __builtin_ctzll(nondigit) >> 3 : 8;
+
+    /* shift out the non-digits, leaving leading zeros (in two steps, so
+     * neither shift is by 64 when there are no digits), then combine the
+     * digits pairwise */
+    x <<= 32 - 4 * n;
+    x <<= 32 - 4 * n;
+    x = (x * 10 + (x >> 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x * 100 + (x >> 16)) & 0x0000ffff0000ffffULL;
+    x = (x * 10000 + (x >> 32)) & 0x00000000ffffffffULL;
+    *value = (uint32_t)x;
+
+    return n;
+}
+
+static __attribute__((noinline)) const char *
+y_scan_int_token(const char *p, int *result)
+{
+    const char *digits;
+    int negative, v = 0;
+
+    if (!p) return NULL;
+    while (_is_blank(*p)) p++;
+    negative = (*p == '-');
+    p += (negative | (*p == '+'));
+    for (digits = p; _is_digit(*p); p++)
+        v = v * 10 + (*p - '0');
+    if (p == digits)
+        return NULL;
+    *result = negative ? -v : v;
+    return p;
+}
+
+/* Most of the numbers in a patch file are one or two digits, or a
+ * fraction like 0.5 or 0.234944, following a single space, so y_scan_int()
+ * and y_scan_float() check for those inline, where each field's branches
+ * are predicted separately, before calling the full scanner. */
+static inline __attribute__((always_inline)) const char *
+y_scan_int(const char *p, int *result)
+{
+    if (p && p[0] == ' ' && _is_digit(p[1])) {
+        if ((unsigned char)p[2] <= ' ') {
+            *result = p[1] - '0';
+            return p + 2;
+        }
+        if (_is_digit(p[2]) && (unsigned char)p[3] <= ' ') {
+            *result = (p[1] - '0') * 10 + (p[2] - '0');
+            return p + 3;
+        }
+    }
+    return y_scan_int_token(p, result);
+}
+
+/* powers of ten which are exactly representable as doubles */
+static const double y_pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const int64_t y_pow10_int[9] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/* a significand below y_significand_limit[n] may be multiplied by 10^n
+ * and have n more digits added, while staying exactly representable as a
+ * double */
+static const int64_t y_significand_limit[9] = {
+    INT64_C(9007199254740991) / 1,         INT64_C(9007199254740991) / 10,
+    INT64_C(9007199254740991) / 100,       INT64_C(9007199254740991) / 1000,
+    INT64_C(9007199254740991) / 10000,     INT64_C(9007199254740991) / 100000,
+    INT64_C(9007199254740991) / 1000000,   INT64_C(9007199254740991) / 10000000,
+    INT64_C(9007199254740991) / 100000000
+};
+
+/* Scans a floating point number, as y_scan_float() does, for the
+ * numbers its fast path does not handle.  Numbers whose digits fit
+ * exactly in a double, with small exponents, are converted with a single
+ * correctly-rounded multiply or divide; anything else is left to
+ * y_atof(). */
+static __attribute__((noinline)) const char *
+y_scan_float_general(const char *p, float *result)
+{
+    const char *start;
+    uint32_t v;
+    int64_t s;          /* significand */
+    int e = 0;          /* decimal exponent */
+    int n, digits, negative = 0;
+    double d;
+
+    if (!p) return NULL;
+    while (_is_blank(*p)) p++;
+    start = p;
+    if (*p == '-') {
+        negative = 1;
+        p++;
+    } else if (*p == '+') {
+        p++;
+    }
+    s = 0;
+    if ((digits = y_scan_digits(p, &v)) == 8)
+        goto slow;
+    s = v;
+    p += digits;
+    if (*p == '.' || *p == ',') {
+        p++;
+        do {  /* eight fraction digits at a time */
+            n = y_scan_digits(p, &v);
+            if (s >= y_significand_limit[n])
+                goto slow;  /* too many significant digits */
+            s = s * y_pow10_int[n] + v;
+            e -= n;
+            p += n;
+            digits += n;
+        } while (n == 8);
+    }
+    if (!digits)
+        return NULL;
+    if (*p == 'e' || *p == 'E') {
+        int x;
+
+        p++;
+        if (!_is_digit(p[0]) && !((p[0] == '-' || p[0] == '+') && _is_digit(p[1])))
+            return NULL;  /* malformed exponent */
+        p = y_scan_int(p, &x);
+        if (x < -22 || x > 22)
+            goto slow;
+        e += x;
+    }
+    if (e < -22)
+        goto slow;
+
+    d = (double)s;
+    if (e < 0)
+        d /= y_pow10[-e];
+    else
+        d *= y_pow10[e];
+    *result = (float)(negative ? -d : d);
+    return p;
+
+  slow:
+    {
+        char num[64], *comma;
+
+        for (n = 0; n < sizeof(num) - 1 && start[n] && !_is_whitespace(start[n]); n++)
+            num[n] = start[n];
+        num[n] = '\0';
+        if ((comma = strchr(num, ',')))
+            *comma = '.';
+        if (!(n = y_atof(num, &d)))
+            return NULL;
+        *result = (float)d;
+        return start + n;
+    }
+}
+
+/* Scans a floating point number, accepting either '.' or ',' as the
+ * decimal point, independent of the locale.  Almost everything WhySynth
+ * writes has a few digits and no exponent: these are accumulated into an
+ * integer and divided by an exact power of ten, for a correctly-rounded
+ * double.  Anything else goes to y_scan_float_general(). */
+static __attribute__((noinline)) const char *
+y_scan_float_token(const char *p, float *result)
+{
+    const unsigned char *u, *digits;
+    const char *start;
+    uint64_t s = 0;
+    unsigned int c;
+    int n, nf = 0, negative;
+    double d;
+
+    if (!p) return NULL;
+    p += (*p == ' ');  /* the usual single space */
+    while ((unsigned char)*p <= ' ' && _is_blank(*p)) p++;
+    start = p;
+    negative = (*p == '-');
+    u = (const unsigned char *)p + (negative | (*p == '+'));
+    for (digits = u; (c = *u - '0') <= 9; u++)
+        s = s * 10 + c;
+    n = u - digits;
+    if (*u == '.' || *u == ',') {
+        uint32_t v;
+        nf = y_scan_digits((const char *)++u, &v);
+        s = s * y_pow10_int[nf] + v;
+        u += nf;
+        n += nf;
+    }
+    p = (const char *)u;
+    if (n == 0 || n > 15 ||
+        ((unsigned char)*p > ' ' && (_is_digit(*p) || *p == 'e' || *p == 'E')))
+        return y_scan_float_general(start, result);
+
+    d = (double)(int64_t)s / y_pow10[nf];
+    *result = (float)(negative ? -d : d);
+    return p;
+}
+
+/* Scans a number of the form "d.ddd", with up to seven digits after the
+ * point, for y_scan_float(), which has already checked the first three
+ * characters at 'p'. */
+static __attribute__((noinline)) const char *
+y_scan_float_fraction(const char *p, float *result)
+{
+    uint32_t v;
+    int n = y_scan_digits(p + 2, &v);
+
+    if (n == 8 || (unsigned char)p[2 + n] > ' ')
+        return y_scan_float_token(p, result);
+    *result = (float)((double)((p[0] - '0') * y_pow10_int[n] + v) / y_pow10[n]);
+    return p + 2 + n;
+}
+
+static inline __attribute__((always_inline)) const char *
+y_scan_float(const char *p, float *result)
+{
+    if (p && p[0] == ' ' && _is_digit(p[1])) {
+        if ((unsigned char)p[2] <= ' ') {
+            *result = (float)(p[1] - '0');
+            return p + 2;
+        }
+        if (p[2] == '.' && _is_digit(p[3])) {
+            if ((unsigned char)p[4] <= ' ') {
+                *result = (float)((double)((p[1] - '0') * 10 + (p[3] - '0')) / 10.0);
+                return p + 4;
+            }
+            return y_scan_float_fraction(p + 1, result);
+        }
+    }
+    return y_scan_float_token(p, result);
+}
+
+/*
+ * y_data_next_line
+ *
+ * Returns the start of the line following 'p', which may point anywhere
+ * within a line, or NULL if there is none.  The parser passes the point
+ * it has scanned to, which is usually at the newline already.
+ */
+static inline const char *
+y_data_next_line(const char *p)
+{
+    if (*p != '\n' && !(p = strchr(p, '\n')))
+        return NULL;
+
+    return (p[1] ? p + 1 : NULL);
+}
+
+/*
+ * y_data_read_file
+ *
+ * Reads a whole file into a newly-allocated, NUL-terminated buffer, for
+ * y_data_parse_patch().  Returns NULL if the file can't be read.
+ */
+char *
+y_data_read_file(const char *filename)
+{
+    struct stat statbuf;
+    char *text;
+    ssize_t n;
+    size_t length = 0;
+    int fd;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return NULL;
+    if (fstat(fd, &statbuf) ||
+        !(text = (char *)malloc(statbuf.st_size + 1 + Y_DATA_TEXT_PADDING))) {
+        close(fd);
+        return NULL;
+    }
+    while (length < statbuf.st_size &&
+           (n = read(fd, text + length, statbuf.st_size - length)) > 0)
+        length += n;
+    close(fd);
+    memset(text + length, 0, 1 + Y_DATA_TEXT_PADDING);
+
+    return text;
+}
+
+/*
+ * y_data_parse_patch
+ *
+ * Parses the next patch in a text patch bank, which must have been read
+ * into memory by y_data_read_file() (for the padding it adds), advancing
+ * *text past it.  Returns false if there is not another patch, or it is
+ * malformed.
+ */
 int
-y_data_read_patch(FILE *file, y_patch_t *patch)
+y_data_parse_patch(const char **text, y_patch_t *patch)
 {
-    int format, i;
-    char c, buf[256], buf2[181];
+    int format, i, keyword, length;
+    char c;
+    const char *line = *text, *p, *word;
     y_patch_t tmp;
 
-    do {
-        if (!fgets(buf, 256, file)) return 0;
-    } while (y_data_is_comment(buf));
+    if (!line)
+        return 0;
+    while (y_data_is_comment(line)) {
+        if (!(line = y_data_next_line(line))) return 0;
+    }
 
-    if (sscanf(buf, " WhySynth patch format %d begin", &format) != 1 ||
-        (format != 0 && format != 1))
+    /* 'WhySynth patch format 1 begin' */
+    p = y_scan_word(line, &word, &length);
+    if (!p || y_data_keyword(word, length) != Y_KW_WHYSYNTH)
+        return 0;
+    p = y_scan_word(p, &word, &length);
+    if (!p || length != 5 || memcmp(word, "patch", 5))
+        return 0;
+    p = y_scan_word(p, &word, &length);
+    if (!p || length != 6 || memcmp(word, "format", 6))
+        return 0;
+    if (!y_scan_int(p, &format) || (format != 0 && format != 1))
         return 0;
 
     memcpy(&tmp, &y_init_voice, sizeof(y_patch_t));
 
     while (1) {
-        
-        if (!fgets(buf, 256, file)) return 0;
 
-        /* 'name %20%20<init%20voice>' */
-        if (sscanf(buf, " name %90s%n", buf2, &i) == 1) {
-            
-            y_data_parse_text(buf2, tmp.name, 30);
+        if (!(line = y_data_next_line(p))) return 0;
+
+        keyword = y_data_line_keyword(line, &p);
+        if (!p)
+            return 0; /* blank line */
+
+        switch (keyword) {
+
+          /* 'name %20%20<init%20voice>' */
+          case Y_KW_NAME:
+            if (!(p = y_scan_word(p, &word, &length)))
+                return 0;
+            y_data_parse_text(word, tmp.name, 30);
             /* if this is a format 0 patch, check if the category is piggy-
              * backed on the name line. */
-            if (format == 0 &&
-                sscanf(buf + i, " category %30s", buf2) == 1) {
-                y_data_parse_text(buf2, tmp.category, 10);
+            if (format == 0 && y_scan_word(p, &word, &length) &&
+                y_data_keyword(word, length) == Y_KW_CATEGORY &&
+                y_scan_word(word + length, &word, &length)) {
+                y_data_parse_text(word, tmp.category, 10);
             }
-            continue;
-
-        /* 'category Strings' */
-        } else if (sscanf(buf, " category %30s", buf2) == 1) {
-
-            y_data_parse_text(buf2, tmp.category, 10);
-            continue;
+            break;
 
-        /* 'comment %20%20<init%20voice>' */
-        } else if (sscanf(buf, " comment %180s", buf2) == 1) {
-            
-            y_data_parse_text(buf2, tmp.comment, 60);
-            continue;
+          /* 'category Strings' */
+          case Y_KW_CATEGORY:
+            if (!y_scan_word(p, &word, &length))
+                return 0;
+            y_data_parse_text(word, tmp.category, 10);
+            break;
 
-        /* -PORTS- */
-        /* 'oscY 1 1 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
-        /* 'oscY 2 0 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
-        /* 'oscY 3 0 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
-        /* 'oscY 4 0 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
-        } else if (sscanf(buf, " oscY %d", &i) == 1) {
+          /* 'comment %20%20<init%20voice>' */
+          case Y_KW_COMMENT:
+            if (!y_scan_word(p, &word, &length))
+                return 0;
+            y_data_parse_text(word, tmp.comment, 60);
+            break;
 
+          /* -PORTS- */
+          /* 'oscY 1 1 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
+          /* 'oscY 2 0 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
+          /* 'oscY 3 0 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
+          /* 'oscY 4 0 0 0 0 0 0 0 0.5 0 0 0 0 0.5 0.5' */
+          case Y_KW_OSCY: {
             struct posc *osc;
 
+            if (!(p = y_scan_int(p, &i)))
+                return 0;
             switch (i) {
               case 1: osc = &tmp.osc1; break;
               case 2: osc = &tmp.osc2; break;
@@ -574,76 +1090,104 @@ y_data_read_patch(FILE *file, y_patch_t *patch)
               default:
                 return 0;
             }
-            if (y_sscanf(buf, " oscY %d %d %d %d %f %d %f %f %f %d %f %d %f %f %f",
-                         &i, &osc->mode, &osc->waveform, &osc->pitch,
-                         &osc->detune, &osc->pitch_mod_src, &osc->pitch_mod_amt,
-                         &osc->mparam1, &osc->mparam2, &osc->mmod_src,
-                         &osc->mmod_amt, &osc->amp_mod_src, &osc->amp_mod_amt,
-                         &osc->level_a, &osc->level_b) != 15)
+            p = y_scan_int(p, &osc->mode);
+            p = y_scan_int(p, &osc->waveform);
+            p = y_scan_int(p, &osc->pitch);
+            p = y_scan_float(p, &osc->detune);
+            p = y_scan_int(p, &osc->pitch_mod_src);
+            p = y_scan_float(p, &osc->pitch_mod_amt);
+            p = y_scan_float(p, &osc->mparam1);
+            p = y_scan_float(p, &osc->mparam2);
+            p = y_scan_int(p, &osc->mmod_src);
+            p = y_scan_float(p, &osc->mmod_amt);
+            p = y_scan_int(p, &osc->amp_mod_src);
+            p = y_scan_float(p, &osc->amp_mod_amt);
+            p = y_scan_float(p, &osc->level_a);
+            p = y_scan_float(p, &osc->level_b);
+            if (!p)
                 return 0;
+            break;
+          }
 
-            continue;
-
-        /* 'vcfY 1 1 0 50 0 0 0 0' */
-        /* 'vcfY 2 0 0 50 0 0 0 0' */
-        } else if (sscanf(buf, " vcfY %d", &i) == 1) {
-
+          /* 'vcfY 1 1 0 50 0 0 0 0' */
+          /* 'vcfY 2 0 0 50 0 0 0 0' */
+          case Y_KW_VCFY: {
             struct pvcf *vcf;
 
+            if (!(p = y_scan_int(p, &i)))
+                return 0;
             switch (i) {
               case 1: vcf = &tmp.vcf1; break;
               case 2: vcf = &tmp.vcf2; break;
               default:
                 return 0;
             }
-            if (y_sscanf(buf, " vcfY %d %d %d %f %d %f %f %f",
-                         &i, &vcf->mode, &vcf->source, &vcf->frequency,
-                         &vcf->freq_mod_src, &vcf->freq_mod_amt, &vcf->qres,
-                         &vcf->mparam) != 8)
+            p = y_scan_int(p, &vcf->mode);
+            p = y_scan_int(p, &vcf->source);
+            p = y_scan_float(p, &vcf->frequency);
+            p = y_scan_int(p, &vcf->freq_mod_src);
+            p = y_scan_float(p, &vcf->freq_mod_amt);
+            p = y_scan_float(p, &vcf->qres);
+            p = y_scan_float(p, &vcf->mparam);
+            if (!p)
                 return 0;
+            break;
+          }
+
+          /* 'mix 0 0.2 0 0.8 0.5 0.5 0.5 0.5' */
+          case Y_KW_MIX:
+            p = y_scan_float(p, &tmp.busa_level);
+            p = y_scan_float(p, &tmp.busa_pan);
+            p = y_scan_float(p, &tmp.busb_level);
+            p = y_scan_float(p, &tmp.busb_pan);
+            p = y_scan_float(p, &tmp.vcf1_level);
+            p = y_scan_float(p, &tmp.vcf1_pan);
+            p = y_scan_float(p, &tmp.vcf2_level);
+            p = y_scan_float(p, &tmp.vcf2_pan);
+            if (!p)
+                return 0;
+            break;
 
-            continue;
-
-        /* 'mix 0 0.2 0 0.8 0.5 0.5 0.5 0.5' */
-        } else if (y_sscanf(buf, " mix %f %f %f %f %f %f %f %f",
-                            &tmp.busa_level, &tmp.busa_pan,
-                            &tmp.busb_level, &tmp.busb_pan,
-                            &tmp.vcf1_level, &tmp.vcf1_pan,
-                            &tmp.vcf2_level, &tmp.vcf2_pan) == 8) {
-
-            continue;
-
-        /* 'volume 0.5' */
-        } else if (y_sscanf(buf, " volume %f", &tmp.volume) == 1) {
-
-            continue;
-
-        /* 'effects 0 0 0 0 0' */
-        } else if (y_sscanf(buf, " effects %d %f %f %f %f %f %f %f",
-                            &tmp.effect_mode, &tmp.effect_param1,
-                            &tmp.effect_param2, &tmp.effect_param3,
-                            &tmp.effect_param4, &tmp.effect_param5,
-                            &tmp.effect_param6, &tmp.effect_mix) == 8) {
-
-            continue;
-
-        /* 'glide 0.984375' */
-        } else if (y_sscanf(buf, " glide %f", &tmp.glide_time) == 1) {
-
-            continue;
+          /* 'volume 0.5' */
+          case Y_KW_VOLUME:
+            if (!y_scan_float(p, &tmp.volume))
+                return 0;
+            break;
 
-        /* 'bend 2' */
-        } else if (sscanf(buf, " bend %d", &tmp.bend_range) == 1) {
+          /* 'effects 0 0 0 0 0 0 0 0' */
+          case Y_KW_EFFECTS:
+            p = y_scan_int(p, &tmp.effect_mode);
+            p = y_scan_float(p, &tmp.effect_param1);
+            p = y_scan_float(p, &tmp.effect_param2);
+            p = y_scan_float(p, &tmp.effect_param3);
+            p = y_scan_float(p, &tmp.effect_param4);
+            p = y_scan_float(p, &tmp.effect_param5);
+            p = y_scan_float(p, &tmp.effect_param6);
+            p = y_scan_float(p, &tmp.effect_mix);
+            if (!p)
+                return 0;
+            break;
 
-            continue;
+          /* 'glide 0.984375' */
+          case Y_KW_GLIDE:
+            if (!y_scan_float(p, &tmp.glide_time))
+                return 0;
+            break;
 
-        /* 'lfoY g 1 0 0 0 0' */
-        /* 'lfoY v 1 0 0 0 0' */
-        /* 'lfoY m 1 0 0 0 0' */
-        } else if (sscanf(buf, " lfoY %c", &c) == 1) {
+          /* 'bend 2' */
+          case Y_KW_BEND:
+            if (!y_scan_int(p, &tmp.bend_range))
+                return 0;
+            break;
 
+          /* 'lfoY g 1 0 0 0 0' */
+          /* 'lfoY v 1 0 0 0 0' */
+          /* 'lfoY m 1 0 0 0 0' */
+          case Y_KW_LFOY: {
             struct plfo *lfo;
 
+            if (!(p = y_scan_char(p, &c)))
+                return 0;
             switch (c) {
               case 'g': lfo = &tmp.glfo; break;
               case 'v': lfo = &tmp.vlfo; break;
@@ -651,26 +1195,34 @@ y_data_read_patch(FILE *file, y_patch_t *patch)
               default:
                 return 0;
             }
-            if (y_sscanf(buf, " lfoY %c %f %d %f %d %f",
-                         &c, &lfo->frequency, &lfo->waveform, &lfo->delay,
-                         &lfo->amp_mod_src, &lfo->amp_mod_amt) != 6)
+            p = y_scan_float(p, &lfo->frequency);
+            p = y_scan_int(p, &lfo->waveform);
+            p = y_scan_float(p, &lfo->delay);
+            p = y_scan_int(p, &lfo->amp_mod_src);
+            p = y_scan_float(p, &lfo->amp_mod_amt);
+            if (!p)
                 return 0;
+            break;
+          }
 
-        /* 'mlfo 90 0' */
-        } else if (y_sscanf(buf, " mlfo %f %f", &tmp.mlfo_phase_spread,
-                            &tmp.mlfo_random_freq) == 2) {
-
-            continue;
-
-        /* 'egY o 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
-        /* 'egY 1 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
-        /* 'egY 2 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
-        /* 'egY 3 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
-        /* 'egY 4 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
-        } else if (sscanf(buf, " egY %c", &c) == 1) {
+          /* 'mlfo 90 0' */
+          case Y_KW_MLFO:
+            p = y_scan_float(p, &tmp.mlfo_phase_spread);
+            p = y_scan_float(p, &tmp.mlfo_random_freq);
+            if (!p)
+                return 0;
+            break;
 
+          /* 'egY o 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
+          /* 'egY 1 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
+          /* 'egY 2 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
+          /* 'egY 3 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
+          /* 'egY 4 0 0.1 1 0.1 1 0.1 1 0.2 0.1 1 0 0 0 0 0' */
+          case Y_KW_EGY: {
             struct peg *eg;
 
+            if (!(p = y_scan_char(p, &c)))
+                return 0;
             switch (c) {
               case 'o': eg = &tmp.ego; break;
               case '1': eg = &tmp.eg1; break;
@@ -680,41 +1232,491 @@ y_data_read_patch(FILE *file, y_patch_t *patch)
               default:
                 return 0;
             }
-            if (y_sscanf(buf, " egY %c %d %d %f %f %d %f %f %d %f %f %d %f %f %f %f %d %f",
-                         &c, &eg->mode,
-                         &eg->shape1, &eg->time1, &eg->level1,
-                         &eg->shape2, &eg->time2, &eg->level2,
-                         &eg->shape3, &eg->time3, &eg->level3,
-                         &eg->shape4, &eg->time4,
-                         &eg->vel_level_sens, &eg->vel_time_scale,
-                         &eg->kbd_time_scale, &eg->amp_mod_src,
-                         &eg->amp_mod_amt) != 18)
+            p = y_scan_int(p, &eg->mode);
+            p = y_scan_int(p, &eg->shape1);
+            p = y_scan_float(p, &eg->time1);
+            p = y_scan_float(p, &eg->level1);
+            p = y_scan_int(p, &eg->shape2);
+            p = y_scan_float(p, &eg->time2);
+            p = y_scan_float(p, &eg->level2);
+            p = y_scan_int(p, &eg->shape3);
+            p = y_scan_float(p, &eg->time3);
+            p = y_scan_float(p, &eg->level3);
+            p = y_scan_int(p, &eg->shape4);
+            p = y_scan_float(p, &eg->time4);
+            p = y_scan_float(p, &eg->vel_level_sens);
+            p = y_scan_float(p, &eg->vel_time_scale);
+            p = y_scan_float(p, &eg->kbd_time_scale);
+            p = y_scan_int(p, &eg->amp_mod_src);
+            p = y_scan_float(p, &eg->amp_mod_amt);
+            if (!p)
+                return 0;
+            break;
+          }
+
+          /* 'modmix 1 0 0 0 0' */
+          case Y_KW_MODMIX:
+            p = y_scan_float(p, &tmp.modmix_bias);
+            p = y_scan_int(p, &tmp.modmix_mod1_src);
+            p = y_scan_float(p, &tmp.modmix_mod1_amt);
+            p = y_scan_int(p, &tmp.modmix_mod2_src);
+            p = y_scan_float(p, &tmp.modmix_mod2_amt);
+            if (!p)
+                return 0;
+            break;
+
+          /* 'WhySynth patch end' */
+          case Y_KW_WHYSYNTH:
+            p = y_scan_word(p, &word, &length);
+            if (!p || length != 5 || memcmp(word, "patch", 5))
+                return 0;
+            p = y_scan_word(p, &word, &length);
+            if (!p || length != 3 || memcmp(word, "end", 3))
                 return 0;
 
-        /* 'modmix 1 0 0 0 0' */
-        } else if (y_sscanf(buf, " modmix %f %d %f %d %f", &tmp.modmix_bias,
-                            &tmp.modmix_mod1_src, &tmp.modmix_mod1_amt,
-                            &tmp.modmix_mod2_src, &tmp.modmix_mod2_amt) == 5) {
+            memcpy(patch, &tmp, sizeof(y_patch_t));
+            *text = y_data_next_line(p);
 
-            continue;
+            return 1;  /* finished */
 
-        /* 'WhySynth patch end' */
-        } else if (sscanf(buf, " WhySynth patch %3s", buf2) == 1 &&
-                 !strcmp(buf2, "end")) {
+          default:
+            return 0; /* unrecognized line */
+        }
+    }
+}
 
-            break; /* finished */
+static void
+patch_write_text(FILE *file, char *text, int maxlen)
+{
+    int i;
 
+    for (i = 0; i < maxlen; i++) {
+        if (!text[i]) {
+            break;
+        } else if (text[i] < 33 || text[i] > 126 ||
+                   text[i] == '%') {
+            fprintf(file, "%%%02x", (unsigned char)text[i]);
         } else {
+            fputc(text[i], file);
+        }
+    }
+}
 
-            return 0; /* unrecognized line */
+static int
+patch_write_osc(FILE *file, int index, struct posc *osc)
+{
+    return fprintf(file, "oscY %d %d %d %d %.6g %d %.6g %.6g %.6g %d %.6g %d %.6g %.6g %.6g\n",
+                   index, osc->mode, osc->waveform, osc->pitch, osc->detune,
+                   osc->pitch_mod_src, osc->pitch_mod_amt, osc->mparam1,
+                   osc->mparam2, osc->mmod_src, osc->mmod_amt,
+                   osc->amp_mod_src, osc->amp_mod_amt,
+                   osc->level_a, osc->level_b);
+}
+
+static int
+patch_write_vcf(FILE *file, int index, struct pvcf *vcf)
+{
+    return fprintf(file, "vcfY %d %d %d %.6g %d %.6g %.6g %.6g\n",
+                   index, vcf->mode, vcf->source, vcf->frequency,
+                   vcf->freq_mod_src, vcf->freq_mod_amt, vcf->qres,
+                   vcf->mparam);
+}
+
+static int
+patch_write_lfo(FILE *file, char which, struct plfo *lfo)
+{
+    return fprintf(file, "lfoY %c %.6g %d %.6g %d %.6g\n",
+                   which, lfo->frequency, lfo->waveform, lfo->delay,
+                   lfo->amp_mod_src, lfo->amp_mod_amt);
+}
+
+static int
+patch_write_eg(FILE *file, char which, struct peg *eg)
+{
+    return fprintf(file, "egY %c %d %d %.6g %.6g %d %.6g %.6g %d %.6g %.6g %d %.6g %.6g %.6g %.6g %d %.6g\n",
+                   which, eg->mode,
+                   eg->shape1, eg->time1, eg->level1,
+                   eg->shape2, eg->time2, eg->level2,
+                   eg->shape3, eg->time3, eg->level3,
+                   eg->shape4, eg->time4,
+                   eg->vel_level_sens, eg->vel_time_scale, eg->kbd_time_scale,
+                   eg->amp_mod_src, eg->amp_mod_amt);
+}
+
+/*
+ * y_data_write_patch
+ *
+ * Writes a patch as text, in the given patch file format.
+ */
+int
+y_data_write_patch(FILE *file, y_patch_t *patch, int format)
+{
+    fprintf(file, "# WhySynth patch\n");
+    fprintf(file, "WhySynth patch format %d begin\n", format);
+
+    fprintf(file, "name ");
+    patch_write_text(file, patch->name, 30);
+    if (strlen(patch->category)) {
+        if (format == 0) {
+            fputc(' ', file); /* piggy back category on the name field */
+        } else {
+            fputc('\n', file); /* put it on its own line */
         }
+        fprintf(file, "category ");
+        patch_write_text(file, patch->category, 10);
+    }
+    fputc('\n', file);
+
+    if (strlen(patch->comment)) {
+        fprintf(file, "comment ");
+        patch_write_text(file, patch->comment, 60);
+        fputc('\n', file);
     }
 
-    memcpy(patch, &tmp, sizeof(y_patch_t));
+    /* -PORTS- */
+    patch_write_osc(file, 1, &patch->osc1);
+    patch_write_osc(file, 2, &patch->osc2);
+    patch_write_osc(file, 3, &patch->osc3);
+    patch_write_osc(file, 4, &patch->osc4);
+    patch_write_vcf(file, 1, &patch->vcf1);
+    patch_write_vcf(file, 2, &patch->vcf2);
+    fprintf(file, "mix %.6g %.6g %.6g %.6g %.6g %.6g %.6g %.6g\n",
+            patch->busa_level, patch->busa_pan,
+            patch->busb_level, patch->busb_pan,
+            patch->vcf1_level, patch->vcf1_pan,
+            patch->vcf2_level, patch->vcf2_pan);
+    fprintf(file, "volume %.6g\n", patch->volume);
+    fprintf(file, "effects %d %.6g %.6g %.6g %.6g %.6g %.6g %.6g\n",
+            patch->effect_mode, patch->effect_param1, patch->effect_param2,
+            patch->effect_param3, patch->effect_param4, patch->effect_param5,
+            patch->effect_param6, patch->effect_mix);
+    fprintf(file, "glide %.6g\n", patch->glide_time);
+    fprintf(file, "bend %d\n", patch->bend_range);
+    patch_write_lfo(file, 'g', &patch->glfo);
+    patch_write_lfo(file, 'v', &patch->vlfo);
+    patch_write_lfo(file, 'm', &patch->mlfo);
+    fprintf(file, "mlfo %.6g %.6g\n", patch->mlfo_phase_spread,
+            patch->mlfo_random_freq);
+    patch_write_eg(file, 'o', &patch->ego);
+    patch_write_eg(file, '1', &patch->eg1);
+    patch_write_eg(file, '2', &patch->eg2);
+    patch_write_eg(file, '3', &patch->eg3);
+    patch_write_eg(file, '4', &patch->eg4);
+    fprintf(file, "modmix %.6g %d %.6g %d %.6g\n", patch->modmix_bias,
+            patch->modmix_mod1_src, patch->modmix_mod1_amt,
+            patch->modmix_mod2_src, patch->modmix_mod2_amt);
+
+    fprintf(file, "WhySynth patch end\n");
 
     return 1;  /* -FIX- error handling yet to be implemented */
 }
 
+/*
+ * y_data_bank_record
+ *
+ * Copies a patch as a bank record, with its strings terminated as
+ * y_data_read_bank() and y_data_decode_patch() require.
+ */
+static void
+y_data_bank_record(y_patch_t *record, y_patch_t *patch)
+{
+    memcpy(record, patch, sizeof(y_patch_t));
+    record->name[30] = 0;
+    record->category[10] = 0;
+    record->comment[60] = 0;
+}
+
+static int
+y_data_bank_record_is_valid(y_patch_t *record)
+{
+    return (!record->name[30] && !record->category[10] && !record->comment[60]);
+}
+
+/*
+ * y_data_check_bank_header
+ *
+ * Returns 1 if 'header' is that of a binary patch bank we can use, 0 if
+ * it is not a bank header at all, or -1 if it is one for an
+ * incompatible patch layout.
+ */
+static int
+y_data_check_bank_header(struct y_patch_bank_header *header)
+{
+    if (memcmp(header->magic, Y_PATCH_BANK_MAGIC, sizeof(Y_PATCH_BANK_MAGIC)))
+        return 0;
+    if (header->byte_order != Y_PATCH_BANK_BYTE_ORDER ||
+        header->version != Y_PATCH_BANK_VERSION ||
+        header->record_size != sizeof(y_patch_t) ||
+        header->patch_count > INT_MAX / sizeof(y_patch_t) ||
+        header->records_offset < sizeof(struct y_patch_bank_header) ||
+        header->records_offset % sizeof(double))
+        return -1;
+    return 1;
+}
+
+/*
+ * y_data_write_bank
+ *
+ * Writes 'count' patches as a binary patch bank, returning false on error.
+ */
+int
+y_data_write_bank(FILE *file, y_patch_t *patches, int count)
+{
+    struct y_patch_bank_header header;
+    char pad[Y_PATCH_BANK_RECORDS_OFFSET - sizeof(struct y_patch_bank_header)];
+    y_patch_t tmp;
+    int i;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, Y_PATCH_BANK_MAGIC, sizeof(Y_PATCH_BANK_MAGIC));
+    header.byte_order     = Y_PATCH_BANK_BYTE_ORDER;
+    header.version        = Y_PATCH_BANK_VERSION;
+    header.record_size    = sizeof(y_patch_t);
+    header.patch_count    = count;
+    header.records_offset = Y_PATCH_BANK_RECORDS_OFFSET;
+    memset(pad, 0, sizeof(pad));
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(pad, sizeof(pad), 1, file) != 1)
+        return 0;
+
+    for (i = 0; i < count; i++) {
+        y_data_bank_record(&tmp, &patches[i]);
+        if (fwrite(&tmp, sizeof(y_patch_t), 1, file) != 1)
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * y_data_read_bank
+ *
+ * If 'filename' is a binary patch bank, reads its records straight into
+ * a malloc()ed array, without parsing them, and returns 1, with the
+ * records in *patches and *count.  The caller should free(*patches) when
+ * done with them.  Returns 0 if the file is not a binary bank (or cannot
+ * be opened), or -1 if it is a damaged bank, one written with an
+ * incompatible patch layout, or there is not enough memory for it.
+ */
+int
+y_data_read_bank(const char *filename, y_patch_t **patches, int *count)
+{
+    struct y_patch_bank_header header;
+    y_patch_t *p;
+    char *buf;
+    size_t size, done;
+    ssize_t n;
+    int fd, i, rc;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return 0;
+
+    if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+        (rc = y_data_check_bank_header(&header)) == 0) {
+        close(fd);
+        return 0;
+    }
+
+    if (rc < 0 || header.patch_count == 0) {
+        close(fd);
+        return -1;
+    }
+
+    size = header.patch_count * sizeof(y_patch_t);
+    if (!(p = (y_patch_t *)malloc(size))) {
+        close(fd);
+        return -1;
+    }
+    buf = (char *)p;
+    for (done = 0; done < size; done += n) {
+        n = pread(fd, buf + done, size - done,
+                  (off_t)header.records_offset + (off_t)done);
+        if (n <= 0) {  /* error, or a truncated bank */
+            close(fd);
+            free(p);
+            return -1;
+        }
+    }
+    close(fd);
+
+    for (i = 0; i < header.patch_count; i++) {
+        if (!y_data_bank_record_is_valid(&p[i])) {
+            free(p);
+            return -1;
+        }
+    }
+
+    *patches = p;
+    *count = header.patch_count;
+
+    return 1;
+}
+
+/*
+ * y_data_save_bank
+ *
+ * Writes a binary patch bank file, returning false on error.  It is
+ * written to a new file, which then replaces any existing one, so that
+ * the plugin, which may be reading the existing one at the time, never
+ * sees it half written.
+ */
+int
+y_data_save_bank(const char *filename, y_patch_t *patches, int count)
+{
+    char *newname = (char *)malloc(strlen(filename) + 5);
+    FILE *fh;
+    int fd, ok;
+
+    if (!newname)
+        return 0;
+    sprintf(newname, "%s.new", filename);
+    if ((fd = open(newname, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) {
+        free(newname);
+        return 0;
+    }
+    if ((fh = fdopen(fd, "wb")) == NULL) {
+        close(fd);
+        ok = 0;
+    } else {
+        ok = y_data_write_bank(fh, patches, count);
+        if (fclose(fh))
+            ok = 0;
+    }
+    if (ok && rename(newname, filename))
+        ok = 0;
+    if (!ok)
+        unlink(newname);
+    free(newname);
+
+    return ok;
+}
+
+/*
+ * y_data_write_bank_record
+ *
+ * Stores one patch into a binary patch bank file in place, either over an
+ * existing record or as a new one just past the last, returning false if
+ * that is not possible.  This is safe now that nothing keeps a bank file
+ * mapped: the plugin reads a bank only when told to load it, after the
+ * GUI has finished writing.
+ */
+static int
+y_data_write_bank_record(const char *filename, int index, y_patch_t *patch)
+{
+    struct y_patch_bank_header header;
+    y_patch_t tmp;
+    int fd, ok;
+
+    if ((fd = open(filename, O_RDWR)) < 0)
+        return 0;
+
+    if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+        y_data_check_bank_header(&header) != 1 ||
+        index < 0 || index > header.patch_count) {
+        close(fd);
+        return 0;
+    }
+
+    y_data_bank_record(&tmp, patch);
+    ok = (pwrite(fd, &tmp, sizeof(y_patch_t), (off_t)header.records_offset +
+                     (off_t)index * sizeof(y_patch_t)) == sizeof(y_patch_t));
+    if (ok && index == header.patch_count) {
+        header.patch_count++;
+        ok = (pwrite(fd, &header, sizeof(header), 0) == sizeof(header));
+    }
+    if (close(fd))
+        ok = 0;
+
+    return ok;
+}
+
+/*
+ * y_data_update_bank
+ *
+ * Stores one patch into a binary patch bank file, either over an existing
+ * record or as a new one just past the last, returning false if that is
+ * not possible.  Only the one record (and, when appending, the header) is
+ * written, unless that fails, in which case the records are read in
+ * without parsing and the whole bank saved anew by y_data_save_bank().
+ */
+int
+y_data_update_bank(const char *filename, int index, y_patch_t *patch)
+{
+    y_patch_t *bank, *p;
+    int count, ok;
+
+    if (y_data_write_bank_record(filename, index, patch))
+        return 1;
+
+    if (y_data_read_bank(filename, &bank, &count) != 1)
+        return 0;
+
+    if (index < 0 || index > count) {
+        free(bank);
+        return 0;
+    }
+    if (index == count) {
+        if (!(p = (y_patch_t *)realloc(bank, (count + 1) * sizeof(y_patch_t)))) {
+            free(bank);
+            return 0;
+        }
+        bank = p;
+        count++;
+    }
+    memcpy(&bank[index], patch, sizeof(y_patch_t));
+
+    ok = y_data_save_bank(filename, bank, count);
+    free(bank);
+
+    return ok;
+}
+
+/*
+ * y_data_encode_patch
+ *
+ * Encodes a patch, as its bank record, in Y_PATCH_ENCODED_SIZE
+ * hexadecimal digits plus a terminating NUL.
+ */
+void
+y_data_encode_patch(y_patch_t *patch, char *buf)
+{
+    static const char digits[] = "0123456789abcdef";
+    y_patch_t tmp;
+    unsigned char *p = (unsigned char *)&tmp;
+    int i;
+
+    y_data_bank_record(&tmp, patch);
+    for (i = 0; i < sizeof(y_patch_t); i++) {
+        *buf++ = digits[p[i] >> 4];
+        *buf++ = digits[p[i] & 0x0f];
+    }
+    *buf = 0;
+}
+
+/*
+ * y_data_decode_patch
+ *
+ * Decodes a patch encoded by y_data_encode_patch(), returning a pointer
+ * to the character following the encoding, or NULL if it is malformed.
+ */
+const char *
+y_data_decode_patch(const char *buf, y_patch_t *patch)
+{
+    unsigned char *p = (unsigned char *)patch;
+    int i, hi, lo;
+
+    for (i = 0; i < sizeof(y_patch_t); i++, buf += 2) {
+        if ((hi = y_hex_digit(buf[0])) < 0 || (lo = y_hex_digit(buf[1])) < 0)
+            return NULL;
+        p[i] = (hi << 4) | lo;
+    }
+    if (!y_data_bank_record_is_valid(patch))
+        return NULL;
+
+    return buf;
+}
+
 char *
 y_data_locate_patch_file(const char *origpath, const char *project_dir)
 {
@@ -26,25 +26,60 @@
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
 
 #include "whysynth_types.h"
 #include "whysynth_voice.h"
 
+/* A binary patch bank is a header followed by patch_count y_patch_t
+ * records, stored in the writer's own memory layout so that a bank can
+ * be read straight into memory and its records used as they are.
+ * Y_PATCH_BANK_VERSION must be bumped whenever the layout of y_patch_t
+ * changes. */
+#define Y_PATCH_BANK_MAGIC           "WhySynth patch bank\n"
+#define Y_PATCH_BANK_VERSION         1
+#define Y_PATCH_BANK_BYTE_ORDER      0x01020304
+#define Y_PATCH_BANK_RECORDS_OFFSET  64
+
+struct y_patch_bank_header {
+    char     magic[24];        /* Y_PATCH_BANK_MAGIC, NUL-padded */
+    uint32_t byte_order;       /* Y_PATCH_BANK_BYTE_ORDER, in the writer's byte order */
+    uint32_t version;          /* Y_PATCH_BANK_VERSION */
+    uint32_t record_size;      /* sizeof(y_patch_t) */
+    uint32_t patch_count;
+    uint32_t records_offset;   /* file offset of the first record */
+    uint32_t reserved[3];
+};
+
+/* gui_data_save() format for a binary patch bank */
+#define Y_PATCH_FORMAT_BANK  2
+
+/* length of a patch encoded by y_data_encode_patch(), less its NUL */
+#define Y_PATCH_ENCODED_SIZE  (2 * sizeof(y_patch_t))
+
 /* in common_data.c: */
 extern y_patch_t y_init_voice;
 
 int   y_sscanf(const char *str, const char *format, ...);
-int   y_data_is_comment(char *buf);
+int   y_data_is_comment(const char *buf);
 void  y_ensure_valid_utf8(char *str, int maxlen);
 void  y_data_parse_text(const char *buf, char *name, int maxlen);
-int   y_data_read_patch(FILE *file, y_patch_t *patch);
+char *y_data_read_file(const char *filename);
+int   y_data_parse_patch(const char **text, y_patch_t *patch);
+int   y_data_write_patch(FILE *file, y_patch_t *patch, int format);
+int   y_data_write_bank(FILE *file, y_patch_t *patches, int count);
+int   y_data_save_bank(const char *filename, y_patch_t *patches, int count);
+int   y_data_update_bank(const char *filename, int index, y_patch_t *patch);
+int   y_data_read_bank(const char *filename, y_patch_t **patches, int *count);
+void  y_data_encode_patch(y_patch_t *patch, char *buf);
+const char *y_data_decode_patch(const char *buf, y_patch_t *patch);
 char *y_data_locate_patch_file(const char *origpath, const char *project_dir);
 
 /* in gui_data.c: */
-int  gui_data_write_patch(FILE *file, y_patch_t *patch, int format);
 int  gui_data_save(char *filename, int start, int end, int format,
                    char **message);
 int  gui_data_save_dirty_patches_to_tmp(void);
+int  gui_data_update_tmp_patch(int index);
 void gui_data_check_patches_allocation(int patch_index);
 int  gui_data_load(const char *filename, int position, char **message);
 void gui_data_friendly_patches(void);
@@ -60,8 +95,10 @@ extern int       y_friendly_patch_count;
 extern y_patch_t y_friendly_patches[];
 
 /* in whysynth_data.c: */
+void  y_data_free_patches(y_synth_t *synth);
 void  y_data_friendly_patches(y_synth_t *synth);
 char *y_data_load(y_synth_t *synth, char *filename);
+char *y_data_store_patch(y_synth_t *synth, int index, y_patch_t *patch);
 
 #endif /* _COMMON_DATA_H */
 
@@ -43,37 +43,38 @@
 #include "common_data.h"
 #include "sampleset.h"
 #include "effects.h"
+#include "arena.h"
 
 /*
  * y_synth_clear_held_keys
  */
 static inline void
-y_synth_clear_held_keys(y_synth_t *synth)
+y_synth_clear_held_keys(y_part_t *part)
 {
     int i;
 
-    for (i = 0; i < 8; i++) synth->held_keys[i] = -1;
+    for (i = 0; i < 8; i++) part->held_keys[i] = -1;
 }
 
 /*
  * y_voice_remove_held_key
  */
 static inline void
-y_voice_remove_held_key(y_synth_t *synth, unsigned char key)
+y_voice_remove_held_key(y_part_t *part, unsigned char key)
 {
     int i;
 
     /* check if this key is in list of held keys; if so, remove it and
      * shift the other keys up */
     for (i = 7; i >= 0; i--) {
-        if (synth->held_keys[i] == key)
+        if (part->held_keys[i] == key)
             break;
     }
     if (i >= 0) {
         for (; i < 7; i++) {
-            synth->held_keys[i] = synth->held_keys[i + 1];
+            part->held_keys[i] = part->held_keys[i + 1];
         }
-        synth->held_keys[7] = -1;
+        part->held_keys[7] = -1;
     }
 }
 
@@ -84,17 +85,33 @@ y_voice_remove_held_key(y_synth_t *synth, unsigned char key)
  */
 void
 y_synth_all_voices_off(y_synth_t *synth)
+{
+    int i;
+
+    while (synth->active_voices)
+        y_voice_off(synth, synth->active_voice[synth->active_voices - 1]);
+    for (i = 0; i < synth->parts; i++)
+        y_synth_clear_held_keys(synth->part[i]);
+}
+
+/*
+ * y_synth_part_voices_off
+ *
+ * stop processing one part's notes immediately
+ */
+void
+y_synth_part_voices_off(y_synth_t *synth, y_part_t *part)
 {
     int i;
     y_voice_t *voice;
 
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (_PLAYING(voice)) {
+    /* backwards, since y_voice_off() moves the last voice into the gap */
+    for (i = synth->active_voices - 1; i >= 0; i--) {
+        voice = synth->active_voice[i];
+        if (voice->part == part)
             y_voice_off(synth, voice);
-        }
     }
-    y_synth_clear_held_keys(synth);
+    y_synth_clear_held_keys(part);
 }
 
 /*
@@ -103,20 +120,29 @@ y_synth_all_voices_off(y_synth_t *synth)
  * handle a note off message
  */
 void
-y_synth_note_off(y_synth_t *synth, unsigned char key, unsigned char rvelocity)
+y_synth_note_off(y_synth_t *synth, y_part_t *part, unsigned char key,
+                 unsigned char rvelocity)
 {
     int i;
-    y_voice_t *voice;
+    y_voice_t *voice, *next;
 
-    y_voice_remove_held_key(synth, key);
+    y_voice_remove_held_key(part, key);
 
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (synth->monophonic ? (_PLAYING(voice)) :
-                                (_ON(voice) && (voice->key == key))) {
-            YDB_MESSAGE(YDB_NOTE, " y_synth_note_off: key %d rvel %d voice %d note id %d\n", key, rvelocity, i, voice->note_id);
+    if (synth->monophonic) {
+        for (i = 0; i < synth->active_voices; i++) {
+            voice = synth->active_voice[i];
+            YDB_MESSAGE(YDB_NOTE, " y_synth_note_off: key %d rvel %d voice %d note id %d\n", key, rvelocity, voice->index, voice->note_id);
             y_voice_note_off(synth, voice, key, rvelocity);
         }
+    } else {
+        /* only the voices on this key need be looked at */
+        for (voice = synth->key_voices[key]; voice; voice = next) {
+            next = voice->key_next;
+            if (_ON(voice) && voice->part == part) {
+                YDB_MESSAGE(YDB_NOTE, " y_synth_note_off: key %d rvel %d voice %d note id %d\n", key, rvelocity, voice->index, voice->note_id);
+                y_voice_note_off(synth, voice, key, rvelocity);
+            }
+        }
     }
 }
 
@@ -126,117 +152,120 @@ y_synth_note_off(y_synth_t *synth, unsigned char key, unsigned char rvelocity)
  * put all notes into the released state
  */
 void
-y_synth_all_notes_off(y_synth_t* synth)
+y_synth_all_notes_off(y_synth_t* synth, y_part_t *part)
 {
     int i;
     y_voice_t *voice;
 
     /* reset the sustain controller */
-    synth->cc[MIDI_CTL_SUSTAIN] = 0;
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (_ON(voice) || _SUSTAINED(voice)) {
+    part->cc[MIDI_CTL_SUSTAIN] = 0;
+    for (i = 0; i < synth->active_voices; i++) {
+        voice = synth->active_voice[i];
+        if ((_ON(voice) || _SUSTAINED(voice)) && voice->part == part) {
             y_voice_release_note(synth, voice);
         }
     }
 }
 
 /*
- * y_synth_free_voice_by_kill
+ * y_synth_voice_prio_is_lower
  *
- * selects a voice for killing. the selection algorithm is a refinement
- * of the algorithm previously in fluid_synth_alloc_voice.
+ * returns true if voice a should be stolen before voice b.  On a tie, the
+ * older voice goes first: we are not enthusiastic about killing voices which
+ * have just been started, otherwise hitting a chord may result in killing
+ * notes belonging to that very same chord.
+ */
+static inline int
+y_synth_voice_prio_is_lower(y_synth_t *synth, int a, int b)
+{
+    if (synth->voice_prio[a] != synth->voice_prio[b])
+        return synth->voice_prio[a] < synth->voice_prio[b];
+    return (synth->note_id - synth->voice[a]->note_id) >
+           (synth->note_id - synth->voice[b]->note_id);
+}
+
+/*
+ * y_synth_kill_lowest_voice
+ *
+ * Turn off the playing voice with the lowest stealing priority (see
+ * Y_VOICE_PRIO_*): released voices before sustained ones, sustained before
+ * held, and within each group, the quietest.  Priorities are updated at
+ * control rate by y_voice_control_update(), which also leaves us the best
+ * candidate, so usually there's nothing to search; only a second kill in
+ * the same control period needs to scan the active list.  Returns the
+ * voice, or NULL if none is playing.
  */
 static y_voice_t*
-y_synth_free_voice_by_kill(y_synth_t *synth)
+y_synth_kill_lowest_voice(y_synth_t *synth)
 {
     int i;
-    int best_prio = 10001;
-    int this_voice_prio;
+    int best_voice_index = synth->steal_candidate;
     y_voice_t *voice;
-    int best_voice_index = -1;
 
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-    
-        /* safeguard against an available voice. */
-        if (_AVAILABLE(voice))
-            return voice;
-    
-        /* Determine, how 'important' a voice is.
-         * Start with an arbitrary number */
-        this_voice_prio = 10000;
-
-        if (_RELEASED(voice)) {
-            /* This voice is in the release phase. Consider it much less
-             * important than a voice which is still held. */
-            this_voice_prio -= 2000;
-        } else if (_SUSTAINED(voice)) {
-            /* The sustain pedal is held down, and this voice is still "on"
-             * because of this even though it has received a note off.
-             * Consider it less important than voices which have not yet
-             * received a note off. This decision is somewhat subjective, but
-             * usually the sustain pedal is used to play 'more-voices-than-
-             * fingers', and if so, it won't hurt as much to kill one of those
-             * voices. */
-             this_voice_prio -= 1000;
-        };
-
-        /* We are not enthusiastic about releasing voices, which have just been
-         * started.  Otherwise hitting a chord may result in killing notes
-         * belonging to that very same chord.  So subtract the age of the voice
-         * from the priority - an older voice is just a little bit less
-         * important than a younger voice. */
-        this_voice_prio -= (synth->note_id - voice->note_id);
-    
-        /* -FIX- not yet implemented:
-         * /= take a rough estimate of loudness into account. Louder voices are more important. =/
-         * if (voice->volenv_section != FLUID_VOICE_ENVATTACK){
-         *     this_voice_prio += voice->volenv_val*1000.;
-         * };
-         */
+    synth->steal_candidate = -1;
 
-        /* check if this voice has less priority than the previous candidate. */
-        if (this_voice_prio < best_prio)
-            best_voice_index = i,
-            best_prio = this_voice_prio;
-    }
+    if (best_voice_index < 0 || best_voice_index >= synth->voices) {
 
-    if (best_voice_index < 0)
-        return NULL;
+        best_voice_index = -1;
+        for (i = 0; i < synth->active_voices; i++) {
+            voice = synth->active_voice[i];
+
+            /* check if this voice has less priority than the previous candidate. */
+            if (best_voice_index < 0 ||
+                y_synth_voice_prio_is_lower(synth, voice->index, best_voice_index))
+                best_voice_index = voice->index;
+        }
+
+        if (best_voice_index < 0)
+            return NULL;
+    }
 
+    /* y_voice_off() clears the candidate, so it is still playing */
     voice = synth->voice[best_voice_index];
-    YDB_MESSAGE(YDB_NOTE, " y_synth_free_voice_by_kill: no available voices, killing voice %d note id %d\n", best_voice_index, voice->note_id);
+    YDB_MESSAGE(YDB_NOTE, " y_synth_kill_lowest_voice: killing voice %d note id %d\n", best_voice_index, voice->note_id);
     y_voice_off(synth, voice);
     return voice;
 }
 
+/*
+ * y_synth_free_voice_by_kill
+ *
+ * Steal the lowest-priority voice for a new note.  This is only called once
+ * there is no free voice the polyphony governor will let us use, so it
+ * never falls back to one.
+ */
+static y_voice_t*
+y_synth_free_voice_by_kill(y_synth_t *synth)
+{
+    y_voice_t *voice = y_synth_kill_lowest_voice(synth);
+
+    if (voice)
+        synth->telemetry.steals++;
+    return voice;
+}
+
 /*
  * y_synth_alloc_voice
  */
 static y_voice_t *
-y_synth_alloc_voice(y_synth_t* synth, unsigned char key)
+y_synth_alloc_voice(y_synth_t* synth, y_part_t *part, unsigned char key)
 {
-    int i;
     y_voice_t* voice;
 
-    /* If there is another voice on the same key, advance it
+    /* If there is another voice of this part on the same key, advance it
      * to the release phase to keep our CPU usage low. */
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (voice->key == key && (_ON(voice) || _SUSTAINED(voice))) {
+    for (voice = synth->key_voices[key]; voice; voice = voice->key_next) {
+        if ((_ON(voice) || _SUSTAINED(voice)) && voice->part == part) {
             y_voice_release_note(synth, voice);
         }
     }
 
-    /* check if there's an available voice */
-    voice = NULL;
-    for (i = 0; i < synth->voices; i++) {
-        if (_AVAILABLE(synth->voice[i])) {
-            voice = synth->voice[i];
-            break;
-        }
-    }
+    /* check if there's an available voice, and the polyphony governor will
+     * let us use it */
+    if (synth->active_voices < synth->voice_limit)
+        voice = y_synth_find_free_voice(synth);
+    else
+        voice = NULL;
 
     /* No success yet? Then stop a running voice. */
     if (voice == NULL) {
@@ -256,7 +285,8 @@ y_synth_alloc_voice(y_synth_t* synth, unsigned char key)
  * y_synth_note_on
  */
 void
-y_synth_note_on(y_synth_t *synth, unsigned char key, unsigned char velocity)
+y_synth_note_on(y_synth_t *synth, y_part_t *part, unsigned char key,
+                unsigned char velocity)
 {
     y_voice_t* voice;
 
@@ -272,13 +302,14 @@ y_synth_note_on(y_synth_t *synth, unsigned char key, unsigned char velocity)
 
     } else { /* polyphonic mode */
 
-        voice = y_synth_alloc_voice(synth, key);
+        voice = y_synth_alloc_voice(synth, part, key);
         if (voice == NULL)
             return;
 
     }
 
     voice->note_id  = synth->note_id++;
+    voice->part     = part;
 
     y_voice_note_on(synth, voice, key, velocity);
 }
@@ -287,20 +318,18 @@ y_synth_note_on(y_synth_t *synth, unsigned char key, unsigned char velocity)
  * y_synth_key_pressure
  */
 void
-y_synth_key_pressure(y_synth_t *synth, unsigned char key, unsigned char pressure)
+y_synth_key_pressure(y_synth_t *synth, y_part_t *part, unsigned char key,
+                     unsigned char pressure)
 {
-    int i;
     y_voice_t* voice;
 
     /* save it for future voices */
-    synth->key_pressure[key] = pressure;
+    part->key_pressure[key] = pressure;
     
     /* check if any playing voices need updating */
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (_PLAYING(voice) && voice->key == key) {
+    for (voice = synth->key_voices[key]; voice; voice = voice->key_next) {
+        if (voice->part == part)
             y_voice_update_pressure_mod(synth, voice);
-        }
     }
 }
 
@@ -311,14 +340,14 @@ y_synth_key_pressure(y_synth_t *synth, unsigned char key, unsigned char pressure
  * clear the sustain controller.)
  */
 void
-y_synth_damp_voices(y_synth_t* synth)
+y_synth_damp_voices(y_synth_t* synth, y_part_t *part)
 {
     int i;
     y_voice_t* voice;
 
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (_SUSTAINED(voice)) {
+    for (i = 0; i < synth->active_voices; i++) {
+        voice = synth->active_voice[i];
+        if (_SUSTAINED(voice) && voice->part == part) {
             y_voice_release_note(synth, voice);
         }
     }
@@ -328,13 +357,13 @@ y_synth_damp_voices(y_synth_t* synth)
  * y_synth_update_wheel_mod
  */
 void
-y_synth_update_wheel_mod(y_synth_t* synth)
+y_synth_update_wheel_mod(y_part_t *part)
 {
-    synth->mod_wheel = (float)(synth->cc[MIDI_CTL_MSB_MODWHEEL] * 128 +
-                               synth->cc[MIDI_CTL_LSB_MODWHEEL]) / 16256.0f;
-    if (synth->mod_wheel > 1.0f)
-        synth->mod_wheel = 1.0f;
-    synth->mod[Y_MOD_MODWHEEL].next_value = synth->mod_wheel;
+    part->mod_wheel = (float)(part->cc[MIDI_CTL_MSB_MODWHEEL] * 128 +
+                               part->cc[MIDI_CTL_LSB_MODWHEEL]) / 16256.0f;
+    if (part->mod_wheel > 1.0f)
+        part->mod_wheel = 1.0f;
+    part->mod[Y_MOD_MODWHEEL].next_value = part->mod_wheel;
     /* don't need to check if any playing voices need updating, because it's global */
 }
 
@@ -342,12 +371,12 @@ y_synth_update_wheel_mod(y_synth_t* synth)
  * y_synth_update_volume
  */
 void
-y_synth_update_volume(y_synth_t* synth)
+y_synth_update_volume(y_part_t *part)
 {
-    synth->cc_volume = (float)(synth->cc[MIDI_CTL_MSB_MAIN_VOLUME] * 128 +
-                               synth->cc[MIDI_CTL_LSB_MAIN_VOLUME]) / 16256.0f;
-    if (synth->cc_volume > 1.0f)
-        synth->cc_volume = 1.0f;
+    part->cc_volume = (float)(part->cc[MIDI_CTL_MSB_MAIN_VOLUME] * 128 +
+                               part->cc[MIDI_CTL_LSB_MAIN_VOLUME]) / 16256.0f;
+    if (part->cc_volume > 1.0f)
+        part->cc_volume = 1.0f;
     /* don't need to check if any playing voices need updating, because it's global */
 }
 
@@ -355,15 +384,15 @@ y_synth_update_volume(y_synth_t* synth)
  * y_synth_update_pan
  */
 void
-y_synth_update_pan(y_synth_t* synth)
+y_synth_update_pan(y_part_t *part)
 {
     /* <= 1 hard left, per http://www.midi.org/techspecs/rp36.php */
-    synth->cc_pan = (float)((synth->cc[MIDI_CTL_MSB_PAN] - 1) * 128 +
-                            synth->cc[MIDI_CTL_LSB_PAN]) / 16128.0f;
-    if (synth->cc_pan > 1.0f)
-        synth->cc_pan = 1.0f;
-    else if (synth->cc_pan < 0.0f)
-        synth->cc_pan = 0.0f;
+    part->cc_pan = (float)((part->cc[MIDI_CTL_MSB_PAN] - 1) * 128 +
+                            part->cc[MIDI_CTL_LSB_PAN]) / 16128.0f;
+    if (part->cc_pan > 1.0f)
+        part->cc_pan = 1.0f;
+    else if (part->cc_pan < 0.0f)
+        part->cc_pan = 0.0f;
     /* don't need to check if any playing voices need updating, because it's global */
 }
 
@@ -371,43 +400,44 @@ y_synth_update_pan(y_synth_t* synth)
  * y_synth_control_change
  */
 void
-y_synth_control_change(y_synth_t *synth, unsigned int param, signed int value)
+y_synth_control_change(y_synth_t *synth, y_part_t *part, unsigned int param,
+                       signed int value)
 {
-    synth->cc[param] = value;
+    part->cc[param] = value;
 
     switch (param) {
 
       case MIDI_CTL_MSB_MODWHEEL:
       case MIDI_CTL_LSB_MODWHEEL:
-        y_synth_update_wheel_mod(synth);
+        y_synth_update_wheel_mod(part);
         break;
 
       case MIDI_CTL_MSB_MAIN_VOLUME:
       case MIDI_CTL_LSB_MAIN_VOLUME:
-        y_synth_update_volume(synth);
+        y_synth_update_volume(part);
         break;
 
       case MIDI_CTL_MSB_PAN:
       case MIDI_CTL_LSB_PAN:
-        y_synth_update_pan(synth);
+        y_synth_update_pan(part);
         break;
 
       case MIDI_CTL_SUSTAIN:
         YDB_MESSAGE(YDB_NOTE, " y_synth_control_change: got sustain control of %d\n", value);
         if (value < 64)
-            y_synth_damp_voices(synth);
+            y_synth_damp_voices(synth, part);
         break;
 
       case MIDI_CTL_ALL_SOUNDS_OFF:
-        y_synth_all_voices_off(synth);
+        y_synth_part_voices_off(synth, part);
         break;
 
       case MIDI_CTL_RESET_CONTROLLERS:
-        y_synth_init_controls(synth);
+        y_synth_init_controls(synth, part);
         break;
 
       case MIDI_CTL_ALL_NOTES_OFF:
-        y_synth_all_notes_off(synth);
+        y_synth_all_notes_off(synth, part);
         break;
 
       /* what others should we respond to? */
@@ -429,24 +459,23 @@ y_synth_control_change(y_synth_t *synth, unsigned int param, signed int value)
  * y_synth_channel_pressure
  */
 void
-y_synth_channel_pressure(y_synth_t *synth, signed int pressure)
+y_synth_channel_pressure(y_synth_t *synth, y_part_t *part, signed int pressure)
 {
     int i;
     y_voice_t* voice;
 
     /* save it for future voices */
-    synth->channel_pressure = pressure;
+    part->channel_pressure = pressure;
 
     /* update global modulator */
-    synth->pressure = (float)pressure / 127.0f;
-    synth->mod[Y_MOD_PRESSURE].next_value = synth->pressure;
+    part->pressure = (float)pressure / 127.0f;
+    part->mod[Y_MOD_PRESSURE].next_value = part->pressure;
 
     /* check if any playing voices need updating */
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (_PLAYING(voice)) {
+    for (i = 0; i < synth->active_voices; i++) {
+        voice = synth->active_voice[i];
+        if (voice->part == part)
             y_voice_update_pressure_mod(synth, voice);
-        }
     }
 }
 
@@ -454,15 +483,15 @@ y_synth_channel_pressure(y_synth_t *synth, signed int pressure)
  * y_synth_pitch_bend
  */
 void
-y_synth_pitch_bend(y_synth_t *synth, signed int value)
+y_synth_pitch_bend(y_synth_t *synth, y_part_t *part, signed int value)
 {
-    synth->pitch_wheel = value; /* ALSA pitch bend is already -8192 - 8191 */
+    part->pitch_wheel = value; /* ALSA pitch bend is already -8192 - 8191 */
     /* -FIX- this could probably use the (future) pitch mod LUT (or mabye exp2ap()?): */
     if (value == 0)
-        synth->pitch_bend = 1.0f;
+        part->pitch_bend = 1.0f;
     else {
         if (value == 8191) value = 8192;
-        synth->pitch_bend = exp((float)(value * lrintf(*(synth->bend_range))) /
+        part->pitch_bend = exp((float)(value * lrintf(*(part->bend_range))) /
                                 (float)(8192 * 12) * M_LN2);
     }
     /* don't need to check if any playing voices need updating, because it's global */
@@ -472,37 +501,36 @@ y_synth_pitch_bend(y_synth_t *synth, signed int value)
  * y_synth_init_controls
  */
 void
-y_synth_init_controls(y_synth_t *synth)
+y_synth_init_controls(y_synth_t *synth, y_part_t *part)
 {
     int i;
     y_voice_t* voice;
 
     /* if sustain was on, we need to damp any sustained voices */
-    if (Y_SYNTH_SUSTAINED(synth)) {
-        synth->cc[MIDI_CTL_SUSTAIN] = 0;
-        y_synth_damp_voices(synth);
+    if (Y_PART_SUSTAINED(part)) {
+        part->cc[MIDI_CTL_SUSTAIN] = 0;
+        y_synth_damp_voices(synth, part);
     }
 
     for (i = 0; i < 128; i++) {
-        synth->key_pressure[i] = 0;
-        synth->cc[i] = 0;
+        part->key_pressure[i] = 0;
+        part->cc[i] = 0;
     }
-    synth->channel_pressure = 0;
-    synth->pitch_wheel = 0;
-    synth->cc[7] = 127;                  /* full volume */
-    synth->cc[10] = 64;                  /* dead center */
+    part->channel_pressure = 0;
+    part->pitch_wheel = 0;
+    part->cc[7] = 127;                  /* full volume */
+    part->cc[10] = 64;                  /* dead center */
 
-    y_synth_update_wheel_mod(synth);
-    y_synth_update_volume(synth);
-    y_synth_update_pan(synth);
-    synth->pitch_bend = 1.0f;
+    y_synth_update_wheel_mod(part);
+    y_synth_update_volume(part);
+    y_synth_update_pan(part);
+    part->pitch_bend = 1.0f;
 
     /* check if any playing voices need updating */
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-        if (_PLAYING(voice)) {
+    for (i = 0; i < synth->active_voices; i++) {
+        voice = synth->active_voice[i];
+        if (voice->part == part)
             y_voice_update_pressure_mod(synth, voice);
-        }
     }
 }
 
@@ -515,9 +543,9 @@ y_synth_select_patch(y_synth_t *synth, unsigned long patch)
     if (patch >= synth->patch_count) return;
 
     if (synth->program_cancel)
-        y_synth_all_voices_off(synth);
+        y_synth_part_voices_off(synth, synth->part[0]);
 
-    y_voice_set_ports(synth, &synth->patches[patch]);
+    y_voice_set_ports(synth, synth->part[0], &synth->patches[patch]);
 }
 
 /*
@@ -556,6 +584,8 @@ y_synth_handle_load(y_synth_t *synth, const char *value)
         free(file);
         return rv;
     }
+    if (synth->patches_file) free(synth->patches_file);
+    synth->patches_file = strdup(value);
 
     if (strcmp(file, value)) {
 	rv = dssi_configure_message("warning: patch file '%s' not found, loaded '%s' instead",
@@ -568,6 +598,36 @@ y_synth_handle_load(y_synth_t *synth, const char *value)
     }
 }
 
+/*
+ * y_synth_handle_patch
+ *
+ * Stores a single patch, given as '<program> <encoded patch> <bank file>'.
+ * The GUI sends this, rather than having us load its whole temporary bank
+ * again, after storing an edited patch into that bank file.  The edit is
+ * ignored unless the bank file is the one we last loaded, as it may not
+ * be when a host restores a session in which a different bank was loaded
+ * after the edit.
+ */
+char *
+y_synth_handle_patch(y_synth_t *synth, const char *value)
+{
+    y_patch_t patch;
+    const char *p;
+    char *end;
+    long program = strtol(value, &end, 10);
+
+    if (end == value || *end != ' ' ||
+        !(p = y_data_decode_patch(end + 1, &patch)) || *p != ' ') {
+        return dssi_configure_message("error: patch value not recognized");
+    }
+    if (program < 0 || program > synth->patch_count)
+        return dssi_configure_message("error: patch number out of range");
+    if (!synth->patches_file || strcmp(p + 1, synth->patches_file))
+        return NULL;  /* an edit to a bank we no longer have */
+
+    return y_data_store_patch(synth, program, &patch);
+}
+
 /*
  * y_synth_handle_monophonic
  */
@@ -584,6 +644,9 @@ y_synth_handle_monophonic(y_synth_t *synth, const char *value)
     if (mode == -1) {
         return dssi_configure_message("error: monophonic value not recognized");
     }
+    if (mode != Y_MONO_MODE_OFF && synth->parts > 1) {
+        return dssi_configure_message("error: monophonic modes are not available with more than one part");
+    }
 
     if (mode == Y_MONO_MODE_OFF) {  /* polyphonic mode */
 
@@ -613,12 +676,28 @@ y_synth_handle_polyphony(y_synth_t *synth, const char *value)
     int polyphony = atoi(value);
     int i;
     y_voice_t *voice;
+    y_arena_t *arena;
 
     if (polyphony < 1 || polyphony > Y_MAX_POLYPHONY) {
         return dssi_configure_message("error: polyphony value out of range");
     }
+    if (polyphony > synth->voices_allocated) {
+        /* allocate (and pre-fault) the new voices before taking the lock */
+        i = polyphony - synth->voices_allocated;
+        arena = arena_create(y_voice_block_size(synth->voices_allocated, i));
+        if (!arena)
+            return dssi_configure_message("error: out of memory");
+
+        dssp_voicelist_mutex_lock(synth);
+        y_voice_add_block(synth, arena, i);  /* can't fail, the arena was sized for it */
+        dssp_voicelist_mutex_unlock(synth);
+
+        arena->next = synth->arena->next;  /* freed along with the instance */
+        synth->arena->next = arena;
+    }
     /* set the new limit */
     synth->polyphony = polyphony;
+    synth->voice_limit = polyphony;
 
     if (!synth->monophonic) {
         synth->voices = polyphony;
@@ -627,11 +706,11 @@ y_synth_handle_polyphony(y_synth_t *synth, const char *value)
 
         dssp_voicelist_mutex_lock(synth);
 
-        for (i = polyphony; i < Y_MAX_POLYPHONY; i++) {
+        for (i = polyphony; i < synth->voices_allocated; i++) {
             voice = synth->voice[i];
             if (_PLAYING(voice)) {
-                if (synth->held_keys[0] != -1)
-                    y_synth_clear_held_keys(synth);
+                if (voice->part->held_keys[0] != -1)
+                    y_synth_clear_held_keys(voice->part);
                 y_voice_off(synth, voice);
             }
         }
@@ -642,6 +721,101 @@ y_synth_handle_polyphony(y_synth_t *synth, const char *value)
     return NULL;
 }
 
+/*
+ * y_synth_handle_parts
+ *
+ * Sets the number of parts, from 1 to Y_MAX_PARTS.  With more than one,
+ * the instance is multi-timbral: part n plays MIDI channel n + 1, and
+ * events on other channels are ignored.  All parts share the instance's
+ * voices and its effect.
+ */
+char *
+y_synth_handle_parts(y_synth_t *synth, const char *value)
+{
+    int parts = atoi(value);
+    int i, old_parts = synth->parts;
+    y_voice_t *voice;
+    y_part_t *part;
+
+    if (parts < 1 || parts > Y_MAX_PARTS) {
+        return dssi_configure_message("error: parts value out of range");
+    }
+    if (parts > 1 && synth->monophonic) {
+        return dssi_configure_message("error: more than one part is not available in monophonic modes");
+    }
+    if (parts > 1 && !y_synth_add_parts(synth))
+        return dssi_configure_message("error: out of memory");
+    if (parts > synth->parts_reserved) {
+        if (!sampleset_reserve(4 * (parts - synth->parts_reserved)))
+            return dssi_configure_message("error: out of memory");
+        synth->parts_reserved = parts;
+    }
+
+    dssp_voicelist_mutex_lock(synth);
+
+    /* turn off the voices of any parts going away */
+    for (i = synth->active_voices - 1; i >= 0; i--) {
+        voice = synth->active_voice[i];
+        if (voice->part->index >= parts)
+            y_voice_off(synth, voice);
+    }
+    /* start any new parts with their controllers reset */
+    for (i = old_parts; i < parts; i++) {
+        part = synth->part[i];
+        y_synth_clear_held_keys(part);
+        y_synth_init_controls(synth, part);
+        y_voice_setup_lfo(synth, &part->glfo, &part->glfo_vlfo, 0.0f, 0.0f,
+                          part->mod, &part->mod[Y_GLOBAL_MOD_GLFO]);
+    }
+    synth->parts = parts;
+
+    dssp_voicelist_mutex_unlock(synth);
+
+    for (i = parts; i < old_parts; i++)
+        sampleset_part_release(synth->part[i]);
+
+    return NULL;
+}
+
+/*
+ * y_synth_handle_part_program
+ *
+ * Selects the program for a part other than part 0, whose program is
+ * selected through the usual DSSI select_program().
+ */
+char *
+y_synth_handle_part_program(y_synth_t *synth, int part, const char *value)
+{
+    int program = atoi(value);
+
+    if (part < 1 || part >= Y_MAX_PARTS) {
+        return dssi_configure_message("error: part number out of range");
+    }
+    /* the host may restore this before 'parts' */
+    if (!y_synth_add_parts(synth))
+        return dssi_configure_message("error: out of memory");
+
+    pthread_mutex_lock(&synth->patches_mutex);
+
+    if (program < 0 || program >= synth->patch_count) {
+        pthread_mutex_unlock(&synth->patches_mutex);
+        return dssi_configure_message("error: part%d_program value out of range",
+                                      part + 1);
+    }
+
+    dssp_voicelist_mutex_lock(synth);
+
+    if (synth->program_cancel)
+        y_synth_part_voices_off(synth, synth->part[part]);
+    y_voice_set_ports(synth, synth->part[part], &synth->patches[program]);
+
+    dssp_voicelist_mutex_unlock(synth);
+
+    pthread_mutex_unlock(&synth->patches_mutex);
+
+    return NULL;
+}
+
 /*
  * y_synth_handle_glide
  */
@@ -676,6 +850,116 @@ y_synth_handle_program_cancel(y_synth_t *synth, const char *value)
     return NULL;
 }
 
+/*
+ * y_synth_handle_event_tolerance
+ */
+char *
+y_synth_handle_event_tolerance(y_synth_t *synth, const char *value)
+{
+    int tolerance = atoi(value);
+
+    if (tolerance < 0 || tolerance > Y_CONTROL_PERIOD) {
+        return dssi_configure_message("error: event_tolerance value out of range");
+    }
+
+    synth->event_tolerance = tolerance;
+
+    return NULL;
+}
+
+/*
+ * y_synth_handle_silence_threshold
+ */
+char *
+y_synth_handle_silence_threshold(y_synth_t *synth, const char *value)
+{
+    int db;
+
+    if (!strcmp(value, "off")) {
+        synth->silence_threshold = 0.0f;
+        return NULL;
+    }
+
+    db = atoi(value);
+    if (db < -200 || db > 0) {
+        return dssi_configure_message("error: silence_threshold value out of range");
+    }
+
+    /* convert from dB to a ratio of energies */
+    synth->silence_threshold = powf(10.0f, (float)db / 10.0f);
+
+    return NULL;
+}
+
+/*
+ * y_synth_handle_cpu_budget
+ */
+char *
+y_synth_handle_cpu_budget(y_synth_t *synth, const char *value)
+{
+    int percent;
+
+    if (!strcmp(value, "off")) {
+        synth->cpu_budget = 0.0f;
+        synth->voice_limit = synth->polyphony;
+        return NULL;
+    }
+
+    percent = atoi(value);
+    if (percent < 1 || percent > 100) {
+        return dssi_configure_message("error: cpu_budget value out of range");
+    }
+
+    synth->cpu_budget = (float)percent / 100.0f;
+
+    return NULL;
+}
+
+/*
+ * y_synth_handle_telemetry
+ *
+ * 'reset' asks the audio thread to clear the telemetry; any other value
+ * returns a report of it.
+ */
+char *
+y_synth_handle_telemetry(y_synth_t *synth, const char *value)
+{
+    struct y_telemetry *t = &synth->telemetry;
+    char buffer[1024];
+    int i, n;
+
+    if (!strcmp(value, "reset")) {
+        synth->telemetry_reset = 1;
+        return NULL;
+    }
+
+    n = snprintf(buffer, sizeof(buffer),
+                 "runs %lu overruns %lu max_load %.3f load %.3f voices %d limit %d\n",
+                 t->runs, t->overruns, t->max_load, synth->cpu_load,
+                 synth->active_voices, synth->voice_limit);
+    n += snprintf(buffer + n, sizeof(buffer) - n, "load_histogram");
+    for (i = 0; i < Y_TELEMETRY_LOAD_BUCKETS; i++)
+        n += snprintf(buffer + n, sizeof(buffer) - n, " %lu", t->run_load[i]);
+    n += snprintf(buffer + n, sizeof(buffer) - n, "\nburst_histogram");
+    for (i = 0; i < Y_TELEMETRY_BURST_BUCKETS; i++)
+        n += snprintf(buffer + n, sizeof(buffer) - n, " %lu", t->burst_time[i]);
+    n += snprintf(buffer + n, sizeof(buffer) - n, "\nvoice_histogram");
+    for (i = 0; i < Y_TELEMETRY_VOICE_BUCKETS; i++)
+        n += snprintf(buffer + n, sizeof(buffer) - n, " %lu", t->active_voices[i]);
+    snprintf(buffer + n, sizeof(buffer) - n,
+             "\nsteals %lu trylock_failures %lu sampleset_busy %lu sampleset_not_ready %lu"
+             " culled %lu governed %lu idle_runs %lu",
+             t->steals, t->trylock_failures, t->sampleset_busy,
+             t->sampleset_not_ready, t->voices_culled, t->voices_governed,
+             t->idle_runs);
+#ifdef Y_DEBUG
+    n = strlen(buffer);
+    snprintf(buffer + n, sizeof(buffer) - n, "\ndenormals %lu", t->denormals);
+#endif
+
+    return strdup(buffer);
+}
+
 /*
  * y_synth_handle_project_dir
  */
@@ -688,69 +972,383 @@ y_synth_handle_project_dir(y_synth_t *synth, const char *value)
     return NULL;
 }
 
+/*
+ * y_effect_bus_lock
+ *
+ * The shared effect bus is touched only briefly, to add a send to it or
+ * to take a block of it, so a spinlock will do even if the host runs
+ * instances in several threads.
+ */
+static inline void
+y_effect_bus_lock(void)
+{
+    while (__sync_lock_test_and_set(&global.effect_bus_lock, 1))
+        ;
+}
+
+static inline void
+y_effect_bus_unlock(void)
+{
+    __sync_lock_release(&global.effect_bus_lock);
+}
+
+/*
+ * y_synth_handle_effect_bus
+ *
+ * Sets the instance's role on the shared effect bus: 'off', 'send', or
+ * 'return'.  Only one instance may be the return.  An instance in the send
+ * role runs no effect of its own.
+ */
+char *
+y_synth_handle_effect_bus(y_synth_t *synth, const char *value)
+{
+    int role, old_role = synth->effect_bus;
+
+    if (!strcmp(value, "off"))         role = Y_EFFECT_BUS_OFF;
+    else if (!strcmp(value, "send"))   role = Y_EFFECT_BUS_SEND;
+    else if (!strcmp(value, "return")) role = Y_EFFECT_BUS_RETURN;
+    else
+        return dssi_configure_message("error: effect_bus value not recognized");
+
+    if (role == old_role)
+        return NULL;
+
+    if (role == Y_EFFECT_BUS_RETURN && !synth->effect_return_l) {
+        y_arena_t *arena = arena_create(2 * arena_round(Y_EFFECT_BUS_LENGTH * sizeof(LADSPA_Data)));
+
+        if (!arena)
+            return dssi_configure_message("error: out of memory");
+        synth->effect_return_l = (LADSPA_Data *)arena_alloc(arena, Y_EFFECT_BUS_LENGTH * sizeof(LADSPA_Data));
+        synth->effect_return_r = (LADSPA_Data *)arena_alloc(arena, Y_EFFECT_BUS_LENGTH * sizeof(LADSPA_Data));
+        arena->next = synth->arena->next;  /* freed along with the instance */
+        synth->arena->next = arena;
+    }
+
+    if (role == Y_EFFECT_BUS_RETURN) {
+        if (!__sync_bool_compare_and_swap(&global.effect_bus_return, NULL, synth))
+            return dssi_configure_message("error: another instance is already the effect bus return");
+        /* clear whatever was sent while there was no return */
+        y_effect_bus_lock();
+        memset(global.effect_bus_l, 0, sizeof(global.effect_bus_l));
+        memset(global.effect_bus_r, 0, sizeof(global.effect_bus_r));
+        y_effect_bus_unlock();
+    }
+
+    dssp_voicelist_mutex_lock(synth);
+
+    synth->effect_bus = role;
+    if (old_role == Y_EFFECT_BUS_OFF) {
+        synth->dry_dc_l_xnm1 = synth->dry_dc_l_ynm1 = 0.0f;
+        synth->dry_dc_r_xnm1 = synth->dry_dc_r_ynm1 = 0.0f;
+    }
+    if (role == Y_EFFECT_BUS_SEND) {
+        /* hand the effect's region to the worker thread, and force the
+         * effect to be set up afresh should the instance leave this role */
+        effects_release_region(synth);
+        synth->last_effect_mode = -1;
+        synth->effect_buffer_silence_count = 0;
+        synth->effect_region_pending = 0;
+    }
+
+    dssp_voicelist_mutex_unlock(synth);
+
+    if (old_role == Y_EFFECT_BUS_RETURN)
+        __sync_bool_compare_and_swap(&global.effect_bus_return, synth, NULL);
+
+    return NULL;
+}
+
+/*
+ * y_synth_handle_impulse_response
+ */
+char *
+y_synth_handle_impulse_response(y_synth_t *synth, const char *value)
+{
+    char *file, *rv;
+
+    if (!*value || !strcmp(value, "none"))
+        return effect_convolution_load(synth, NULL);
+
+    if (!(file = y_data_locate_patch_file(value, synth->project_dir))) {
+        return dssi_configure_message("error: could not find impulse response file '%s'",
+                                      value);
+    }
+    rv = effect_convolution_load(synth, file);
+    free(file);
+    return rv;
+}
+
+
+/*
+ * y_synth_record_run
+ *
+ * update the telemetry at the end of a run, given the fraction of the
+ * buffer's duration that the run took
+ */
+void
+y_synth_record_run(y_synth_t *synth, float load)
+{
+    struct y_telemetry *t = &synth->telemetry;
+    int i;
+
+    t->runs++;
+    if (load > 1.0f)
+        t->overruns++;
+    if (load > t->max_load)
+        t->max_load = load;
+    i = (int)(load * 10.0f);
+    if (i >= Y_TELEMETRY_LOAD_BUCKETS) i = Y_TELEMETRY_LOAD_BUCKETS - 1;
+    t->run_load[i]++;
+    i = synth->active_voices * (Y_TELEMETRY_VOICE_BUCKETS - 1) / synth->polyphony;
+    if (i >= Y_TELEMETRY_VOICE_BUCKETS) i = Y_TELEMETRY_VOICE_BUCKETS - 1;
+    t->active_voices[i]++;
+}
+
+/*
+ * y_synth_govern_polyphony
+ *
+ * Called at the end of each run with the fraction of the buffer's duration
+ * that the run took, and the part of that spent rendering voices.  If the
+ * (smoothed) load is over the CPU budget, lower the voice limit so that the
+ * voices' share of the load fits in what the budget leaves after the
+ * effects and other overhead, and kill the lowest-priority voices to get
+ * down to it; once the load has dropped well below the budget, raise the
+ * limit again, one voice per run, back up to the requested polyphony.
+ */
+void
+y_synth_govern_polyphony(y_synth_t *synth, float load, float voice_load)
+{
+    int limit;
+    float share, voice_budget;
+
+    /* track increases in load immediately, decreases slowly */
+    if (load > synth->cpu_load)
+        synth->cpu_load = load;
+    else
+        synth->cpu_load += 0.05f * (load - synth->cpu_load);
+
+    if (synth->cpu_budget == 0.0f || synth->monophonic)
+        return;
+
+    if (synth->cpu_load > synth->cpu_budget) {
+
+        /* split the smoothed load by this run's share spent on voices */
+        share = (load > 0.0f ? voice_load / load : 1.0f);
+        if (share > 1.0f)
+            share = 1.0f;
+        voice_budget = synth->cpu_budget - synth->cpu_load * (1.0f - share);
+        if (share > 0.0f && voice_budget > 0.0f)
+            limit = lrintf((float)synth->active_voices * voice_budget /
+                           (synth->cpu_load * share) - 0.5f);
+        else
+            limit = 0;
+        /* if the voices aren't what is costing us, shedding them all
+         * won't help */
+        if (limit < Y_GOVERNOR_MIN_VOICES)
+            limit = Y_GOVERNOR_MIN_VOICES;
+        if (limit < synth->voice_limit) {
+            YDB_MESSAGE(YDB_NOTE, " y_synth_govern_polyphony: load %f (voices %f), voice limit %d -> %d\n", synth->cpu_load, share, synth->voice_limit, limit);
+            synth->voice_limit = limit;
+        }
+
+        while (synth->active_voices > synth->voice_limit &&
+               y_synth_kill_lowest_voice(synth))
+            synth->telemetry.voices_governed++;
+        /* don't let the killed voices' load count against the new limit */
+        synth->cpu_load = synth->cpu_budget;
+
+    } else if (synth->cpu_load < synth->cpu_budget * Y_GOVERNOR_RECOVERY &&
+               synth->voice_limit < synth->polyphony) {
+
+        synth->voice_limit++;
+    }
+}
+
+/*
+ * y_synth_control_update
+ *
+ * called at the top of each control period, before any events for that tick
+ * are handled, to do the once-per-period global and voice modulator updates
+ */
+void
+y_synth_control_update(y_synth_t *synth)
+{
+    int i, best = -1;
+    y_voice_t* voice;
+    y_part_t *part;
+
+    /* the voices' summed energy over the last control period, held at its
+     * recent peak, is the level against which voices are culled */
+    synth->mix_level *= synth->mix_level_fall;
+    if (synth->mix_level < synth->mix_level_next)
+        synth->mix_level = synth->mix_level_next;
+    synth->mix_level_next = 0.0f;
+
+    for (i = 0; i < synth->parts; i++) {
+        part = synth->part[i];
+        part->mod[Y_MOD_MODWHEEL].value = part->mod[Y_MOD_MODWHEEL].next_value;
+        part->mod[Y_MOD_PRESSURE].value = part->mod[Y_MOD_PRESSURE].next_value;
+        y_voice_update_lfo(synth, &part->glfo, &part->glfo_vlfo,
+                           part->mod, &part->mod[Y_GLOBAL_MOD_GLFO]);
+    }
+
+    /* backwards, since a voice found finished is replaced in the active list
+     * by the last one, which has already been updated */
+    for (i = synth->active_voices - 1; i >= 0; i--) {
+        voice = synth->active_voice[i];
+        y_voice_control_update(synth, voice);
+        /* keep track of which voice to steal next */
+        if (_PLAYING(voice) &&
+            (best < 0 || y_synth_voice_prio_is_lower(synth, voice->index, best)))
+            best = voice->index;
+    }
+    synth->steal_candidate = best;
+}
 
 /*
  * y_synth_render_voices
+ *
+ * Renders one burst of all playing voices into the given slice of the
+ * pre-effect voice bus.
  */
 void
 y_synth_render_voices(y_synth_t *synth,
-                      LADSPA_Data *out_left, LADSPA_Data *out_right,
-                      unsigned long sample_count, int do_control_update)
+                      LADSPA_Data *bus_left, LADSPA_Data *bus_right,
+                      unsigned long sample_count)
 {
     unsigned long i;
-    y_voice_t* voice;
+    int p, v;
+    y_part_t *part;
 
     /* check for sampleset (non-realtime-rendered) resource changes */
     sampleset_check_oscillators(synth);
 
-    /* silence the pre-effect buffer */
+    /* silence this slice of the pre-effect buffer */
     for (i = 0; i < sample_count; i++)
-        synth->voice_bus_l[i] = synth->voice_bus_r[i] = 0.0f;
+        bus_left[i] = bus_right[i] = 0.0f;
+
+    /* pre-render global modulator updates: ramp the controllers from their
+     * current values to reach their targets at the end of this control
+     * period, however the period happens to be divided into bursts */
+    for (p = 0; p < synth->parts; p++) {
+        part = synth->part[p];
+        y_mod_ramp_to_next(&part->mod[Y_MOD_MODWHEEL], synth->control_remains);
+        y_mod_ramp_to_next(&part->mod[Y_MOD_PRESSURE], synth->control_remains);
+    }
 
-#if defined(Y_DEBUG) && (Y_DEBUG & YDB_AUDIO)
-out_left[0]  += 0.10f; /* add a 'buzz' to output so there's something audible even when quiescent */
-out_right[0] += 0.10f;
-#endif /* defined(Y_DEBUG) && (Y_DEBUG & YDB_AUDIO) */
+    /* render each active voice, backwards for the same reason as in
+     * y_synth_control_update() */
+    for (v = synth->active_voices - 1; v >= 0; v--)
+        y_voice_render(synth, synth->active_voice[v], bus_left, bus_right, sample_count);
 
-    /* pre-render global modulator updates */
-    if (fabsf(synth->mod[Y_MOD_MODWHEEL].next_value - synth->mod[Y_MOD_MODWHEEL].value) > 1e-10) {
-        synth->mod[Y_MOD_MODWHEEL].delta =
-           (synth->mod[Y_MOD_MODWHEEL].next_value - synth->mod[Y_MOD_MODWHEEL].value) /
-               (float)Y_CONTROL_PERIOD;
-    }
-    if (fabsf(synth->mod[Y_MOD_PRESSURE].next_value - synth->mod[Y_MOD_PRESSURE].value) > 1e-10) {
-        synth->mod[Y_MOD_PRESSURE].delta =
-           (synth->mod[Y_MOD_PRESSURE].next_value - synth->mod[Y_MOD_PRESSURE].value) /
-               (float)Y_CONTROL_PERIOD;
+    /* post-render global modulator updates */
+    for (p = 0; p < synth->parts; p++) {
+        part = synth->part[p];
+        for (i = 1; i < Y_GLOBAL_MODS_COUNT; i++)
+            part->mod[i].value += (float)sample_count * part->mod[i].delta;
     }
+}
 
-    /* render each active voice */
-    for (i = 0; i < synth->voices; i++) {
-        voice = synth->voice[i];
-    
-        if (_PLAYING(voice)) {
-            y_voice_render(synth, voice, synth->voice_bus_l, synth->voice_bus_r,
-                           sample_count, do_control_update);
+/*
+ * y_synth_process_effect_bus
+ *
+ * Effect processing for an instance in the send or return role.  The
+ * instance outputs its DC-blocked dry signal scaled by one minus its effect
+ * mix, and adds its voice bus, scaled by the mix, to the shared effect bus
+ * at the same position within the buffer.  The return instance then takes
+ * that block of the bus, runs its effect on it fully wet, and adds the
+ * result to its output.  Sends from instances the host runs after the
+ * return instance are heard one buffer later; y_run_multiple_synths()
+ * runs the return instance last, so there they are all heard at once.
+ */
+void
+y_synth_process_effect_bus(y_synth_t *synth, unsigned long offset,
+                           LADSPA_Data *out_left, LADSPA_Data *out_right,
+                           unsigned long sample_count)
+{
+    static LADSPA_Data full_wet = 1.0f;
+    float *bus_l = global.effect_bus_l + (offset & Y_SHARED_BUS_MASK),
+          *bus_r = global.effect_bus_r + (offset & Y_SHARED_BUS_MASK);
+    float r = synth->dc_block_r,
+          l_xnm1 = synth->dry_dc_l_xnm1,
+          l_ynm1 = synth->dry_dc_l_ynm1,
+          r_xnm1 = synth->dry_dc_r_xnm1,
+          r_ynm1 = synth->dry_dc_r_ynm1;
+    float mix0, mix, mix_delta;
+    LADSPA_Data *mix_port;
+    unsigned long i;
+
+    mix0 = effects_mix_ramp(synth, sample_count, &mix_delta);
+
+    /* dry output */
+    for (mix = mix0, i = 0; i < sample_count; i++) {
+        mix += mix_delta;
+        l_ynm1 = synth->voice_bus_l[i] - l_xnm1 + r * l_ynm1;
+        l_xnm1 = synth->voice_bus_l[i];
+        out_left[i] = (1.0f - mix) * l_ynm1;
+        r_ynm1 = synth->voice_bus_r[i] - r_xnm1 + r * r_ynm1;
+        r_xnm1 = synth->voice_bus_r[i];
+        out_right[i] = (1.0f - mix) * r_ynm1;
+    }
+    synth->dry_dc_l_xnm1 = l_xnm1;
+    synth->dry_dc_l_ynm1 = l_ynm1;
+    synth->dry_dc_r_xnm1 = r_xnm1;
+    synth->dry_dc_r_ynm1 = r_ynm1;
+
+    /* send, unless there is no return to hear it */
+    if (global.effect_bus_return) {
+        y_effect_bus_lock();
+        for (mix = mix0, i = 0; i < sample_count; i++) {
+            mix += mix_delta;
+            bus_l[i] += mix * synth->voice_bus_l[i];
+            bus_r[i] += mix * synth->voice_bus_r[i];
         }
+        y_effect_bus_unlock();
     }
 
-    /* post-render global modulator updates */
-    if (do_control_update) {
-        synth->mod[Y_MOD_MODWHEEL].value += (float)sample_count * synth->mod[Y_MOD_MODWHEEL].delta;
-        synth->mod[Y_MOD_PRESSURE].value += (float)sample_count * synth->mod[Y_MOD_PRESSURE].delta;
-        y_voice_update_lfo(synth, &synth->glfo, &synth->glfo_vlfo,
-                           synth->mod, &synth->mod[Y_GLOBAL_MOD_GLFO]);
-    } else {
-        /* update modulator values for the incomplete control cycle */
-        for (i = 1; i < Y_GLOBAL_MODS_COUNT; i++)
-            synth->mod[i].value += (float)sample_count * synth->mod[i].delta;
+    if (synth->effect_bus != Y_EFFECT_BUS_RETURN)
+        return;
+
+    /* take this block of the bus */
+    y_effect_bus_lock();
+    for (i = 0; i < sample_count; i++) {
+        synth->voice_bus_l[i] = bus_l[i];
+        synth->voice_bus_r[i] = bus_r[i];
+        bus_l[i] = bus_r[i] = 0.0f;
+    }
+    y_effect_bus_unlock();
+
+    /* run the effect on it, fully wet, with this instance's mix set aside */
+    mix_port = synth->effect_mix;
+    mix = synth->effect_mix_last;
+    synth->effect_mix = &full_wet;
+    synth->effect_mix_last = 1.0f;
+    y_synth_process_effects(synth, synth->effect_return_l, synth->effect_return_r,
+                            sample_count);
+    synth->effect_mix = mix_port;
+    synth->effect_mix_last = mix;
+
+    for (i = 0; i < sample_count; i++) {
+        out_left[i]  += synth->effect_return_l[i];
+        out_right[i] += synth->effect_return_r[i];
     }
+}
+
+/*
+ * y_synth_process_effects
+ *
+ * Runs the effects over the first sample_count samples of the voice bus,
+ * writing the result to out_left and out_right.  This is called once per
+ * filled voice bus rather than once per render burst, so the effects see
+ * blocks as long as the host's buffer (up to Y_EFFECT_BUS_LENGTH).
+ */
+void
+y_synth_process_effects(y_synth_t *synth,
+                        LADSPA_Data *out_left, LADSPA_Data *out_right,
+                        unsigned long sample_count)
+{
+    unsigned long i;
 
-    /* effect processing */
-    synth->voice_bus_l[0] += 1e-20f; /* ''' bubbling of the quantum foam ,,, */
-    synth->voice_bus_r[0] += 1e-20f;
-    synth->voice_bus_l[sample_count >> 1] -= 1e-20f;
-    synth->voice_bus_r[sample_count >> 1] -= 1e-20f;
     if (lrintf(*(synth->effect_mode)) == 0) {  /* 'Off', or DC-filter only */
         float r = synth->dc_block_r,
               l_xnm1 = synth->dc_block_l_xnm1,
@@ -770,8 +1368,16 @@ out_right[0] += 0.10f;
         synth->dc_block_r_xnm1 = r_xnm1;
         synth->dc_block_r_ynm1 = r_ynm1;
 
-        synth->last_effect_mode = 0;
+        if (synth->last_effect_mode != 0) {
+            effects_release_region(synth);
+            synth->last_effect_mode = 0;
+        }
     } else
         effects_process(synth, sample_count, out_left, out_right);  /* other effects */
+
+#if defined(Y_DEBUG) && (Y_DEBUG & YDB_AUDIO)
+out_left[0]  += 0.10f; /* add a 'buzz' to output so there's something audible even when quiescent */
+out_right[0] += 0.10f;
+#endif /* defined(Y_DEBUG) && (Y_DEBUG & YDB_AUDIO) */
 }
 
@@ -27,6 +27,7 @@
 #define _DSSP_EVENT_H
 
 #include <stdlib.h>
+#include <strings.h>
 #include <pthread.h>
 
 #include <ladspa.h>
@@ -47,6 +48,78 @@
 #define Y_GLIDE_MODE_LEFTOVER 3
 #define Y_GLIDE_MODE_OFF      4
 
+/* number of words in the free voice bitmap */
+#define Y_VOICE_MAP_WORDS  ((Y_MAX_POLYPHONY + 31) / 32)
+
+/* voice-stealing priority: a voice's current amplitude (0 to 1) plus a bias
+ * for its state, so released voices are stolen before sustained ones, and
+ * sustained before held ones; the lowest priority voice is stolen first */
+#define Y_VOICE_PRIO_RELEASED   0.0f
+#define Y_VOICE_PRIO_SUSTAINED  2.0f
+#define Y_VOICE_PRIO_ON         4.0f
+
+/* how many samples early a controller, pressure or pitch bend event may be
+ * applied, so that it can be folded into the current render burst instead of
+ * splitting it (0 to Y_CONTROL_PERIOD) */
+#define Y_DEFAULT_EVENT_TOLERANCE  Y_CONTROL_PERIOD
+
+/* the voice culling reference level, the loudest the instance's voices
+ * have recently been, falls by this many dB per second */
+#define Y_MIX_LEVEL_FALL  20.0f
+
+/* level, in dBFS, below which the output of an instance with no voices
+ * playing counts as silence for idle detection */
+#define Y_IDLE_THRESHOLD  -90
+
+/* Where y_run_synth() has no way to have the FPU flush denormals to zero,
+ * tiny signals are injected into the oscillator and voice buses instead, to
+ * keep the filter and effect states from decaying into denormals. */
+#if !defined(__SSE__) && !defined(__aarch64__)
+#define Y_DENORMAL_NOISE
+#endif
+
+/* the polyphony governor lets the voice limit back up once the CPU load has
+ * fallen to this fraction of the budget */
+#define Y_GOVERNOR_RECOVERY  0.7f
+
+/* the polyphony governor never lowers the voice limit below this */
+#define Y_GOVERNOR_MIN_VOICES  4
+
+/* how long, in seconds, an instance's output must stay below the idle
+ * threshold with no voices playing before it goes idle; this must be longer
+ * than the longest dual delay time, or an echo still in flight would be lost */
+#define Y_IDLE_HOLD_TIME  2.5f
+
+/* length of the pre-effect voice bus: voices are rendered into it burst by
+ * burst, and the effects then run once over the whole of it, so this is the
+ * longest block the effects ever see.  Host buffers longer than this are
+ * processed in pieces of this size. */
+#define Y_EFFECT_BUS_LENGTH  1024
+
+/* shared effect bus roles */
+#define Y_EFFECT_BUS_OFF     0  /* the instance runs its own effect */
+#define Y_EFFECT_BUS_SEND    1  /* sends to the shared bus, outputs only its dry signal */
+#define Y_EFFECT_BUS_RETURN  2  /* as SEND, plus runs its effect on the bus and outputs the result */
+
+/* length of the shared effect bus; a power of two, and a multiple of
+ * Y_EFFECT_BUS_LENGTH, so that no effect block straddles its end */
+#define Y_SHARED_BUS_LENGTH  4096
+#define Y_SHARED_BUS_MASK    (Y_SHARED_BUS_LENGTH - 1)
+
+/* effect buffer region states; see effects.c */
+#define Y_EFFECT_REGION_CLEAN     0  /* silenced, ready for the effect to start */
+#define Y_EFFECT_REGION_IN_USE    1  /* the effect is running in it */
+#define Y_EFFECT_REGION_DIRTY     2  /* left by the effect, waiting for the worker thread */
+#define Y_EFFECT_REGION_CLEARING  3  /* being silenced by the worker thread */
+
+struct y_effect_region
+{
+    size_t          start,    /* offset of the region within effect_buffer */
+                    silence,  /* offset of the part that must be silenced before reuse */
+                    end;      /* offset just past the region */
+    volatile int    state;    /* Y_EFFECT_REGION_* */
+};
+
 /* -PORTS- */
 struct _y_sosc_t
 {
@@ -101,42 +174,19 @@ struct _y_seg_t
 };
 
 /*
- * y_synth_t
+ * y_part_t
+ *
+ * One part of a (possibly multi-timbral) instance: a patch, and the state
+ * of the MIDI channel that plays it.  Part 0's patch parameters are the
+ * instance's LADSPA ports; the other parts keep theirs in port_value[],
+ * set by the 'partN_program' configure keys.
  */
-struct _y_synth_t {
-    /* output */
-    LADSPA_Data    *output_left;
-    LADSPA_Data    *output_right;
-
-    float           sample_rate;
-    float           deltat;            /* 1 / sample_rate */
-    float           control_rate;
-    unsigned long   control_remains;
+struct _y_part_t {
+    int             index;             /* this part's position in synth->part[] */
 
-    /* voice tracking and data */
-    unsigned int    note_id;           /* incremented for every new note, used for voice-stealing prioritization */
-    int             polyphony;         /* requested polyphony, must be <= Y_MAX_POLYPHONY */
-    int             voices;            /* current polyphony, either requested polyphony above or 1 while in monophonic mode */
-    int             monophonic;        /* true if operating in monophonic mode */
-    int             glide;             /* current glide mode */
+    /* note tracking */
     float           last_noteon_pitch; /* glide start pitch for non-legato modes */
     signed char     held_keys[8];      /* for monophonic key tracking, an array of note-ons, most recently received first */
-    
-    pthread_mutex_t voicelist_mutex;
-    int             voicelist_mutex_grab_failed;
-
-    y_voice_t      *voice[Y_MAX_POLYPHONY];
-
-    pthread_mutex_t patches_mutex;
-    unsigned int    patch_count;
-    unsigned int    patches_allocated;
-    y_patch_t      *patches;
-    int             pending_patch_change;
-    int             program_cancel;    /* if true, cancel any playing notes on recept of program change */
-    char           *project_dir;
-
-    grain_t        *grains;                   /* array of all grains */
-    grain_t        *free_grain_list;          /* list of available grains */
 
     /* current non-LADSPA-port-mapped controller values */
     unsigned char   key_pressure[128];
@@ -171,14 +221,6 @@ struct _y_synth_t {
     LADSPA_Data    *vcf2_level;
     LADSPA_Data    *vcf2_pan;
     LADSPA_Data    *volume;
-    LADSPA_Data    *effect_mode;
-    LADSPA_Data    *effect_param1;
-    LADSPA_Data    *effect_param2;
-    LADSPA_Data    *effect_param3;
-    LADSPA_Data    *effect_param4;
-    LADSPA_Data    *effect_param5;
-    LADSPA_Data    *effect_param6;
-    LADSPA_Data    *effect_mix;
     LADSPA_Data    *glide_time;
     LADSPA_Data    *bend_range;
     y_slfo_t        glfo,
@@ -196,6 +238,124 @@ struct _y_synth_t {
     LADSPA_Data    *modmix_mod1_amt;
     LADSPA_Data    *modmix_mod2_src;
     LADSPA_Data    *modmix_mod2_amt;
+
+    LADSPA_Data     port_value[Y_PORTS_COUNT];  /* what the above point to, for parts other than part 0 */
+};
+
+/*
+ * y_telemetry
+ *
+ * Statistics about the realtime behavior of an instance.  These are only
+ * ever written by the audio thread, so no locking is needed; readers may
+ * see a slightly stale or inconsistent set.
+ */
+#define Y_TELEMETRY_LOAD_BUCKETS   12  /* run time, in tenths of buffer duration; last is >= 110% */
+#define Y_TELEMETRY_BURST_BUCKETS  16  /* burst render time: < 1us, then powers of two microseconds */
+#define Y_TELEMETRY_VOICE_BUCKETS  17  /* active voices, in sixteenths of the polyphony */
+
+struct y_telemetry
+{
+    unsigned long   runs;
+    unsigned long   overruns;          /* runs taking longer than the buffer duration */
+    float           max_load;          /* longest run, as a fraction of buffer duration */
+    unsigned long   run_load[Y_TELEMETRY_LOAD_BUCKETS];
+    unsigned long   burst_time[Y_TELEMETRY_BURST_BUCKETS];
+    unsigned long   active_voices[Y_TELEMETRY_VOICE_BUCKETS];
+    unsigned long   steals;            /* voices killed to make room for a new note */
+    unsigned long   trylock_failures;  /* runs output as silence because the voice list was locked */
+    unsigned long   sampleset_busy;    /* sampleset changes deferred because the sampleset mutex was locked */
+    unsigned long   sampleset_not_ready; /* oscillator bursts rendered while waiting for a sampleset */
+    unsigned long   voices_culled;     /* voices turned off for falling below silence_threshold */
+    unsigned long   voices_governed;   /* voices killed to meet the CPU budget */
+    unsigned long   idle_runs;         /* runs skipped entirely because the instance was idle */
+#ifdef Y_DEBUG
+    unsigned long   denormals;         /* denormal output samples seen despite flush-to-zero */
+#endif
+};
+
+/*
+ * y_synth_t
+ */
+struct _y_synth_t {
+    /* output */
+    LADSPA_Data    *output_left;
+    LADSPA_Data    *output_right;
+
+    float           sample_rate;
+    float           deltat;            /* 1 / sample_rate */
+    float           control_rate;
+    unsigned long   control_remains;
+
+    /* voice tracking and data */
+    unsigned int    note_id;           /* incremented for every new note, used for voice-stealing prioritization */
+    int             polyphony;         /* requested polyphony, must be <= Y_MAX_POLYPHONY */
+    int             voices;            /* current polyphony, either requested polyphony above or 1 while in monophonic mode */
+    int             monophonic;        /* true if operating in monophonic mode */
+    int             glide;             /* current glide mode */
+
+    pthread_mutex_t voicelist_mutex;
+    int             voicelist_mutex_grab_failed;
+
+    y_arena_t      *arena;             /* holds this struct and all other realtime state */
+    y_voice_t      *voice[Y_MAX_POLYPHONY];
+    int             voices_allocated;  /* voice[] entries allocated so far, >= polyphony */
+    struct y_voice_bus *free_voice_bus[Y_MAX_POLYPHONY];  /* stack of unused oscillator bus sets */
+    int             free_voice_bus_count;
+    int             active_voices;     /* count of voices not Y_VOICE_OFF */
+    y_voice_t      *active_voice[Y_MAX_POLYPHONY];  /* the playing voices, in no particular order */
+    y_voice_t      *key_voices[128];   /* per key, list of the playing voices on that key */
+    unsigned int    voice_free_map[Y_VOICE_MAP_WORDS];  /* bit set for each Y_VOICE_OFF voice */
+    float           voice_prio[Y_MAX_POLYPHONY];  /* voice-stealing priority, updated at control rate */
+    int             steal_candidate;   /* lowest-priority playing voice at last control update, or -1 */
+    float           silence_threshold; /* voice culling threshold, as a ratio to mix_level, or 0 for off */
+    float           mix_level;         /* recent peak of the voices' summed energy per control period */
+    float           mix_level_next;    /*   accumulating over the current control period */
+    float           mix_level_fall;    /*   factor by which it falls each control period */
+    float           cpu_budget;        /* fraction of each buffer's duration y_run_synth() may use, or 0 for no governor */
+    float           cpu_load;          /* smoothed fraction of the buffer duration actually used */
+    int             voice_limit;       /* polyphony limit imposed by the governor, <= polyphony */
+
+    /* idle detection */
+    int             idle;              /* true while rendering is being skipped */
+    unsigned long   idle_samples;      /* samples of silent output with no voices playing */
+    unsigned long   idle_hold;         /* idle_samples needed before going idle */
+    float           idle_threshold;    /* Y_IDLE_THRESHOLD, as a mean square output level */
+    LADSPA_Data    *port[Y_PORTS_COUNT];             /* every port connection, by port number */
+    float           idle_port_value[Y_PORTS_COUNT];  /* control port values when we went idle */
+
+    /* realtime telemetry */
+    struct y_telemetry telemetry;
+    volatile int    telemetry_reset;   /* set by y_configure() to ask the audio thread to reset telemetry */
+
+    pthread_mutex_t patches_mutex;
+    unsigned int    patch_count;
+    unsigned int    patches_allocated;
+    y_patch_t      *patches;
+    char           *patches_file;      /* the bank file last loaded by 'load', if any */
+    int             pending_patch_change;
+    int             program_cancel;    /* if true, cancel any playing notes on recept of program change */
+    unsigned long   event_tolerance;   /* controller event coalescing tolerance, in samples */
+    char           *project_dir;
+
+    grain_t        *free_grain_list;          /* list of available grains */
+
+    /* parts: part[0] plays the patch on the LADSPA ports; in multi-timbral
+     * mode, part[n] plays MIDI channel n + 1.  Part 0 is first_part; the
+     * rest are NULL until y_synth_add_parts() first allocates them. */
+    int             parts;                    /* parts in use, 1 to Y_MAX_PARTS */
+    int             parts_reserved;           /* most parts ever in use, for sampleset reservation */
+    y_part_t       *part[Y_MAX_PARTS];
+    y_part_t        first_part;
+
+    /* LADSPA ports which are not per-part */
+    LADSPA_Data    *effect_mode;
+    LADSPA_Data    *effect_param1;
+    LADSPA_Data    *effect_param2;
+    LADSPA_Data    *effect_param3;
+    LADSPA_Data    *effect_param4;
+    LADSPA_Data    *effect_param5;
+    LADSPA_Data    *effect_param6;
+    LADSPA_Data    *effect_mix;
     LADSPA_Data    *tuning;
 
     /* reusable pre-mixdown voice buffers */
@@ -203,8 +363,14 @@ struct _y_synth_t {
                     vcf2_out[Y_CONTROL_PERIOD];
 
     /* effects */
-    LADSPA_Data     voice_bus_l[Y_CONTROL_PERIOD],  /* pre-effect voice bus */
-                    voice_bus_r[Y_CONTROL_PERIOD];
+    LADSPA_Data     voice_bus_l[Y_EFFECT_BUS_LENGTH],  /* pre-effect voice bus */
+                    voice_bus_r[Y_EFFECT_BUS_LENGTH];
+    LADSPA_Data * volatile adding_bus; /* post-effect output for run_adding, left then right,
+                                        * allocated by the worker thread once run_adding is used */
+    volatile int    adding_bus_wanted; /* set by the audio thread to ask for it */
+    y_arena_t      *adding_arena;    /* its arena, separate from the chain on 'arena' */
+    float           effect_mix_last; /* effect mix at the end of the last effect block */
+    LADSPA_Data     run_adding_gain;
     int             last_effect_mode;
     float           dc_block_r,
                     dc_block_l_xnm1,
@@ -213,8 +379,20 @@ struct _y_synth_t {
                     dc_block_r_ynm1;
     char           *effect_buffer;
     size_t          effect_buffer_allocation;
-    size_t          effect_buffer_highwater;
     size_t          effect_buffer_silence_count;
+    struct y_effect_region
+                    effect_region[Y_EFFECT_MODE_COUNT + 1]; /* each effect's own part of effect_buffer */
+    int             effect_region_pending; /* waiting for the worker thread to finish clearing */
+    y_synth_t      *next_instance;   /* global.instance_list link, under instance_list_mutex */
+    y_convolver_t  *convolver;       /* impulse response for convolution mode, or NULL */
+
+    int             effect_bus;      /* Y_EFFECT_BUS_* role */
+    float           dry_dc_l_xnm1,   /* DC blocker state for the dry signal in the send roles */
+                    dry_dc_l_ynm1,
+                    dry_dc_r_xnm1,
+                    dry_dc_r_ynm1;
+    LADSPA_Data    *effect_return_l, /* shared effect output, allocated when the */
+                   *effect_return_r; /*   instance first takes the return role */
 };
 
 /*
@@ -228,10 +406,13 @@ struct _y_global_t {
     grain_envelope_data_t *grain_envelope;    /* array of grain envelopes */
 
     pthread_mutex_t        sampleset_mutex;
+    pthread_mutex_t        instance_list_mutex; /* never taken by the audio thread */
+    y_synth_t             *instance_list;       /* all instances, for the worker thread */
     int                    sampleset_pipe_fd[2];
     int                    worker_thread_started;
     volatile int           worker_thread_done;
     pthread_t              worker_thread;
+    int                    oscillators_reserved;  /* oscillators the sampleset and sample pools are sized for */
     int                    samplesets_allocated;
     y_sampleset_t         *active_sampleset_list;
     y_sampleset_t         *free_sampleset_list;
@@ -244,38 +425,64 @@ struct _y_global_t {
     float                 *padsynth_outsamples;
     void                  *padsynth_fft_plan;
     void                  *padsynth_ifft_plan;
+    pthread_mutex_t        fftw_planner_mutex;  /* FFTW's planner is not thread-safe */
+
+    /* shared effect bus: the sum of the sends of all instances in the
+     * send or return role, consumed by the single return instance */
+    y_synth_t * volatile   effect_bus_return;
+    volatile int           effect_bus_lock;     /* spinlock, held only while adding or taking a block */
+    float                  effect_bus_l[Y_SHARED_BUS_LENGTH],
+                           effect_bus_r[Y_SHARED_BUS_LENGTH];
 };
 
 extern y_global_t global;
 
 void  y_synth_all_voices_off(y_synth_t *synth);
-void  y_synth_note_off(y_synth_t *synth, unsigned char key,
+void  y_synth_part_voices_off(y_synth_t *synth, y_part_t *part);
+void  y_synth_note_off(y_synth_t *synth, y_part_t *part, unsigned char key,
                             unsigned char rvelocity);
-void  y_synth_all_notes_off(y_synth_t *synth);
-void  y_synth_note_on(y_synth_t *synth, unsigned char key,
+void  y_synth_all_notes_off(y_synth_t *synth, y_part_t *part);
+void  y_synth_note_on(y_synth_t *synth, y_part_t *part, unsigned char key,
                            unsigned char velocity);
-void  y_synth_key_pressure(y_synth_t *synth, unsigned char key,
+void  y_synth_key_pressure(y_synth_t *synth, y_part_t *part, unsigned char key,
                                 unsigned char pressure);
-void  y_synth_damp_voices(y_synth_t *synth);
-void  y_synth_update_wheel_mod(y_synth_t *synth);
-void  y_synth_control_change(y_synth_t *synth, unsigned int param,
-                                  signed int value);
-void  y_synth_channel_pressure(y_synth_t *synth, signed int pressure);
-void  y_synth_pitch_bend(y_synth_t *synth, signed int value);
-void  y_synth_init_controls(y_synth_t *synth);
+void  y_synth_damp_voices(y_synth_t *synth, y_part_t *part);
+void  y_synth_update_wheel_mod(y_part_t *part);
+void  y_synth_control_change(y_synth_t *synth, y_part_t *part,
+                                  unsigned int param, signed int value);
+void  y_synth_channel_pressure(y_synth_t *synth, y_part_t *part,
+                                    signed int pressure);
+void  y_synth_pitch_bend(y_synth_t *synth, y_part_t *part, signed int value);
+void  y_synth_init_controls(y_synth_t *synth, y_part_t *part);
 void  y_synth_select_patch(y_synth_t *synth, unsigned long patch);
 int   y_synth_set_program_descriptor(y_synth_t *synth,
                                      DSSI_Program_Descriptor *pd,
                                      unsigned long patch);
 char *y_synth_handle_load(y_synth_t *synth, const char *value);
+char *y_synth_handle_patch(y_synth_t *synth, const char *value);
 char *y_synth_handle_polyphony(y_synth_t *synth, const char *value);
 char *y_synth_handle_monophonic(y_synth_t *synth, const char *value);
 char *y_synth_handle_glide(y_synth_t *synth, const char *value);
 char *y_synth_handle_program_cancel(y_synth_t *synth, const char *value);
+char *y_synth_handle_event_tolerance(y_synth_t *synth, const char *value);
+char *y_synth_handle_silence_threshold(y_synth_t *synth, const char *value);
+char *y_synth_handle_cpu_budget(y_synth_t *synth, const char *value);
+char *y_synth_handle_telemetry(y_synth_t *synth, const char *value);
 char *y_synth_handle_project_dir(y_synth_t *synth, const char *value);
-void  y_synth_render_voices(y_synth_t *synth, LADSPA_Data *out_left,
-                                 LADSPA_Data *out_right, unsigned long sample_count,
-                                 int do_control_update);
+char *y_synth_handle_impulse_response(y_synth_t *synth, const char *value);
+char *y_synth_handle_effect_bus(y_synth_t *synth, const char *value);
+char *y_synth_handle_parts(y_synth_t *synth, const char *value);
+char *y_synth_handle_part_program(y_synth_t *synth, int part, const char *value);
+void  y_synth_record_run(y_synth_t *synth, float load);
+void  y_synth_govern_polyphony(y_synth_t *synth, float load, float voice_load);
+void  y_synth_control_update(y_synth_t *synth);
+void  y_synth_render_voices(y_synth_t *synth, LADSPA_Data *bus_left,
+                                 LADSPA_Data *bus_right, unsigned long sample_count);
+void  y_synth_process_effects(y_synth_t *synth, LADSPA_Data *out_left,
+                              LADSPA_Data *out_right, unsigned long sample_count);
+void  y_synth_process_effect_bus(y_synth_t *synth, unsigned long offset,
+                                 LADSPA_Data *out_left, LADSPA_Data *out_right,
+                                 unsigned long sample_count);
 
 /* these come right out of alsa/asoundef.h */
 #define MIDI_CTL_MSB_MODWHEEL           0x01    /**< Modulation */
@@ -293,7 +500,129 @@ void  y_synth_render_voices(y_synth_t *synth, LADSPA_Data *out_left,
 #define MIDI_CTL_RESET_CONTROLLERS      0x79    /**< Reset Controllers */
 #define MIDI_CTL_ALL_NOTES_OFF          0x7b    /**< All notes off */
 
-#define Y_SYNTH_SUSTAINED(_s)  ((_s)->cc[MIDI_CTL_SUSTAIN] >= 64)
+#define Y_PART_SUSTAINED(_p)  ((_p)->cc[MIDI_CTL_SUSTAIN] >= 64)
+
+/* ==== inline functions ==== */
+
+/*
+ * y_voice_off
+ * 
+ * Purpose: Turns off a voice immediately, meaning that it is not processed
+ * anymore by the render loop.
+ */
+static inline void
+y_voice_off(y_synth_t *synth, y_voice_t* voice)
+{
+    y_voice_t *last;
+
+    if (voice->status != Y_VOICE_OFF) {
+        /* remove it from the active list, moving the last voice into its place */
+        last = synth->active_voice[--synth->active_voices];
+        synth->active_voice[voice->active_slot] = last;
+        last->active_slot = voice->active_slot;
+        /* and from its key's list */
+        if (voice->key_prev)
+            voice->key_prev->key_next = voice->key_next;
+        else
+            synth->key_voices[voice->key] = voice->key_next;
+        if (voice->key_next)
+            voice->key_next->key_prev = voice->key_prev;
+        synth->voice_free_map[voice->index >> 5] |= 1u << (voice->index & 31);
+    }
+    voice->status = Y_VOICE_OFF;
+    voice->energy = 0.0f;
+    /* the voice may be restarted for a new note before the next control
+     * update, so it must not remain the steal candidate */
+    if (synth->steal_candidate == voice->index)
+        synth->steal_candidate = -1;
+
+    /* silence the oscillator buses for the next use, and return them to the pool */
+    if (voice->bus) {
+        memset(voice->bus->osc_bus_a, 0, OSC_BUS_LENGTH * sizeof(float));
+        memset(voice->bus->osc_bus_b, 0, OSC_BUS_LENGTH * sizeof(float));
+        synth->free_voice_bus[synth->free_voice_bus_count++] = voice->bus;
+        voice->bus = NULL;
+    }
+
+    /* free any still-active grains */
+    if (voice->osc1.grain_list || voice->osc2.grain_list ||
+        voice->osc3.grain_list || voice->osc4.grain_list)
+        free_active_grains(synth, voice);
+}
+
+/*
+ * y_voice_start_voice
+ */
+static inline void
+y_voice_start_voice(y_synth_t *synth, y_voice_t *voice)
+{
+    /* take the most recently freed buses, which are likeliest still cached;
+     * there are as many as voices, so the pool never runs dry */
+    voice->bus = synth->free_voice_bus[--synth->free_voice_bus_count];
+    voice->osc_sync  = voice->bus->osc_sync;
+    voice->osc_bus_a = voice->bus->osc_bus_a;
+    voice->osc_bus_b = voice->bus->osc_bus_b;
+
+    voice->status = Y_VOICE_ON;
+    voice->active_slot = synth->active_voices;
+    synth->active_voice[synth->active_voices++] = voice;
+    voice->key_prev = NULL;
+    voice->key_next = synth->key_voices[voice->key];
+    if (voice->key_next)
+        voice->key_next->key_prev = voice;
+    synth->key_voices[voice->key] = voice;
+    synth->voice_free_map[voice->index >> 5] &= ~(1u << (voice->index & 31));
+    /* a new note is in its attack, so rank it as loud until the next
+     * control update measures it */
+    synth->voice_prio[voice->index] = Y_VOICE_PRIO_ON + 1.0f;
+}
+
+/*
+ * y_voice_set_key
+ *
+ * Changes the key of a voice, moving it to its new key's list if it is
+ * playing.
+ */
+static inline void
+y_voice_set_key(y_synth_t *synth, y_voice_t *voice, unsigned char key)
+{
+    if (voice->status != Y_VOICE_OFF && voice->key != key) {
+        if (voice->key_prev)
+            voice->key_prev->key_next = voice->key_next;
+        else
+            synth->key_voices[voice->key] = voice->key_next;
+        if (voice->key_next)
+            voice->key_next->key_prev = voice->key_prev;
+        voice->key_prev = NULL;
+        voice->key_next = synth->key_voices[key];
+        if (voice->key_next)
+            voice->key_next->key_prev = voice;
+        synth->key_voices[key] = voice;
+    }
+    voice->key = key;
+}
+
+/*
+ * y_synth_find_free_voice
+ *
+ * returns the lowest-numbered available voice within the current polyphony
+ * limit, or NULL if there is none
+ */
+static inline y_voice_t *
+y_synth_find_free_voice(y_synth_t *synth)
+{
+    int w, words = (synth->voices + 31) >> 5;
+    unsigned int bits;
+
+    for (w = 0; w < words; w++) {
+        bits = synth->voice_free_map[w];
+        if (w == words - 1 && (synth->voices & 31))
+            bits &= (1u << (synth->voices & 31)) - 1;
+        if (bits)
+            return synth->voice[(w << 5) + ffs((int)bits) - 1];
+    }
+    return NULL;
+}
 
 #endif /* _DSSP_EVENT_H */
 
@@ -31,9 +31,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <time.h>
 #include <pthread.h>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 #include <ladspa.h>
 #include <dssi.h>
 
@@ -47,6 +53,7 @@
 #include "wave_tables.h"
 #include "sampleset.h"
 #include "effects.h"
+#include "arena.h"
 
 static pthread_mutex_t global_mutex;
 y_global_t             global;
@@ -55,8 +62,12 @@ static LADSPA_Descriptor *y_LADSPA_descriptor = NULL;
 static DSSI_Descriptor   *y_DSSI_descriptor = NULL;
 
 static void y_cleanup(LADSPA_Handle instance);
+static int  y_part_connect_port(y_part_t *part, unsigned long port, LADSPA_Data *data);
+static void y_part_init(y_part_t *part, int index);
 static void y_run_synth(LADSPA_Handle instance, unsigned long sample_count,
                              snd_seq_event_t *events, unsigned long event_count);
+static void y_run_synth_adding(LADSPA_Handle instance, unsigned long sample_count,
+                               snd_seq_event_t *events, unsigned long event_count);
 
 /* ---- mutual exclusion ---- */
 
@@ -101,11 +112,23 @@ dssp_voicelist_mutex_unlock(y_synth_t *synth)
 static LADSPA_Handle
 y_instantiate(const LADSPA_Descriptor *descriptor, unsigned long sample_rate)
 {
-    y_synth_t *synth = (y_synth_t *)calloc(1, sizeof(y_synth_t));
-    int i;
-    static float static_zero = 0.0f;
-
-    if (!synth) return NULL;
+    y_arena_t *arena;
+    y_synth_t *synth;
+    size_t effect_buffer_size;
+
+    /* all the instance's realtime state comes from one arena: the synth,
+     * then enough voices for the default polyphony, back to back, with their
+     * oscillator buses and grains, then its effect buffer.  Voices added when
+     * the polyphony is raised come from further arenas. */
+    effect_buffer_size = effects_buffer_size(sample_rate);
+    if (!effect_buffer_size) return NULL;
+    arena = arena_create(arena_round(sizeof(y_synth_t)) +
+                         y_voice_block_size(0, Y_DEFAULT_POLYPHONY) +
+                         arena_round(effect_buffer_size));
+    if (!arena) return NULL;
+    synth = (y_synth_t *)arena_alloc(arena, sizeof(y_synth_t));
+    synth->arena = arena;
+    synth->part[0] = &synth->first_part;  /* the rest come with multi-timbral mode */
 
     pthread_mutex_lock(&global_mutex);
 
@@ -114,7 +137,7 @@ y_instantiate(const LADSPA_Descriptor *descriptor, unsigned long sample_rate)
         if (sample_rate != global.sample_rate) {
             /* all instances must share same sample rate */
             pthread_mutex_unlock(&global_mutex);
-            free(synth);
+            arena_destroy(arena);
             return NULL;
         }
 
@@ -126,12 +149,12 @@ y_instantiate(const LADSPA_Descriptor *descriptor, unsigned long sample_rate)
         global.grain_envelope = create_grain_envelopes(sample_rate);
         if (!global.grain_envelope) {
             YDB_MESSAGE(-1, " y_instantiate: out of memory!\n");
-            free(synth);
+            arena_destroy(arena);
             return NULL;
         }
         if (!sampleset_init()) {
             YDB_MESSAGE(-1, " y_instantiate: sampleset_setup() failed!\n");
-            free(synth);
+            arena_destroy(arena);
             return NULL;
         }
         global.instance_count = 1;
@@ -141,20 +164,21 @@ y_instantiate(const LADSPA_Descriptor *descriptor, unsigned long sample_rate)
     pthread_mutex_unlock(&global_mutex);
 
     /* do any per-instance one-time initialization here */
-    for (i = 0; i < Y_MAX_POLYPHONY; i++) {
-        synth->voice[i] = y_voice_new(synth);
-        if (!synth->voice[i]) {
-            // YDB_MESSAGE(-1, " y_instantiate: out of memory!\n");
-            y_cleanup(synth);
-            return NULL;
-        }
-    }
-
-    if (!new_grain_array(synth, AG_DEFAULT_GRAIN_COUNT)) {
+    if (!y_voice_add_block(synth, arena, Y_DEFAULT_POLYPHONY)) {
         YDB_MESSAGE(-1, " y_instantiate: out of memory!\n");
         y_cleanup(synth);
         return NULL;
     }
+    synth->active_voices = 0;
+    synth->steal_candidate = -1;
+    synth->silence_threshold = 0.0f;  /* off */
+    synth->mix_level = 0.0f;
+    synth->mix_level_next = 0.0f;
+    synth->cpu_budget = 0.0f;
+    synth->cpu_load = 0.0f;
+    synth->voice_limit = Y_DEFAULT_POLYPHONY;
+    memset(&synth->telemetry, 0, sizeof(struct y_telemetry));
+    synth->telemetry_reset = 0;
 
     if (!sampleset_instantiate(synth)) {
         YDB_MESSAGE(-1, " y_instantiate: out of memory!\n");
@@ -166,7 +190,7 @@ y_instantiate(const LADSPA_Descriptor *descriptor, unsigned long sample_rate)
     synth->control_rate = (float)sample_rate / (float)Y_CONTROL_PERIOD;
     synth->deltat = 1.0f / synth->sample_rate;
 
-    if (!effects_setup(synth)) {
+    if (!effects_setup(synth, (char *)arena_alloc(arena, effect_buffer_size))) {
         YDB_MESSAGE(-1, " y_instantiate: out of memory!\n");
         y_cleanup(synth);
         return NULL;
@@ -176,36 +200,356 @@ y_instantiate(const LADSPA_Descriptor *descriptor, unsigned long sample_rate)
     synth->voices = Y_DEFAULT_POLYPHONY;
     synth->monophonic = 0;
     synth->glide = 0;
-    synth->last_noteon_pitch = 0.0f;
     pthread_mutex_init(&synth->voicelist_mutex, NULL);
     synth->voicelist_mutex_grab_failed = 0;
     pthread_mutex_init(&synth->patches_mutex, NULL);
     synth->patch_count = 0;
     synth->patches_allocated = 0;
     synth->patches = NULL;
+    synth->patches_file = NULL;
     synth->pending_patch_change = -1;
     synth->program_cancel = 1;
+    synth->event_tolerance = Y_DEFAULT_EVENT_TOLERANCE;
+    synth->idle = 0;
+    synth->idle_samples = 0;
+    synth->idle_hold = lrintf(Y_IDLE_HOLD_TIME * synth->sample_rate);
+    synth->idle_threshold = powf(10.0f, (float)Y_IDLE_THRESHOLD / 10.0f);
+    synth->mix_level_fall = powf(10.0f, -Y_MIX_LEVEL_FALL / 10.0f *
+                                        (float)Y_CONTROL_PERIOD / synth->sample_rate);
+    synth->run_adding_gain = 1.0f;
     synth->project_dir = NULL;
-    synth->osc1.sampleset = NULL;
-    synth->osc2.sampleset = NULL;
-    synth->osc3.sampleset = NULL;
-    synth->osc4.sampleset = NULL;
-    synth->glfo.delay = &static_zero;
-    synth->ego.level[3] = &static_zero;
-    synth->eg1.level[3] = &static_zero;
-    synth->eg2.level[3] = &static_zero;
-    synth->eg3.level[3] = &static_zero;
-    synth->eg4.level[3] = &static_zero;
-    synth->mod[Y_MOD_ONE].value = 1.0f;
-    synth->mod[Y_MOD_ONE].next_value = 1.0f;
-    synth->mod[Y_MOD_ONE].delta = 0.0f;
+    synth->parts = 1;
+    y_part_init(synth->part[0], 0);
     synth->dc_block_r = 1.0f - (2.0f * 3.141593f * 20.0f/* Hz */ / (float)sample_rate); /* DC blocker cutoff */
     y_data_friendly_patches(synth);
-    y_synth_init_controls(synth);
+    y_synth_init_controls(synth, synth->part[0]);
 
     return (LADSPA_Handle)synth;
 }
 
+/*
+ * y_synth_add_adding_bus
+ *
+ * Called from the worker thread, once the audio thread has asked for it, to
+ * allocate the post-effect bus used by run_adding, so that instances which
+ * are only ever run() don't carry it.
+ */
+void
+y_synth_add_adding_bus(y_synth_t *synth)
+{
+    y_arena_t *arena;
+    LADSPA_Data *bus;
+
+    arena = arena_create(2 * Y_EFFECT_BUS_LENGTH * sizeof(LADSPA_Data));
+    if (!arena)
+        return;  /* the audio thread carries on with short blocks */
+    bus = (LADSPA_Data *)arena_alloc(arena, 2 * Y_EFFECT_BUS_LENGTH * sizeof(LADSPA_Data));
+    synth->adding_arena = arena;
+    __sync_synchronize();
+    synth->adding_bus = bus;
+}
+
+/*
+ * y_part_init
+ *
+ * Sets up a newly-allocated (zeroed) part.  Part 0 is connected to the
+ * LADSPA ports by the host; the others are connected to their own port
+ * values.
+ */
+static void
+y_part_init(y_part_t *part, int index)
+{
+    static float static_zero = 0.0f;
+    unsigned long port;
+
+    part->index = index;
+    if (index > 0) {
+        for (port = 0; port < Y_PORTS_COUNT; port++)
+            y_part_connect_port(part, port, &part->port_value[port]);
+    }
+    part->last_noteon_pitch = 0.0f;
+    part->osc1.sampleset = NULL;
+    part->osc2.sampleset = NULL;
+    part->osc3.sampleset = NULL;
+    part->osc4.sampleset = NULL;
+    part->glfo.delay = &static_zero;
+    part->ego.level[3] = &static_zero;
+    part->eg1.level[3] = &static_zero;
+    part->eg2.level[3] = &static_zero;
+    part->eg3.level[3] = &static_zero;
+    part->eg4.level[3] = &static_zero;
+    part->mod[Y_MOD_ONE].value = 1.0f;
+    part->mod[Y_MOD_ONE].next_value = 1.0f;
+    part->mod[Y_MOD_ONE].delta = 0.0f;
+}
+
+/*
+ * y_synth_add_parts
+ *
+ * Allocates parts 1 through Y_MAX_PARTS - 1 from an arena of their own, the
+ * first time multi-timbral mode is asked for, so that single-part instances
+ * don't carry them.  The new parts play the first patch.  Returns false if
+ * out of memory.
+ */
+int
+y_synth_add_parts(y_synth_t *synth)
+{
+    y_arena_t *arena;
+    y_part_t *part;
+    int i;
+
+    if (synth->part[1])
+        return 1;  /* already done */
+
+    arena = arena_create((Y_MAX_PARTS - 1) * arena_round(sizeof(y_part_t)));
+    if (!arena)
+        return 0;
+
+    pthread_mutex_lock(&synth->patches_mutex);
+    for (i = 1; i < Y_MAX_PARTS; i++) {
+        part = (y_part_t *)arena_alloc(arena, sizeof(y_part_t));
+        y_part_init(part, i);
+        y_voice_set_ports(synth, part, &synth->patches[0]);
+        y_synth_init_controls(synth, part);
+        /* the audio thread only looks at parts below synth->parts, so
+         * these may be published without the voicelist mutex */
+        synth->part[i] = part;
+    }
+    pthread_mutex_unlock(&synth->patches_mutex);
+
+    arena->next = synth->arena->next;  /* freed along with the instance */
+    synth->arena->next = arena;
+
+    return 1;
+}
+
+/*
+ * y_part_connect_port
+ *
+ * Connects one of a part's patch parameter ports; returns false if the
+ * port is not one of them.
+ */
+static int
+y_part_connect_port(y_part_t *part, unsigned long port, LADSPA_Data *data)
+{
+    switch (port) {
+      /* -PORTS- */
+      case Y_PORT_OSC1_MODE:          part->osc1.mode           = data;  break;
+      case Y_PORT_OSC1_WAVEFORM:      part->osc1.waveform       = data;  break;
+      case Y_PORT_OSC1_PITCH:         part->osc1.pitch          = data;  break;
+      case Y_PORT_OSC1_DETUNE:        part->osc1.detune         = data;  break;
+      case Y_PORT_OSC1_PITCH_MOD_SRC: part->osc1.pitch_mod_src  = data;  break;
+      case Y_PORT_OSC1_PITCH_MOD_AMT: part->osc1.pitch_mod_amt  = data;  break;
+      case Y_PORT_OSC1_MPARAM1:       part->osc1.mparam1        = data;  break;
+      case Y_PORT_OSC1_MPARAM2:       part->osc1.mparam2        = data;  break;
+      case Y_PORT_OSC1_MMOD_SRC:      part->osc1.mmod_src       = data;  break;
+      case Y_PORT_OSC1_MMOD_AMT:      part->osc1.mmod_amt       = data;  break;
+      case Y_PORT_OSC1_AMP_MOD_SRC:   part->osc1.amp_mod_src    = data;  break;
+      case Y_PORT_OSC1_AMP_MOD_AMT:   part->osc1.amp_mod_amt    = data;  break;
+      case Y_PORT_OSC1_LEVEL_A:       part->osc1.level_a        = data;  break;
+      case Y_PORT_OSC1_LEVEL_B:       part->osc1.level_b        = data;  break;
+
+      case Y_PORT_OSC2_MODE:          part->osc2.mode           = data;  break;
+      case Y_PORT_OSC2_WAVEFORM:      part->osc2.waveform       = data;  break;
+      case Y_PORT_OSC2_PITCH:         part->osc2.pitch          = data;  break;
+      case Y_PORT_OSC2_DETUNE:        part->osc2.detune         = data;  break;
+      case Y_PORT_OSC2_PITCH_MOD_SRC: part->osc2.pitch_mod_src  = data;  break;
+      case Y_PORT_OSC2_PITCH_MOD_AMT: part->osc2.pitch_mod_amt  = data;  break;
+      case Y_PORT_OSC2_MPARAM1:       part->osc2.mparam1        = data;  break;
+      case Y_PORT_OSC2_MPARAM2:       part->osc2.mparam2        = data;  break;
+      case Y_PORT_OSC2_MMOD_SRC:      part->osc2.mmod_src       = data;  break;
+      case Y_PORT_OSC2_MMOD_AMT:      part->osc2.mmod_amt       = data;  break;
+      case Y_PORT_OSC2_AMP_MOD_SRC:   part->osc2.amp_mod_src    = data;  break;
+      case Y_PORT_OSC2_AMP_MOD_AMT:   part->osc2.amp_mod_amt    = data;  break;
+      case Y_PORT_OSC2_LEVEL_A:       part->osc2.level_a        = data;  break;
+      case Y_PORT_OSC2_LEVEL_B:       part->osc2.level_b        = data;  break;
+
+      case Y_PORT_OSC3_MODE:          part->osc3.mode           = data;  break;
+      case Y_PORT_OSC3_WAVEFORM:      part->osc3.waveform       = data;  break;
+      case Y_PORT_OSC3_PITCH:         part->osc3.pitch          = data;  break;
+      case Y_PORT_OSC3_DETUNE:        part->osc3.detune         = data;  break;
+      case Y_PORT_OSC3_PITCH_MOD_SRC: part->osc3.pitch_mod_src  = data;  break;
+      case Y_PORT_OSC3_PITCH_MOD_AMT: part->osc3.pitch_mod_amt  = data;  break;
+      case Y_PORT_OSC3_MPARAM1:       part->osc3.mparam1        = data;  break;
+      case Y_PORT_OSC3_MPARAM2:       part->osc3.mparam2        = data;  break;
+      case Y_PORT_OSC3_MMOD_SRC:      part->osc3.mmod_src       = data;  break;
+      case Y_PORT_OSC3_MMOD_AMT:      part->osc3.mmod_amt       = data;  break;
+      case Y_PORT_OSC3_AMP_MOD_SRC:   part->osc3.amp_mod_src    = data;  break;
+      case Y_PORT_OSC3_AMP_MOD_AMT:   part->osc3.amp_mod_amt    = data;  break;
+      case Y_PORT_OSC3_LEVEL_A:       part->osc3.level_a        = data;  break;
+      case Y_PORT_OSC3_LEVEL_B:       part->osc3.level_b        = data;  break;
+
+      case Y_PORT_OSC4_MODE:          part->osc4.mode           = data;  break;
+      case Y_PORT_OSC4_WAVEFORM:      part->osc4.waveform       = data;  break;
+      case Y_PORT_OSC4_PITCH:         part->osc4.pitch          = data;  break;
+      case Y_PORT_OSC4_DETUNE:        part->osc4.detune         = data;  break;
+      case Y_PORT_OSC4_PITCH_MOD_SRC: part->osc4.pitch_mod_src  = data;  break;
+      case Y_PORT_OSC4_PITCH_MOD_AMT: part->osc4.pitch_mod_amt  = data;  break;
+      case Y_PORT_OSC4_MPARAM1:       part->osc4.mparam1        = data;  break;
+      case Y_PORT_OSC4_MPARAM2:       part->osc4.mparam2        = data;  break;
+      case Y_PORT_OSC4_MMOD_SRC:      part->osc4.mmod_src       = data;  break;
+      case Y_PORT_OSC4_MMOD_AMT:      part->osc4.mmod_amt       = data;  break;
+      case Y_PORT_OSC4_AMP_MOD_SRC:   part->osc4.amp_mod_src    = data;  break;
+      case Y_PORT_OSC4_AMP_MOD_AMT:   part->osc4.amp_mod_amt    = data;  break;
+      case Y_PORT_OSC4_LEVEL_A:       part->osc4.level_a        = data;  break;
+      case Y_PORT_OSC4_LEVEL_B:       part->osc4.level_b        = data;  break;
+
+      case Y_PORT_VCF1_MODE:          part->vcf1.mode           = data;  break;
+      case Y_PORT_VCF1_SOURCE:        part->vcf1.source         = data;  break;
+      case Y_PORT_VCF1_FREQUENCY:     part->vcf1.frequency      = data;  break;
+      case Y_PORT_VCF1_FREQ_MOD_SRC:  part->vcf1.freq_mod_src   = data;  break;
+      case Y_PORT_VCF1_FREQ_MOD_AMT:  part->vcf1.freq_mod_amt   = data;  break;
+      case Y_PORT_VCF1_QRES:          part->vcf1.qres           = data;  break;
+      case Y_PORT_VCF1_MPARAM:        part->vcf1.mparam         = data;  break;
+
+      case Y_PORT_VCF2_MODE:          part->vcf2.mode           = data;  break;
+      case Y_PORT_VCF2_SOURCE:        part->vcf2.source         = data;  break;
+      case Y_PORT_VCF2_FREQUENCY:     part->vcf2.frequency      = data;  break;
+      case Y_PORT_VCF2_FREQ_MOD_SRC:  part->vcf2.freq_mod_src   = data;  break;
+      case Y_PORT_VCF2_FREQ_MOD_AMT:  part->vcf2.freq_mod_amt   = data;  break;
+      case Y_PORT_VCF2_QRES:          part->vcf2.qres           = data;  break;
+      case Y_PORT_VCF2_MPARAM:        part->vcf2.mparam         = data;  break;
+
+      case Y_PORT_BUSA_LEVEL:         part->busa_level          = data;  break;
+      case Y_PORT_BUSA_PAN:           part->busa_pan            = data;  break;
+      case Y_PORT_BUSB_LEVEL:         part->busb_level          = data;  break;
+      case Y_PORT_BUSB_PAN:           part->busb_pan            = data;  break;
+      case Y_PORT_VCF1_LEVEL:         part->vcf1_level          = data;  break;
+      case Y_PORT_VCF1_PAN:           part->vcf1_pan            = data;  break;
+      case Y_PORT_VCF2_LEVEL:         part->vcf2_level          = data;  break;
+      case Y_PORT_VCF2_PAN:           part->vcf2_pan            = data;  break;
+      case Y_PORT_VOLUME:             part->volume              = data;  break;
+
+      case Y_PORT_GLIDE_TIME:         part->glide_time          = data;  break;
+      case Y_PORT_BEND_RANGE:         part->bend_range          = data;  break;
+
+      case Y_PORT_GLFO_FREQUENCY:     part->glfo.frequency      = data;  break;
+      case Y_PORT_GLFO_WAVEFORM:      part->glfo.waveform       = data;  break;
+      /* part->glfo.delay always points to a 0.0f */
+      case Y_PORT_GLFO_AMP_MOD_SRC:   part->glfo.amp_mod_src    = data;  break;
+      case Y_PORT_GLFO_AMP_MOD_AMT:   part->glfo.amp_mod_amt    = data;  break;
+
+      case Y_PORT_VLFO_FREQUENCY:     part->vlfo.frequency      = data;  break;
+      case Y_PORT_VLFO_WAVEFORM:      part->vlfo.waveform       = data;  break;
+      case Y_PORT_VLFO_DELAY:         part->vlfo.delay          = data;  break;
+      case Y_PORT_VLFO_AMP_MOD_SRC:   part->vlfo.amp_mod_src    = data;  break;
+      case Y_PORT_VLFO_AMP_MOD_AMT:   part->vlfo.amp_mod_amt    = data;  break;
+
+      case Y_PORT_MLFO_FREQUENCY:     part->mlfo.frequency      = data;  break;
+      case Y_PORT_MLFO_WAVEFORM:      part->mlfo.waveform       = data;  break;
+      case Y_PORT_MLFO_DELAY:         part->mlfo.delay          = data;  break;
+      case Y_PORT_MLFO_AMP_MOD_SRC:   part->mlfo.amp_mod_src    = data;  break;
+      case Y_PORT_MLFO_AMP_MOD_AMT:   part->mlfo.amp_mod_amt    = data;  break;
+      case Y_PORT_MLFO_PHASE_SPREAD:  part->mlfo_phase_spread   = data;  break;
+      case Y_PORT_MLFO_RANDOM_FREQ:   part->mlfo_random_freq    = data;  break;
+
+      case Y_PORT_EGO_MODE:           part->ego.mode            = data;  break;
+      case Y_PORT_EGO_SHAPE1:         part->ego.shape[0]        = data;  break;
+      case Y_PORT_EGO_TIME1:          part->ego.time[0]         = data;  break;
+      case Y_PORT_EGO_LEVEL1:         part->ego.level[0]        = data;  break;
+      case Y_PORT_EGO_SHAPE2:         part->ego.shape[1]        = data;  break;
+      case Y_PORT_EGO_TIME2:          part->ego.time[1]         = data;  break;
+      case Y_PORT_EGO_LEVEL2:         part->ego.level[1]        = data;  break;
+      case Y_PORT_EGO_SHAPE3:         part->ego.shape[2]        = data;  break;
+      case Y_PORT_EGO_TIME3:          part->ego.time[2]         = data;  break;
+      case Y_PORT_EGO_LEVEL3:         part->ego.level[2]        = data;  break;
+      case Y_PORT_EGO_SHAPE4:         part->ego.shape[3]        = data;  break;
+      case Y_PORT_EGO_TIME4:          part->ego.time[3]         = data;  break;
+      /* part->ego.level[3] always points to a 0.0f */
+      case Y_PORT_EGO_VEL_LEVEL_SENS: part->ego.vel_level_sens  = data;  break;
+      case Y_PORT_EGO_VEL_TIME_SCALE: part->ego.vel_time_scale  = data;  break;
+      case Y_PORT_EGO_KBD_TIME_SCALE: part->ego.kbd_time_scale  = data;  break;
+      case Y_PORT_EGO_AMP_MOD_SRC:    part->ego.amp_mod_src     = data;  break;
+      case Y_PORT_EGO_AMP_MOD_AMT:    part->ego.amp_mod_amt     = data;  break;
+
+      case Y_PORT_EG1_MODE:           part->eg1.mode            = data;  break;
+      case Y_PORT_EG1_SHAPE1:         part->eg1.shape[0]        = data;  break;
+      case Y_PORT_EG1_TIME1:          part->eg1.time[0]         = data;  break;
+      case Y_PORT_EG1_LEVEL1:         part->eg1.level[0]        = data;  break;
+      case Y_PORT_EG1_SHAPE2:         part->eg1.shape[1]        = data;  break;
+      case Y_PORT_EG1_TIME2:          part->eg1.time[1]         = data;  break;
+      case Y_PORT_EG1_LEVEL2:         part->eg1.level[1]        = data;  break;
+      case Y_PORT_EG1_SHAPE3:         part->eg1.shape[2]        = data;  break;
+      case Y_PORT_EG1_TIME3:          part->eg1.time[2]         = data;  break;
+      case Y_PORT_EG1_LEVEL3:         part->eg1.level[2]        = data;  break;
+      case Y_PORT_EG1_SHAPE4:         part->eg1.shape[3]        = data;  break;
+      case Y_PORT_EG1_TIME4:          part->eg1.time[3]         = data;  break;
+      /* part->eg1.level[3] always points to a 0.0f */
+      case Y_PORT_EG1_VEL_LEVEL_SENS: part->eg1.vel_level_sens  = data;  break;
+      case Y_PORT_EG1_VEL_TIME_SCALE: part->eg1.vel_time_scale  = data;  break;
+      case Y_PORT_EG1_KBD_TIME_SCALE: part->eg1.kbd_time_scale  = data;  break;
+      case Y_PORT_EG1_AMP_MOD_SRC:    part->eg1.amp_mod_src     = data;  break;
+      case Y_PORT_EG1_AMP_MOD_AMT:    part->eg1.amp_mod_amt     = data;  break;
+
+      case Y_PORT_EG2_MODE:           part->eg2.mode            = data;  break;
+      case Y_PORT_EG2_SHAPE1:         part->eg2.shape[0]        = data;  break;
+      case Y_PORT_EG2_TIME1:          part->eg2.time[0]         = data;  break;
+      case Y_PORT_EG2_LEVEL1:         part->eg2.level[0]        = data;  break;
+      case Y_PORT_EG2_SHAPE2:         part->eg2.shape[1]        = data;  break;
+      case Y_PORT_EG2_TIME2:          part->eg2.time[1]         = data;  break;
+      case Y_PORT_EG2_LEVEL2:         part->eg2.level[1]        = data;  break;
+      case Y_PORT_EG2_SHAPE3:         part->eg2.shape[2]        = data;  break;
+      case Y_PORT_EG2_TIME3:          part->eg2.time[2]         = data;  break;
+      case Y_PORT_EG2_LEVEL3:         part->eg2.level[2]        = data;  break;
+      case Y_PORT_EG2_SHAPE4:         part->eg2.shape[3]        = data;  break;
+      case Y_PORT_EG2_TIME4:          part->eg2.time[3]         = data;  break;
+      /* part->eg2.level[3] always points to a 0.0f */
+      case Y_PORT_EG2_VEL_LEVEL_SENS: part->eg2.vel_level_sens  = data;  break;
+      case Y_PORT_EG2_VEL_TIME_SCALE: part->eg2.vel_time_scale  = data;  break;
+      case Y_PORT_EG2_KBD_TIME_SCALE: part->eg2.kbd_time_scale  = data;  break;
+      case Y_PORT_EG2_AMP_MOD_SRC:    part->eg2.amp_mod_src     = data;  break;
+      case Y_PORT_EG2_AMP_MOD_AMT:    part->eg2.amp_mod_amt     = data;  break;
+
+      case Y_PORT_EG3_MODE:           part->eg3.mode            = data;  break;
+      case Y_PORT_EG3_SHAPE1:         part->eg3.shape[0]        = data;  break;
+      case Y_PORT_EG3_TIME1:          part->eg3.time[0]         = data;  break;
+      case Y_PORT_EG3_LEVEL1:         part->eg3.level[0]        = data;  break;
+      case Y_PORT_EG3_SHAPE2:         part->eg3.shape[1]        = data;  break;
+      case Y_PORT_EG3_TIME2:          part->eg3.time[1]         = data;  break;
+      case Y_PORT_EG3_LEVEL2:         part->eg3.level[1]        = data;  break;
+      case Y_PORT_EG3_SHAPE3:         part->eg3.shape[2]        = data;  break;
+      case Y_PORT_EG3_TIME3:          part->eg3.time[2]         = data;  break;
+      case Y_PORT_EG3_LEVEL3:         part->eg3.level[2]        = data;  break;
+      case Y_PORT_EG3_SHAPE4:         part->eg3.shape[3]        = data;  break;
+      case Y_PORT_EG3_TIME4:          part->eg3.time[3]         = data;  break;
+      /* part->eg3.level[3] always points to a 0.0f */
+      case Y_PORT_EG3_VEL_LEVEL_SENS: part->eg3.vel_level_sens  = data;  break;
+      case Y_PORT_EG3_VEL_TIME_SCALE: part->eg3.vel_time_scale  = data;  break;
+      case Y_PORT_EG3_KBD_TIME_SCALE: part->eg3.kbd_time_scale  = data;  break;
+      case Y_PORT_EG3_AMP_MOD_SRC:    part->eg3.amp_mod_src     = data;  break;
+      case Y_PORT_EG3_AMP_MOD_AMT:    part->eg3.amp_mod_amt     = data;  break;
+
+      case Y_PORT_EG4_MODE:           part->eg4.mode            = data;  break;
+      case Y_PORT_EG4_SHAPE1:         part->eg4.shape[0]        = data;  break;
+      case Y_PORT_EG4_TIME1:          part->eg4.time[0]         = data;  break;
+      case Y_PORT_EG4_LEVEL1:         part->eg4.level[0]        = data;  break;
+      case Y_PORT_EG4_SHAPE2:         part->eg4.shape[1]        = data;  break;
+      case Y_PORT_EG4_TIME2:          part->eg4.time[1]         = data;  break;
+      case Y_PORT_EG4_LEVEL2:         part->eg4.level[1]        = data;  break;
+      case Y_PORT_EG4_SHAPE3:         part->eg4.shape[2]        = data;  break;
+      case Y_PORT_EG4_TIME3:          part->eg4.time[2]         = data;  break;
+      case Y_PORT_EG4_LEVEL3:         part->eg4.level[2]        = data;  break;
+      case Y_PORT_EG4_SHAPE4:         part->eg4.shape[3]        = data;  break;
+      case Y_PORT_EG4_TIME4:          part->eg4.time[3]         = data;  break;
+      /* part->eg4.level[3] always points to a 0.0f */
+      case Y_PORT_EG4_VEL_LEVEL_SENS: part->eg4.vel_level_sens  = data;  break;
+      case Y_PORT_EG4_VEL_TIME_SCALE: part->eg4.vel_time_scale  = data;  break;
+      case Y_PORT_EG4_KBD_TIME_SCALE: part->eg4.kbd_time_scale  = data;  break;
+      case Y_PORT_EG4_AMP_MOD_SRC:    part->eg4.amp_mod_src     = data;  break;
+      case Y_PORT_EG4_AMP_MOD_AMT:    part->eg4.amp_mod_amt     = data;  break;
+
+      case Y_PORT_MODMIX_BIAS:        part->modmix_bias         = data;  break;
+      case Y_PORT_MODMIX_MOD1_SRC:    part->modmix_mod1_src     = data;  break;
+      case Y_PORT_MODMIX_MOD1_AMT:    part->modmix_mod1_amt     = data;  break;
+      case Y_PORT_MODMIX_MOD2_SRC:    part->modmix_mod2_src     = data;  break;
+      case Y_PORT_MODMIX_MOD2_AMT:    part->modmix_mod2_amt     = data;  break;
+
+      default:
+        return 0;
+    }
+    return 1;
+}
+
 /*
  * y_connect_port
  *
@@ -216,97 +560,17 @@ y_connect_port(LADSPA_Handle instance, unsigned long port, LADSPA_Data *data)
 {
     y_synth_t *synth = (y_synth_t *)instance;
 
+    if (port < Y_PORTS_COUNT)
+        synth->port[port] = data;
+
+    if (y_part_connect_port(synth->part[0], port, data))
+        return;
+
     switch (port) {
       /* -PORTS- */
       case Y_PORT_OUTPUT_LEFT:        synth->output_left        = data;  break;
       case Y_PORT_OUTPUT_RIGHT:       synth->output_right       = data;  break;
 
-      case Y_PORT_OSC1_MODE:          synth->osc1.mode          = data;  break;
-      case Y_PORT_OSC1_WAVEFORM:      synth->osc1.waveform      = data;  break;
-      case Y_PORT_OSC1_PITCH:         synth->osc1.pitch         = data;  break;
-      case Y_PORT_OSC1_DETUNE:        synth->osc1.detune        = data;  break;
-      case Y_PORT_OSC1_PITCH_MOD_SRC: synth->osc1.pitch_mod_src = data;  break;
-      case Y_PORT_OSC1_PITCH_MOD_AMT: synth->osc1.pitch_mod_amt = data;  break;
-      case Y_PORT_OSC1_MPARAM1:       synth->osc1.mparam1       = data;  break;
-      case Y_PORT_OSC1_MPARAM2:       synth->osc1.mparam2       = data;  break;
-      case Y_PORT_OSC1_MMOD_SRC:      synth->osc1.mmod_src      = data;  break;
-      case Y_PORT_OSC1_MMOD_AMT:      synth->osc1.mmod_amt      = data;  break;
-      case Y_PORT_OSC1_AMP_MOD_SRC:   synth->osc1.amp_mod_src   = data;  break;
-      case Y_PORT_OSC1_AMP_MOD_AMT:   synth->osc1.amp_mod_amt   = data;  break;
-      case Y_PORT_OSC1_LEVEL_A:       synth->osc1.level_a       = data;  break;
-      case Y_PORT_OSC1_LEVEL_B:       synth->osc1.level_b       = data;  break;
-
-      case Y_PORT_OSC2_MODE:          synth->osc2.mode          = data;  break;
-      case Y_PORT_OSC2_WAVEFORM:      synth->osc2.waveform      = data;  break;
-      case Y_PORT_OSC2_PITCH:         synth->osc2.pitch         = data;  break;
-      case Y_PORT_OSC2_DETUNE:        synth->osc2.detune        = data;  break;
-      case Y_PORT_OSC2_PITCH_MOD_SRC: synth->osc2.pitch_mod_src = data;  break;
-      case Y_PORT_OSC2_PITCH_MOD_AMT: synth->osc2.pitch_mod_amt = data;  break;
-      case Y_PORT_OSC2_MPARAM1:       synth->osc2.mparam1       = data;  break;
-      case Y_PORT_OSC2_MPARAM2:       synth->osc2.mparam2       = data;  break;
-      case Y_PORT_OSC2_MMOD_SRC:      synth->osc2.mmod_src      = data;  break;
-      case Y_PORT_OSC2_MMOD_AMT:      synth->osc2.mmod_amt      = data;  break;
-      case Y_PORT_OSC2_AMP_MOD_SRC:   synth->osc2.amp_mod_src   = data;  break;
-      case Y_PORT_OSC2_AMP_MOD_AMT:   synth->osc2.amp_mod_amt   = data;  break;
-      case Y_PORT_OSC2_LEVEL_A:       synth->osc2.level_a       = data;  break;
-      case Y_PORT_OSC2_LEVEL_B:       synth->osc2.level_b       = data;  break;
-
-      case Y_PORT_OSC3_MODE:          synth->osc3.mode          = data;  break;
-      case Y_PORT_OSC3_WAVEFORM:      synth->osc3.waveform      = data;  break;
-      case Y_PORT_OSC3_PITCH:         synth->osc3.pitch         = data;  break;
-      case Y_PORT_OSC3_DETUNE:        synth->osc3.detune        = data;  break;
-      case Y_PORT_OSC3_PITCH_MOD_SRC: synth->osc3.pitch_mod_src = data;  break;
-      case Y_PORT_OSC3_PITCH_MOD_AMT: synth->osc3.pitch_mod_amt = data;  break;
-      case Y_PORT_OSC3_MPARAM1:       synth->osc3.mparam1       = data;  break;
-      case Y_PORT_OSC3_MPARAM2:       synth->osc3.mparam2       = data;  break;
-      case Y_PORT_OSC3_MMOD_SRC:      synth->osc3.mmod_src      = data;  break;
-      case Y_PORT_OSC3_MMOD_AMT:      synth->osc3.mmod_amt      = data;  break;
-      case Y_PORT_OSC3_AMP_MOD_SRC:   synth->osc3.amp_mod_src   = data;  break;
-      case Y_PORT_OSC3_AMP_MOD_AMT:   synth->osc3.amp_mod_amt   = data;  break;
-      case Y_PORT_OSC3_LEVEL_A:       synth->osc3.level_a       = data;  break;
-      case Y_PORT_OSC3_LEVEL_B:       synth->osc3.level_b       = data;  break;
-
-      case Y_PORT_OSC4_MODE:          synth->osc4.mode          = data;  break;
-      case Y_PORT_OSC4_WAVEFORM:      synth->osc4.waveform      = data;  break;
-      case Y_PORT_OSC4_PITCH:         synth->osc4.pitch         = data;  break;
-      case Y_PORT_OSC4_DETUNE:        synth->osc4.detune        = data;  break;
-      case Y_PORT_OSC4_PITCH_MOD_SRC: synth->osc4.pitch_mod_src = data;  break;
-      case Y_PORT_OSC4_PITCH_MOD_AMT: synth->osc4.pitch_mod_amt = data;  break;
-      case Y_PORT_OSC4_MPARAM1:       synth->osc4.mparam1       = data;  break;
-      case Y_PORT_OSC4_MPARAM2:       synth->osc4.mparam2       = data;  break;
-      case Y_PORT_OSC4_MMOD_SRC:      synth->osc4.mmod_src      = data;  break;
-      case Y_PORT_OSC4_MMOD_AMT:      synth->osc4.mmod_amt      = data;  break;
-      case Y_PORT_OSC4_AMP_MOD_SRC:   synth->osc4.amp_mod_src   = data;  break;
-      case Y_PORT_OSC4_AMP_MOD_AMT:   synth->osc4.amp_mod_amt   = data;  break;
-      case Y_PORT_OSC4_LEVEL_A:       synth->osc4.level_a       = data;  break;
-      case Y_PORT_OSC4_LEVEL_B:       synth->osc4.level_b       = data;  break;
-
-      case Y_PORT_VCF1_MODE:          synth->vcf1.mode          = data;  break;
-      case Y_PORT_VCF1_SOURCE:        synth->vcf1.source        = data;  break;
-      case Y_PORT_VCF1_FREQUENCY:     synth->vcf1.frequency     = data;  break;
-      case Y_PORT_VCF1_FREQ_MOD_SRC:  synth->vcf1.freq_mod_src  = data;  break;
-      case Y_PORT_VCF1_FREQ_MOD_AMT:  synth->vcf1.freq_mod_amt  = data;  break;
-      case Y_PORT_VCF1_QRES:          synth->vcf1.qres          = data;  break;
-      case Y_PORT_VCF1_MPARAM:        synth->vcf1.mparam        = data;  break;
-
-      case Y_PORT_VCF2_MODE:          synth->vcf2.mode          = data;  break;
-      case Y_PORT_VCF2_SOURCE:        synth->vcf2.source        = data;  break;
-      case Y_PORT_VCF2_FREQUENCY:     synth->vcf2.frequency     = data;  break;
-      case Y_PORT_VCF2_FREQ_MOD_SRC:  synth->vcf2.freq_mod_src  = data;  break;
-      case Y_PORT_VCF2_FREQ_MOD_AMT:  synth->vcf2.freq_mod_amt  = data;  break;
-      case Y_PORT_VCF2_QRES:          synth->vcf2.qres          = data;  break;
-      case Y_PORT_VCF2_MPARAM:        synth->vcf2.mparam        = data;  break;
-
-      case Y_PORT_BUSA_LEVEL:         synth->busa_level         = data;  break;
-      case Y_PORT_BUSA_PAN:           synth->busa_pan           = data;  break;
-      case Y_PORT_BUSB_LEVEL:         synth->busb_level         = data;  break;
-      case Y_PORT_BUSB_PAN:           synth->busb_pan           = data;  break;
-      case Y_PORT_VCF1_LEVEL:         synth->vcf1_level         = data;  break;
-      case Y_PORT_VCF1_PAN:           synth->vcf1_pan           = data;  break;
-      case Y_PORT_VCF2_LEVEL:         synth->vcf2_level         = data;  break;
-      case Y_PORT_VCF2_PAN:           synth->vcf2_pan           = data;  break;
-      case Y_PORT_VOLUME:             synth->volume             = data;  break;
-
       case Y_PORT_EFFECT_MODE:        synth->effect_mode        = data;  break;
       case Y_PORT_EFFECT_PARAM1:      synth->effect_param1      = data;  break;
       case Y_PORT_EFFECT_PARAM2:      synth->effect_param2      = data;  break;
@@ -316,130 +580,6 @@ y_connect_port(LADSPA_Handle instance, unsigned long port, LADSPA_Data *data)
       case Y_PORT_EFFECT_PARAM6:      synth->effect_param6      = data;  break;
       case Y_PORT_EFFECT_MIX:         synth->effect_mix         = data;  break;
 
-      case Y_PORT_GLIDE_TIME:         synth->glide_time         = data;  break;
-      case Y_PORT_BEND_RANGE:         synth->bend_range         = data;  break;
-
-      case Y_PORT_GLFO_FREQUENCY:     synth->glfo.frequency     = data;  break;
-      case Y_PORT_GLFO_WAVEFORM:      synth->glfo.waveform      = data;  break;
-      /* synth->glfo.delay always points to a 0.0f */
-      case Y_PORT_GLFO_AMP_MOD_SRC:   synth->glfo.amp_mod_src   = data;  break;
-      case Y_PORT_GLFO_AMP_MOD_AMT:   synth->glfo.amp_mod_amt   = data;  break;
-
-      case Y_PORT_VLFO_FREQUENCY:     synth->vlfo.frequency     = data;  break;
-      case Y_PORT_VLFO_WAVEFORM:      synth->vlfo.waveform      = data;  break;
-      case Y_PORT_VLFO_DELAY:         synth->vlfo.delay         = data;  break;
-      case Y_PORT_VLFO_AMP_MOD_SRC:   synth->vlfo.amp_mod_src   = data;  break;
-      case Y_PORT_VLFO_AMP_MOD_AMT:   synth->vlfo.amp_mod_amt   = data;  break;
-
-      case Y_PORT_MLFO_FREQUENCY:     synth->mlfo.frequency     = data;  break;
-      case Y_PORT_MLFO_WAVEFORM:      synth->mlfo.waveform      = data;  break;
-      case Y_PORT_MLFO_DELAY:         synth->mlfo.delay         = data;  break;
-      case Y_PORT_MLFO_AMP_MOD_SRC:   synth->mlfo.amp_mod_src   = data;  break;
-      case Y_PORT_MLFO_AMP_MOD_AMT:   synth->mlfo.amp_mod_amt   = data;  break;
-      case Y_PORT_MLFO_PHASE_SPREAD:  synth->mlfo_phase_spread  = data;  break;
-      case Y_PORT_MLFO_RANDOM_FREQ:   synth->mlfo_random_freq   = data;  break;
-
-      case Y_PORT_EGO_MODE:           synth->ego.mode           = data;  break;
-      case Y_PORT_EGO_SHAPE1:         synth->ego.shape[0]       = data;  break;
-      case Y_PORT_EGO_TIME1:          synth->ego.time[0]        = data;  break;
-      case Y_PORT_EGO_LEVEL1:         synth->ego.level[0]       = data;  break;
-      case Y_PORT_EGO_SHAPE2:         synth->ego.shape[1]       = data;  break;
-      case Y_PORT_EGO_TIME2:          synth->ego.time[1]        = data;  break;
-      case Y_PORT_EGO_LEVEL2:         synth->ego.level[1]       = data;  break;
-      case Y_PORT_EGO_SHAPE3:         synth->ego.shape[2]       = data;  break;
-      case Y_PORT_EGO_TIME3:          synth->ego.time[2]        = data;  break;
-      case Y_PORT_EGO_LEVEL3:         synth->ego.level[2]       = data;  break;
-      case Y_PORT_EGO_SHAPE4:         synth->ego.shape[3]       = data;  break;
-      case Y_PORT_EGO_TIME4:          synth->ego.time[3]        = data;  break;
-      /* synth->ego.level[3] always points to a 0.0f */
-      case Y_PORT_EGO_VEL_LEVEL_SENS: synth->ego.vel_level_sens = data;  break;
-      case Y_PORT_EGO_VEL_TIME_SCALE: synth->ego.vel_time_scale = data;  break;
-      case Y_PORT_EGO_KBD_TIME_SCALE: synth->ego.kbd_time_scale = data;  break;
-      case Y_PORT_EGO_AMP_MOD_SRC:    synth->ego.amp_mod_src    = data;  break;
-      case Y_PORT_EGO_AMP_MOD_AMT:    synth->ego.amp_mod_amt    = data;  break;
-
-      case Y_PORT_EG1_MODE:           synth->eg1.mode           = data;  break;
-      case Y_PORT_EG1_SHAPE1:         synth->eg1.shape[0]       = data;  break;
-      case Y_PORT_EG1_TIME1:          synth->eg1.time[0]        = data;  break;
-      case Y_PORT_EG1_LEVEL1:         synth->eg1.level[0]       = data;  break;
-      case Y_PORT_EG1_SHAPE2:         synth->eg1.shape[1]       = data;  break;
-      case Y_PORT_EG1_TIME2:          synth->eg1.time[1]        = data;  break;
-      case Y_PORT_EG1_LEVEL2:         synth->eg1.level[1]       = data;  break;
-      case Y_PORT_EG1_SHAPE3:         synth->eg1.shape[2]       = data;  break;
-      case Y_PORT_EG1_TIME3:          synth->eg1.time[2]        = data;  break;
-      case Y_PORT_EG1_LEVEL3:         synth->eg1.level[2]       = data;  break;
-      case Y_PORT_EG1_SHAPE4:         synth->eg1.shape[3]       = data;  break;
-      case Y_PORT_EG1_TIME4:          synth->eg1.time[3]        = data;  break;
-      /* synth->eg1.level[3] always points to a 0.0f */
-      case Y_PORT_EG1_VEL_LEVEL_SENS: synth->eg1.vel_level_sens = data;  break;
-      case Y_PORT_EG1_VEL_TIME_SCALE: synth->eg1.vel_time_scale = data;  break;
-      case Y_PORT_EG1_KBD_TIME_SCALE: synth->eg1.kbd_time_scale = data;  break;
-      case Y_PORT_EG1_AMP_MOD_SRC:    synth->eg1.amp_mod_src    = data;  break;
-      case Y_PORT_EG1_AMP_MOD_AMT:    synth->eg1.amp_mod_amt    = data;  break;
-
-      case Y_PORT_EG2_MODE:           synth->eg2.mode           = data;  break;
-      case Y_PORT_EG2_SHAPE1:         synth->eg2.shape[0]       = data;  break;
-      case Y_PORT_EG2_TIME1:          synth->eg2.time[0]        = data;  break;
-      case Y_PORT_EG2_LEVEL1:         synth->eg2.level[0]       = data;  break;
-      case Y_PORT_EG2_SHAPE2:         synth->eg2.shape[1]       = data;  break;
-      case Y_PORT_EG2_TIME2:          synth->eg2.time[1]        = data;  break;
-      case Y_PORT_EG2_LEVEL2:         synth->eg2.level[1]       = data;  break;
-      case Y_PORT_EG2_SHAPE3:         synth->eg2.shape[2]       = data;  break;
-      case Y_PORT_EG2_TIME3:          synth->eg2.time[2]        = data;  break;
-      case Y_PORT_EG2_LEVEL3:         synth->eg2.level[2]       = data;  break;
-      case Y_PORT_EG2_SHAPE4:         synth->eg2.shape[3]       = data;  break;
-      case Y_PORT_EG2_TIME4:          synth->eg2.time[3]        = data;  break;
-      /* synth->eg2.level[3] always points to a 0.0f */
-      case Y_PORT_EG2_VEL_LEVEL_SENS: synth->eg2.vel_level_sens = data;  break;
-      case Y_PORT_EG2_VEL_TIME_SCALE: synth->eg2.vel_time_scale = data;  break;
-      case Y_PORT_EG2_KBD_TIME_SCALE: synth->eg2.kbd_time_scale = data;  break;
-      case Y_PORT_EG2_AMP_MOD_SRC:    synth->eg2.amp_mod_src    = data;  break;
-      case Y_PORT_EG2_AMP_MOD_AMT:    synth->eg2.amp_mod_amt    = data;  break;
-
-      case Y_PORT_EG3_MODE:           synth->eg3.mode           = data;  break;
-      case Y_PORT_EG3_SHAPE1:         synth->eg3.shape[0]       = data;  break;
-      case Y_PORT_EG3_TIME1:          synth->eg3.time[0]        = data;  break;
-      case Y_PORT_EG3_LEVEL1:         synth->eg3.level[0]       = data;  break;
-      case Y_PORT_EG3_SHAPE2:         synth->eg3.shape[1]       = data;  break;
-      case Y_PORT_EG3_TIME2:          synth->eg3.time[1]        = data;  break;
-      case Y_PORT_EG3_LEVEL2:         synth->eg3.level[1]       = data;  break;
-      case Y_PORT_EG3_SHAPE3:         synth->eg3.shape[2]       = data;  break;
-      case Y_PORT_EG3_TIME3:          synth->eg3.time[2]        = data;  break;
-      case Y_PORT_EG3_LEVEL3:         synth->eg3.level[2]       = data;  break;
-      case Y_PORT_EG3_SHAPE4:         synth->eg3.shape[3]       = data;  break;
-      case Y_PORT_EG3_TIME4:          synth->eg3.time[3]        = data;  break;
-      /* synth->eg3.level[3] always points to a 0.0f */
-      case Y_PORT_EG3_VEL_LEVEL_SENS: synth->eg3.vel_level_sens = data;  break;
-      case Y_PORT_EG3_VEL_TIME_SCALE: synth->eg3.vel_time_scale = data;  break;
-      case Y_PORT_EG3_KBD_TIME_SCALE: synth->eg3.kbd_time_scale = data;  break;
-      case Y_PORT_EG3_AMP_MOD_SRC:    synth->eg3.amp_mod_src    = data;  break;
-      case Y_PORT_EG3_AMP_MOD_AMT:    synth->eg3.amp_mod_amt    = data;  break;
-
-      case Y_PORT_EG4_MODE:           synth->eg4.mode           = data;  break;
-      case Y_PORT_EG4_SHAPE1:         synth->eg4.shape[0]       = data;  break;
-      case Y_PORT_EG4_TIME1:          synth->eg4.time[0]        = data;  break;
-      case Y_PORT_EG4_LEVEL1:         synth->eg4.level[0]       = data;  break;
-      case Y_PORT_EG4_SHAPE2:         synth->eg4.shape[1]       = data;  break;
-      case Y_PORT_EG4_TIME2:          synth->eg4.time[1]        = data;  break;
-      case Y_PORT_EG4_LEVEL2:         synth->eg4.level[1]       = data;  break;
-      case Y_PORT_EG4_SHAPE3:         synth->eg4.shape[2]       = data;  break;
-      case Y_PORT_EG4_TIME3:          synth->eg4.time[2]        = data;  break;
-      case Y_PORT_EG4_LEVEL3:         synth->eg4.level[2]       = data;  break;
-      case Y_PORT_EG4_SHAPE4:         synth->eg4.shape[3]       = data;  break;
-      case Y_PORT_EG4_TIME4:          synth->eg4.time[3]        = data;  break;
-      /* synth->eg4.level[3] always points to a 0.0f */
-      case Y_PORT_EG4_VEL_LEVEL_SENS: synth->eg4.vel_level_sens = data;  break;
-      case Y_PORT_EG4_VEL_TIME_SCALE: synth->eg4.vel_time_scale = data;  break;
-      case Y_PORT_EG4_KBD_TIME_SCALE: synth->eg4.kbd_time_scale = data;  break;
-      case Y_PORT_EG4_AMP_MOD_SRC:    synth->eg4.amp_mod_src    = data;  break;
-      case Y_PORT_EG4_AMP_MOD_AMT:    synth->eg4.amp_mod_amt    = data;  break;
-
-      case Y_PORT_MODMIX_BIAS:        synth->modmix_bias        = data;  break;
-      case Y_PORT_MODMIX_MOD1_SRC:    synth->modmix_mod1_src    = data;  break;
-      case Y_PORT_MODMIX_MOD1_AMT:    synth->modmix_mod1_amt    = data;  break;
-      case Y_PORT_MODMIX_MOD2_SRC:    synth->modmix_mod2_src    = data;  break;
-      case Y_PORT_MODMIX_MOD2_AMT:    synth->modmix_mod2_amt    = data;  break;
-
       case Y_PORT_TUNING:             synth->tuning             = data;  break;
 
       default:
@@ -456,11 +596,20 @@ static void
 y_activate(LADSPA_Handle instance)
 {
     y_synth_t *synth = (y_synth_t *)instance;
+    y_part_t *part;
+    int i;
 
-    synth->control_remains = 0;
+    synth->control_remains = Y_CONTROL_PERIOD;  /* no control update due yet */
     synth->note_id = 0;
-    y_voice_setup_lfo(synth, &synth->glfo, &synth->glfo_vlfo, 0.0f, 0.0f,
-                      synth->mod, &synth->mod[Y_GLOBAL_MOD_GLFO]);
+    synth->idle = 0;
+    synth->idle_samples = 0;
+    synth->mix_level = 0.0f;
+    synth->mix_level_next = 0.0f;
+    for (i = 0; i < synth->parts; i++) {
+        part = synth->part[i];
+        y_voice_setup_lfo(synth, &part->glfo, &part->glfo_vlfo, 0.0f, 0.0f,
+                          part->mod, &part->mod[Y_GLOBAL_MOD_GLFO]);
+    }
     y_synth_all_voices_off(synth);
 }
 
@@ -475,11 +624,30 @@ y_ladspa_run_wrapper(LADSPA_Handle instance, unsigned long sample_count)
     y_run_synth(instance, sample_count, NULL, 0);
 }
 
-// optional:
-//  void (*run_adding)(LADSPA_Handle Instance,
-//                     unsigned long SampleCount);
-//  void (*set_run_adding_gain)(LADSPA_Handle Instance,
-//                              LADSPA_Data   Gain);
+/*
+ * y_ladspa_run_adding_wrapper
+ *
+ * implements LADSPA (*run_adding)() by calling y_run_synth_adding() with no
+ * events
+ */
+static void
+y_ladspa_run_adding_wrapper(LADSPA_Handle instance, unsigned long sample_count)
+{
+    y_run_synth_adding(instance, sample_count, NULL, 0);
+}
+
+/*
+ * y_set_run_adding_gain
+ *
+ * implements LADSPA (*set_run_adding_gain)()
+ */
+static void
+y_set_run_adding_gain(LADSPA_Handle instance, LADSPA_Data gain)
+{
+    y_synth_t *synth = (y_synth_t *)instance;
+
+    synth->run_adding_gain = gain;
+}
 
 /*
  * y_deactivate
@@ -503,16 +671,16 @@ static void
 y_cleanup(LADSPA_Handle instance)
 {
     y_synth_t *synth = (y_synth_t *)instance;
-    int i;
 
-    for (i = 0; i < Y_MAX_POLYPHONY; i++)
-        if (synth->voice[i]) free(synth->voice[i]);
-    if (synth->patches) free(synth->patches);
-    if (synth->grains) free(synth->grains);
+    /* the voices, grains, and effect buffer go with the arena */
+    y_data_free_patches(synth);
+    if (synth->patches_file) free(synth->patches_file);
     if (synth->project_dir) free(synth->project_dir);
+    __sync_bool_compare_and_swap(&global.effect_bus_return, synth, NULL);
     sampleset_cleanup(synth);
     effects_cleanup(synth);
-    free(synth);
+    arena_destroy(synth->adding_arena);
+    arena_destroy(synth->arena);  /* including synth itself */
     pthread_mutex_lock(&global_mutex);
     if (--global.instance_count == 0) {
         sampleset_fini();
@@ -547,12 +715,18 @@ dssi_configure_message(const char *fmt, ...)
 char *
 y_configure(LADSPA_Handle instance, const char *key, const char *value)
 {
+    int part, n = 0;
+
     YDB_MESSAGE(YDB_DSSI, " y_configure called with '%s' and '%s'\n", key, value);
 
     if (!strcmp(key, "load")) {
 
         return y_synth_handle_load((y_synth_t *)instance, value);
 
+    } else if (!strcmp(key, "patch")) {
+
+        return y_synth_handle_patch((y_synth_t *)instance, value);
+
     } else if (!strcmp(key, "polyphony")) {
 
         return y_synth_handle_polyphony((y_synth_t *)instance, value);
@@ -569,6 +743,38 @@ y_configure(LADSPA_Handle instance, const char *key, const char *value)
 
         return y_synth_handle_program_cancel((y_synth_t *)instance, value);
 
+    } else if (!strcmp(key, "event_tolerance")) {
+
+        return y_synth_handle_event_tolerance((y_synth_t *)instance, value);
+
+    } else if (!strcmp(key, "silence_threshold")) {
+
+        return y_synth_handle_silence_threshold((y_synth_t *)instance, value);
+
+    } else if (!strcmp(key, "cpu_budget")) {
+
+        return y_synth_handle_cpu_budget((y_synth_t *)instance, value);
+
+    } else if (!strcmp(key, "telemetry")) {
+
+        return y_synth_handle_telemetry((y_synth_t *)instance, value);
+
+    } else if (!strcmp(key, "effect_bus")) {
+
+        return y_synth_handle_effect_bus((y_synth_t *)instance, value);
+
+    } else if (!strcmp(key, "impulse_response")) {
+
+        return y_synth_handle_impulse_response((y_synth_t *)instance, value);
+
+    } else if (!strcmp(key, "parts")) {
+
+        return y_synth_handle_parts((y_synth_t *)instance, value);
+
+    } else if (sscanf(key, "part%d_program%n", &part, &n) == 1 && key[n] == '\0') {
+
+        return y_synth_handle_part_program((y_synth_t *)instance, part - 1, value);
+
     } else if (!strcmp(key, DSSI_PROJECT_DIRECTORY_KEY)) {
 
         return y_synth_handle_project_dir((y_synth_t *)instance, value);
@@ -714,29 +920,40 @@ y_get_midi_controller(LADSPA_Handle instance, unsigned long port)
 static inline void
 y_handle_event(y_synth_t *synth, snd_seq_event_t *event)
 {
+    y_part_t *part;
+
     YDB_MESSAGE(YDB_DSSI, " y_handle_event called with event type %d\n", event->type);
 
+    /* with a single part, every channel plays it; otherwise each channel
+     * plays its own part, if it has one */
+    if (synth->parts == 1)
+        part = synth->part[0];
+    else if (event->data.note.channel < synth->parts)  /* same as data.control.channel */
+        part = synth->part[event->data.note.channel];
+    else
+        return;
+
     switch (event->type) {
       case SND_SEQ_EVENT_NOTEOFF:
-        y_synth_note_off(synth, event->data.note.note, event->data.note.velocity);
+        y_synth_note_off(synth, part, event->data.note.note, event->data.note.velocity);
         break;
       case SND_SEQ_EVENT_NOTEON:
         if (event->data.note.velocity > 0)
-           y_synth_note_on(synth, event->data.note.note, event->data.note.velocity);
+           y_synth_note_on(synth, part, event->data.note.note, event->data.note.velocity);
         else
-           y_synth_note_off(synth, event->data.note.note, 64); /* shouldn't happen, but... */
+           y_synth_note_off(synth, part, event->data.note.note, 64); /* shouldn't happen, but... */
         break;
       case SND_SEQ_EVENT_KEYPRESS:
-        y_synth_key_pressure(synth, event->data.note.note, event->data.note.velocity);
+        y_synth_key_pressure(synth, part, event->data.note.note, event->data.note.velocity);
         break;
       case SND_SEQ_EVENT_CONTROLLER:
-        y_synth_control_change(synth, event->data.control.param, event->data.control.value);
+        y_synth_control_change(synth, part, event->data.control.param, event->data.control.value);
         break;
       case SND_SEQ_EVENT_CHANPRESS:
-        y_synth_channel_pressure(synth, event->data.control.value);
+        y_synth_channel_pressure(synth, part, event->data.control.value);
         break;
       case SND_SEQ_EVENT_PITCHBEND:
-        y_synth_pitch_bend(synth, event->data.control.value);
+        y_synth_pitch_bend(synth, part, event->data.control.value);
         break;
       /* SND_SEQ_EVENT_PGMCHANGE - shouldn't happen */
       /* SND_SEQ_EVENT_SYSEX - shouldn't happen */
@@ -749,36 +966,380 @@ y_handle_event(y_synth_t *synth, snd_seq_event_t *event)
 }
 
 /*
- * y_run_synth
+ * y_time_now
  *
- * implements DSSI (*run_synth)()
+ * returns a monotonic time in seconds, for measuring run times
  */
+static inline double
+y_time_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ==== denormal control ==== */
+
+/* Rather than inject tiny signals to keep filter, envelope, and effect
+ * states from decaying into denormals, we have the FPU flush them to zero
+ * while we're running.  The host's settings are restored on our way out. */
+
+#if defined(__SSE__)
+
+/* MXCSR flush-to-zero bit, plus denormals-are-zero if the CPU supports it */
+static unsigned int y_mxcsr_bits = 0x8000;
+
 static void
-y_run_synth(LADSPA_Handle instance, unsigned long sample_count,
-                 snd_seq_event_t *events, unsigned long event_count)
+y_denormal_init(void)
+{
+    /* DAZ is missing from some early SSE CPUs, and setting it there faults;
+     * check MXCSR_MASK in the FXSAVE area, per the Intel manuals */
+    static unsigned char fxsave_area[512] __attribute__((aligned(16)));
+    unsigned int mask;
+
+    memset(fxsave_area, 0, sizeof(fxsave_area));
+    __asm__ __volatile__ ("fxsave %0" : "=m" (fxsave_area));
+    memcpy(&mask, fxsave_area + 28, sizeof(mask));
+    if (mask & 0x0040)
+        y_mxcsr_bits |= 0x0040;
+}
+
+typedef unsigned int y_fpstate_t;
+
+static inline y_fpstate_t
+y_denormals_off(void)
+{
+    y_fpstate_t old = _mm_getcsr();
+
+    _mm_setcsr(old | y_mxcsr_bits);
+    return old;
+}
+
+static inline void
+y_denormals_restore(y_fpstate_t old)
+{
+    _mm_setcsr(old);
+}
+
+#elif defined(__aarch64__)
+
+static void y_denormal_init(void) { }
+
+typedef unsigned long y_fpstate_t;
+
+static inline y_fpstate_t
+y_denormals_off(void)
+{
+    y_fpstate_t old;
+
+    __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (old));
+    __asm__ __volatile__ ("msr fpcr, %0" : : "r" (old | (1UL << 24)));  /* FZ */
+    return old;
+}
+
+static inline void
+y_denormals_restore(y_fpstate_t old)
+{
+    __asm__ __volatile__ ("msr fpcr, %0" : : "r" (old));
+}
+
+#else
+
+/* no flush-to-zero control here, so the buses get Y_DENORMAL_NOISE instead */
+
+static void y_denormal_init(void) { }
+
+typedef int y_fpstate_t;
+
+static inline y_fpstate_t y_denormals_off(void) { return 0; }
+static inline void y_denormals_restore(y_fpstate_t old) { }
+
+#endif
+
+#ifdef Y_DEBUG
+/*
+ * y_count_denormals
+ *
+ * Counts the denormal samples in a buffer.  This tests the bits directly,
+ * since -ffast-math lets the compiler assume fpclassify() never sees one.
+ */
+static unsigned long
+y_count_denormals(const LADSPA_Data *buffer, unsigned long sample_count)
+{
+    union { float f; uint32_t i; } u;
+    unsigned long i, count = 0;
+
+    for (i = 0; i < sample_count; i++) {
+        u.f = buffer[i];
+        if ((u.i & 0x7f800000) == 0 && (u.i & 0x007fffff) != 0)
+            count++;
+    }
+    return count;
+}
+#endif /* Y_DEBUG */
+
+/*
+ * y_run_record_burst
+ *
+ * add a burst's render time, in seconds, to the telemetry histogram
+ */
+static inline void
+y_run_record_burst(y_synth_t *synth, double seconds)
+{
+    unsigned int us = (unsigned int)(seconds * 1e6);
+    int i = 0;
+
+    while (us && i < Y_TELEMETRY_BURST_BUCKETS - 1) {
+        us >>= 1;
+        i++;
+    }
+    synth->telemetry.burst_time[i]++;
+}
+
+/*
+ * y_event_is_coalescable
+ *
+ * Returns true for those events which only change continuous controller
+ * values.  Since modwheel and pressure changes are ramped to the end of the
+ * control period anyway, and volume and pan changes are ramped across the
+ * burst, these may be handled a few samples early without ending the
+ * render burst.  Pitch bend is a step at the start of the burst, as the
+ * voice pitch (portamento included) is only ever updated once per burst.
+ * Anything that starts, releases, or stops notes must still be handled on
+ * its exact tick.
+ */
+static inline int
+y_event_is_coalescable(snd_seq_event_t *event)
+{
+    switch (event->type) {
+      case SND_SEQ_EVENT_KEYPRESS:
+      case SND_SEQ_EVENT_CHANPRESS:
+      case SND_SEQ_EVENT_PITCHBEND:
+        return 1;
+      case SND_SEQ_EVENT_CONTROLLER:
+        switch (event->data.control.param) {
+          case MIDI_CTL_SUSTAIN:
+          case MIDI_CTL_ALL_SOUNDS_OFF:
+          case MIDI_CTL_RESET_CONTROLLERS:
+          case MIDI_CTL_ALL_NOTES_OFF:
+            return 0;
+          default:
+            return 1;
+        }
+      default:
+        return 0;
+    }
+}
+
+/*
+ * y_run_idle_track
+ *
+ * Called after each effect block with the block's own output (before any
+ * adding into the host's buffers), to count how long no voices have been playing
+ * and the output has stayed below the idle threshold.
+ */
+static inline void
+y_run_idle_track(y_synth_t *synth, LADSPA_Data *out_left,
+                 LADSPA_Data *out_right, unsigned long sample_count)
+{
+    unsigned long i;
+    float peak = 0.0f;
+
+    if (synth->active_voices ||
+        synth->effect_region_pending ||  /* effect region still dirty */
+        synth->effect_bus == Y_EFFECT_BUS_RETURN) {  /* others may still be sending */
+        synth->idle_samples = 0;
+        return;
+    }
+
+    for (i = 0; i < sample_count; i++) {
+        float l = out_left[i],
+              r = out_right[i];
+        if (l * l > peak) peak = l * l;
+        if (r * r > peak) peak = r * r;
+    }
+    if (peak >= synth->idle_threshold)
+        synth->idle_samples = 0;
+    else
+        synth->idle_samples += sample_count;
+}
+
+/*
+ * y_run_idle_check
+ *
+ * Called at the end of each (non-idle) run.  Once the instance has been
+ * silent for idle_hold samples, it goes idle: y_run_instance() then outputs
+ * silence without rendering anything, until it receives an event or one of
+ * its control ports changes.
+ */
+static void
+y_run_idle_check(y_synth_t *synth)
+{
+    int i;
+
+    if (synth->idle_samples >= synth->idle_hold) {
+        for (i = Y_PORT_OUTPUT_RIGHT + 1; i < Y_PORTS_COUNT; i++)
+            synth->idle_port_value[i] = *(synth->port[i]);
+        synth->idle = 1;
+    }
+}
+
+/*
+ * y_run_idle_ports_changed
+ */
+static inline int
+y_run_idle_ports_changed(y_synth_t *synth)
+{
+    int i;
+
+    for (i = Y_PORT_OUTPUT_RIGHT + 1; i < Y_PORTS_COUNT; i++)
+        if (*(synth->port[i]) != synth->idle_port_value[i])
+            return 1;
+    return 0;
+}
+
+/*
+ * y_run_effects
+ *
+ * Runs the effects over the sample_count samples accumulated in the voice
+ * bus, writing them to the output buffers at 'offset', or, if 'adding' is
+ * true, adding them there scaled by the run_adding gain.  The shared effect
+ * bus is used only if 'shared' is true.
+ */
+static void
+y_run_effects(y_synth_t *synth, unsigned long offset,
+              unsigned long sample_count, int adding, int shared)
+{
+    LADSPA_Data *out_left, *out_right;
+    unsigned long i;
+
+#ifdef Y_DENORMAL_NOISE
+    synth->voice_bus_l[0] += 1e-20f; /* ''' bubbling of the quantum foam ,,, */
+    synth->voice_bus_r[0] += 1e-20f;
+    synth->voice_bus_l[sample_count >> 1] -= 1e-20f;
+    synth->voice_bus_r[sample_count >> 1] -= 1e-20f;
+#endif
+
+    if (adding) {
+        LADSPA_Data gain = synth->run_adding_gain;
+        LADSPA_Data *adding_bus = synth->adding_bus;
+
+        if (adding_bus) {
+            out_left  = adding_bus;
+            out_right = adding_bus + Y_EFFECT_BUS_LENGTH;
+        } else {
+            /* until the worker thread has allocated the adding bus,
+             * y_run_instance() keeps the blocks short enough for these */
+            out_left  = synth->vcf1_out;
+            out_right = synth->vcf2_out;
+        }
+        if (shared)
+            y_synth_process_effect_bus(synth, offset, out_left, out_right, sample_count);
+        else
+            y_synth_process_effects(synth, out_left, out_right, sample_count);
+        for (i = 0; i < sample_count; i++) {
+            synth->output_left[offset + i]  += gain * out_left[i];
+            synth->output_right[offset + i] += gain * out_right[i];
+        }
+    } else {
+        out_left  = synth->output_left + offset;
+        out_right = synth->output_right + offset;
+        if (shared)
+            y_synth_process_effect_bus(synth, offset, out_left, out_right, sample_count);
+        else
+            y_synth_process_effects(synth, out_left, out_right, sample_count);
+    }
+    y_run_idle_track(synth, out_left, out_right, sample_count);
+#ifdef Y_DEBUG
+    synth->telemetry.denormals += y_count_denormals(out_left, sample_count) +
+                                  y_count_denormals(out_right, sample_count);
+#endif
+}
+
+/*
+ * y_run_instance
+ *
+ * Runs one instance for one buffer, either replacing the contents of the
+ * output buffers, or, if 'adding' is true, adding to them, scaled by the
+ * run_adding gain.  The caller is responsible for the denormal mode.
+ */
+static void
+y_run_instance(y_synth_t *synth, unsigned long sample_count,
+               snd_seq_event_t *events, unsigned long event_count, int adding)
 {
-    y_synth_t *synth = (y_synth_t *)instance;
     unsigned long samples_done = 0;
     unsigned long event_index = 0;
+    unsigned long bus_fill = 0;
     unsigned long burst_size;
+    double start_time, burst_start_time, burst_time, voice_time = 0.0, now;
+    float load;
+    /* blocks are placed on the shared effect bus by their offset within the
+     * buffer, so a buffer longer than the bus would overlap itself there;
+     * such buffers get the instance's own effect instead */
+    int shared = (synth->effect_bus && sample_count <= Y_SHARED_BUS_LENGTH);
+    unsigned long bus_length = Y_EFFECT_BUS_LENGTH;
 
     /* attempt the mutex, return only silence if lock fails. */
     if (dssp_voicelist_mutex_trylock(synth)) {
-        memset(synth->output_left,  0, sizeof(LADSPA_Data) * sample_count);
-        memset(synth->output_right, 0, sizeof(LADSPA_Data) * sample_count);
+        if (!adding) {
+            memset(synth->output_left,  0, sizeof(LADSPA_Data) * sample_count);
+            memset(synth->output_right, 0, sizeof(LADSPA_Data) * sample_count);
+        }
+        synth->telemetry.trylock_failures++;
         return;
     }
 
+    start_time = y_time_now();
+
+    if (synth->telemetry_reset) {
+        memset(&synth->telemetry, 0, sizeof(struct y_telemetry));
+        synth->telemetry_reset = 0;
+    }
+
     if (synth->pending_patch_change > -1)
         dssp_handle_pending_patch_change(synth);
 
+    if (synth->idle) {
+        if (!event_count && !y_run_idle_ports_changed(synth)) {
+            /* nothing to do but output silence */
+            if (!adding) {
+                memset(synth->output_left,  0, sizeof(LADSPA_Data) * sample_count);
+                memset(synth->output_right, 0, sizeof(LADSPA_Data) * sample_count);
+            }
+            synth->telemetry.idle_runs++;
+            dssp_voicelist_mutex_unlock(synth);
+            return;
+        }
+        synth->idle = 0;  /* wake up, and render this run normally */
+    }
+
+    if (adding && !synth->adding_bus) {
+        /* first use of run_adding: ask the worker thread for the adding
+         * bus, and meanwhile run the effects in blocks short enough to use
+         * the VCF output buffers in its place */
+        if (!synth->adding_bus_wanted) {
+            synth->adding_bus_wanted = 1;
+            sampleset_signal_worker();
+        }
+        bus_length = Y_CONTROL_PERIOD;
+    }
+
     while (samples_done < sample_count) {
-        if (!synth->control_remains)
+        if (!synth->control_remains) {
+            /* top of a new control period */
             synth->control_remains = Y_CONTROL_PERIOD;
+            y_synth_control_update(synth);
+        }
 
-        /* process any ready events */
-	while (event_index < event_count
-	       && samples_done == events[event_index].time.tick) {
+        /* process any ready events, plus any controller events that fall
+         * within both the coalescing tolerance and the current control
+         * period, stopping at the first event that must wait for its tick */
+        while (event_index < event_count
+               && (samples_done == events[event_index].time.tick
+                   || (events[event_index].time.tick - samples_done <= synth->event_tolerance
+                       && events[event_index].time.tick - samples_done < synth->control_remains
+                       && y_event_is_coalescable(&events[event_index])))) {
             y_handle_event(synth, &events[event_index]);
             event_index++;
         }
@@ -789,8 +1350,10 @@ y_run_synth(LADSPA_Handle instance, unsigned long sample_count,
          *     samples)
          * - the number of samples remaining in an already-begun control cycle
          *     (synth->control_remains)
-         * - the number of samples until the next event is ready
+         * - the number of samples until the next event is ready (other than
+         *     the controller events already coalesced above)
          * - the number of samples left in this run
+         * - the room left in the voice bus
          */
         burst_size = Y_CONTROL_PERIOD;
         if (synth->control_remains < burst_size) {
@@ -807,14 +1370,40 @@ y_run_synth(LADSPA_Handle instance, unsigned long sample_count,
             /* reduce burst size to end at end of this run */
             burst_size = sample_count - samples_done;
         }
+        if (bus_length - bus_fill < burst_size) {
+            /* reduce burst size to end when the voice bus is full */
+            burst_size = bus_length - bus_fill;
+        }
 
-        /* render the burst */
-        y_synth_render_voices(synth, synth->output_left + samples_done,
-                                   synth->output_right + samples_done, burst_size,
-                                   (burst_size == synth->control_remains));
+        /* render the voices for this burst onto the end of the voice bus */
+        burst_start_time = y_time_now();
+        y_synth_render_voices(synth, synth->voice_bus_l + bus_fill,
+                              synth->voice_bus_r + bus_fill, burst_size);
+        burst_time = y_time_now() - burst_start_time;
+        y_run_record_burst(synth, burst_time);
+        voice_time += burst_time;
         samples_done += burst_size;
+        bus_fill += burst_size;
         synth->control_remains -= burst_size;
+
+        /* once the bus is full or the run is done, run the effects over
+         * everything accumulated so far */
+        if (bus_fill == bus_length || samples_done == sample_count) {
+            y_run_effects(synth, samples_done - bus_fill, bus_fill, adding,
+                          shared);
+            bus_fill = 0;
+        }
+    }
+
+    /* compare our run time to the time the buffer will take to play */
+    if (sample_count) {
+        now = y_time_now();
+        load = (float)(now - start_time) / ((float)sample_count * synth->deltat);
+        y_synth_record_run(synth, load);
+        y_synth_govern_polyphony(synth, load,
+                                 (float)voice_time / ((float)sample_count * synth->deltat));
     }
+    y_run_idle_check(synth);
 #if defined(Y_DEBUG) && (Y_DEBUG & YDB_AUDIO)
 *synth->output_left  += 0.10f; /* add a 'buzz' to output so there's something audible even when quiescent */
 *synth->output_right += 0.10f;
@@ -823,11 +1412,97 @@ y_run_synth(LADSPA_Handle instance, unsigned long sample_count,
     dssp_voicelist_mutex_unlock(synth);
 }
 
-// optional:
-//    void (*run_synth_adding)(LADSPA_Handle    Instance,
-//                             unsigned long    SampleCount,
-//                             snd_seq_event_t *Events,
-//                             unsigned long    EventCount);
+/*
+ * y_run_synth
+ *
+ * implements DSSI (*run_synth)()
+ */
+static void
+y_run_synth(LADSPA_Handle instance, unsigned long sample_count,
+                 snd_seq_event_t *events, unsigned long event_count)
+{
+    y_fpstate_t fpstate = y_denormals_off();
+
+    y_run_instance((y_synth_t *)instance, sample_count, events, event_count, 0);
+
+    y_denormals_restore(fpstate);
+}
+
+/*
+ * y_run_synth_adding
+ *
+ * implements DSSI (*run_synth_adding)()
+ */
+static void
+y_run_synth_adding(LADSPA_Handle instance, unsigned long sample_count,
+                   snd_seq_event_t *events, unsigned long event_count)
+{
+    y_fpstate_t fpstate = y_denormals_off();
+
+    y_run_instance((y_synth_t *)instance, sample_count, events, event_count, 1);
+
+    y_denormals_restore(fpstate);
+}
+
+/*
+ * y_run_multiple_synths
+ *
+ * implements DSSI (*run_multiple_synths)()
+ *
+ * Runs each instance in turn, so that the wave, sine, and filter tables the
+ * first one pulls into the cache are still warm for the rest, and the FPU
+ * mode is switched only once for the whole batch.
+ */
+static void
+y_run_multiple_synths(unsigned long instance_count, LADSPA_Handle *instances,
+                      unsigned long sample_count, snd_seq_event_t **events,
+                      unsigned long *event_counts)
+{
+    y_fpstate_t fpstate = y_denormals_off();
+    unsigned long i, ret = instance_count;
+
+    /* run any shared effect bus return last, so it hears every send */
+    for (i = 0; i < instance_count; i++) {
+        if ((y_synth_t *)instances[i] == global.effect_bus_return)
+            ret = i;
+        else
+            y_run_instance((y_synth_t *)instances[i], sample_count,
+                           events[i], event_counts[i], 0);
+    }
+    if (ret < instance_count)
+        y_run_instance((y_synth_t *)instances[ret], sample_count,
+                       events[ret], event_counts[ret], 0);
+
+    y_denormals_restore(fpstate);
+}
+
+/*
+ * y_run_multiple_synths_adding
+ *
+ * implements DSSI (*run_multiple_synths_adding)()
+ */
+static void
+y_run_multiple_synths_adding(unsigned long instance_count, LADSPA_Handle *instances,
+                             unsigned long sample_count, snd_seq_event_t **events,
+                             unsigned long *event_counts)
+{
+    y_fpstate_t fpstate = y_denormals_off();
+    unsigned long i, ret = instance_count;
+
+    /* run any shared effect bus return last, so it hears every send */
+    for (i = 0; i < instance_count; i++) {
+        if ((y_synth_t *)instances[i] == global.effect_bus_return)
+            ret = i;
+        else
+            y_run_instance((y_synth_t *)instances[i], sample_count,
+                           events[i], event_counts[i], 1);
+    }
+    if (ret < instance_count)
+        y_run_instance((y_synth_t *)instances[ret], sample_count,
+                       events[ret], event_counts[ret], 1);
+
+    y_denormals_restore(fpstate);
+}
 
 /* ---- export ---- */
 
@@ -867,6 +1542,7 @@ void _init()
     pthread_mutex_init(&global_mutex, NULL);
     global.initialized = 0;
     y_init_tables();
+    y_denormal_init();
     wave_tables_set_count();
 
     y_LADSPA_descriptor =
@@ -917,8 +1593,8 @@ void _init()
         y_LADSPA_descriptor->connect_port = y_connect_port;
         y_LADSPA_descriptor->activate = y_activate;
         y_LADSPA_descriptor->run = y_ladspa_run_wrapper;
-        y_LADSPA_descriptor->run_adding = NULL;
-        y_LADSPA_descriptor->set_run_adding_gain = NULL;
+        y_LADSPA_descriptor->run_adding = y_ladspa_run_adding_wrapper;
+        y_LADSPA_descriptor->set_run_adding_gain = y_set_run_adding_gain;
         y_LADSPA_descriptor->deactivate = y_deactivate;
         y_LADSPA_descriptor->cleanup = y_cleanup;
     }
@@ -932,9 +1608,9 @@ void _init()
         y_DSSI_descriptor->select_program = y_select_program;
         y_DSSI_descriptor->get_midi_controller_for_port = y_get_midi_controller;
         y_DSSI_descriptor->run_synth = y_run_synth;
-        y_DSSI_descriptor->run_synth_adding = NULL;
-        y_DSSI_descriptor->run_multiple_synths = NULL;
-        y_DSSI_descriptor->run_multiple_synths_adding = NULL;
+        y_DSSI_descriptor->run_synth_adding = y_run_synth_adding;
+        y_DSSI_descriptor->run_multiple_synths = y_run_multiple_synths;
+        y_DSSI_descriptor->run_multiple_synths_adding = y_run_multiple_synths_adding;
     }
 }
 
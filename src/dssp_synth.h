@@ -29,5 +29,7 @@
 int   dssp_voicelist_mutex_lock(y_synth_t *synth);
 int   dssp_voicelist_mutex_unlock(y_synth_t *synth);
 char *dssi_configure_message(const char *fmt, ...);
+int   y_synth_add_parts(y_synth_t *synth);
+void  y_synth_add_adding_bus(y_synth_t *synth);
 
 #endif /* _DSSP_SYNTH_H */
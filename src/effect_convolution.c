@@ -0,0 +1,887 @@
+/* WhySynth DSSI software synthesizer plugin
+ *
+ * Copyright (C) 2017 Sean Bolton and others.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/* Convolution reverb.
+ *
+ * The impulse response (IR) is split into three parts, so that long IRs
+ * cost little in the audio thread yet add no latency:
+ *
+ * - the head, the first CONV_HEAD_LENGTH taps, is convolved directly, one
+ *     sample at a time;
+ * - stage 1 covers the IR up to CONV_TAIL_START with uniform partitions of
+ *     CONV_HEAD_LENGTH samples, convolved in the frequency domain by the
+ *     audio thread at the end of each CONV_HEAD_LENGTH-sample block;
+ * - stage 2 covers the rest of the IR with partitions of CONV_TAIL_PART
+ *     samples.  Since it starts two of its blocks into the IR, each of its
+ *     blocks may be computed by a background thread while the next block of
+ *     input arrives, and the result is not needed until the block after
+ *     that.  Input blocks are queued for the thread, which owns the stage 2
+ *     state; the audio thread never waits for it.  Should a block's result
+ *     not be ready when it is needed, that block of the tail is left silent,
+ *     and should the queue fill, stage 2 restarts from fresh input.
+ *
+ * Both stages use uniformly-partitioned overlap-save convolution with a
+ * frequency-domain delay line (FDL) of past input spectra.  The spectra are
+ * kept with the real parts in the first half and the imaginary parts in the
+ * second, so that the multiply-accumulate loops vectorize. */
+
+#define _DEFAULT_SOURCE 1
+#define _ISOC99_SOURCE  1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <ladspa.h>
+
+#ifdef FFTW_VERSION_2
+#include <rfftw.h>
+#define fftwf_malloc(x) malloc(x)
+#define fftwf_free(x) free(x)
+#else
+#include <fftw3.h>
+#endif
+
+#include "whysynth_types.h"
+#include "whysynth.h"
+#include "dssp_synth.h"
+#include "dssp_event.h"
+#include "effects.h"
+
+#define CONV_HEAD_LENGTH     64  /* direct-form taps, and stage 1 partition size */
+#define CONV_TAIL_PART     1024  /* stage 2 partition size */
+#define CONV_TAIL_START    (2 * CONV_TAIL_PART)  /* IR offset at which stage 2 begins */
+#define CONV_MAX_SECONDS     20  /* longer impulse responses are truncated */
+
+#define CONV_QUEUE_LENGTH     4  /* stage 2 blocks queued for the background thread */
+
+struct conv_stage {
+    int    size;          /* partition size, P; the transforms are 2P long */
+    int    parts;         /* number of partitions */
+    int    current;       /* FDL slot holding the newest input spectrum */
+    int    valid;         /* FDL slots filled since the last reset */
+    float *ir[2];         /* IR partition spectra, prescaled for the inverse transform */
+    float *fdl[2];        /* input spectra */
+    float *in[2];         /* the last 2P input samples */
+    float *out[2];        /* P output samples from the last block */
+    float *time,          /* transform buffers */
+          *spec;
+    void  *fft_plan,
+          *ifft_plan;
+};
+
+struct _y_convolver_t {
+    float             head[2][CONV_HEAD_LENGTH];  /* time-reversed first taps */
+    struct conv_stage stage1,
+                      stage2;
+    int               pos1,                       /* position within current stage 1 block */
+                      pos2;                       /* position within current stage 2 block */
+    float             feed[2][CONV_TAIL_PART];    /* stage 2 input for the next block */
+    float             tail[2][CONV_TAIL_PART];    /* stage 2 output for the current block */
+
+    /* background thread, used only if there is a stage 2 */
+    int               thread_started;
+    pthread_t         thread;
+    int               wake_fd[2];                 /* audio thread -> worker */
+    volatile int      quit;
+
+    /* stage 2 job queue: job j's input is in queue_in[j % CONV_QUEUE_LENGTH],
+     * and the worker leaves its result in the same slot of queue_out */
+    float             queue_in[CONV_QUEUE_LENGTH][2][CONV_TAIL_PART];
+    float             queue_out[CONV_QUEUE_LENGTH][2][CONV_TAIL_PART];
+    int               queue_restart[CONV_QUEUE_LENGTH]; /* reset stage 2 before this job */
+    volatile unsigned int dispatched,             /* jobs queued, by the audio thread */
+                      processed;                  /* jobs done, by the worker */
+    unsigned int      last_job;                   /* job whose result is needed next */
+    int               last_job_valid;             /*   if any */
+    int               restart;                    /* reset stage 2 before the next job */
+};
+
+/* ==== FFT plans ==== */
+
+static void *
+conv_plan(int n, float *in, float *out, int inverse)
+{
+    void *plan;
+
+    /* FFTW's planner is not thread-safe, and padsynth may be planning in
+     * the sampleset worker thread */
+    pthread_mutex_lock(&global.fftw_planner_mutex);
+#ifdef FFTW_VERSION_2
+    plan = (void *)rfftw_create_plan(n, inverse ? FFTW_COMPLEX_TO_REAL : FFTW_REAL_TO_COMPLEX,
+                                     FFTW_ESTIMATE);
+#else
+    plan = (void *)fftwf_plan_r2r_1d(n, in, out, inverse ? FFTW_HC2R : FFTW_R2HC,
+                                     FFTW_ESTIMATE);
+#endif
+    pthread_mutex_unlock(&global.fftw_planner_mutex);
+
+    return plan;
+}
+
+static void
+conv_destroy_plan(void *plan)
+{
+    if (!plan) return;
+    pthread_mutex_lock(&global.fftw_planner_mutex);
+#ifdef FFTW_VERSION_2
+    rfftw_destroy_plan((rfftw_plan)plan);
+#else
+    fftwf_destroy_plan((fftwf_plan)plan);
+#endif
+    pthread_mutex_unlock(&global.fftw_planner_mutex);
+}
+
+static inline void
+conv_execute(void *plan, float *in, float *out)
+{
+#ifdef FFTW_VERSION_2
+    rfftw_one((rfftw_plan)plan, in, out);
+#else
+    fftwf_execute((const fftwf_plan)plan);  /* planned on in and out */
+#endif
+}
+
+/* ==== partitioned convolution stages ==== */
+
+/*
+ * conv_stage_hc_to_split
+ *
+ * Converts a 2P-point halfcomplex spectrum to the split layout, with real
+ * parts 0..P at [0..P], and imaginary parts 1..P-1 at [P+1..2P-1].  In
+ * halfcomplex order the imaginary parts are reversed, so this (and its
+ * inverse) is just a reversal of the upper half.
+ */
+static inline void
+conv_stage_hc_to_split(float *spec, int size)
+{
+    float *a = spec + size + 1,
+          *b = spec + 2 * size - 1,
+          t;
+
+    while (a < b) {
+        t = *a; *a++ = *b; *b-- = t;
+    }
+}
+
+/*
+ * conv_stage_init
+ *
+ * Allocates a stage of 'parts' partitions of 'size' samples, covering the
+ * IR from 'offset', and transforms its IR partitions.  The input and output
+ * buffers are always allocated, even if the stage has no partitions.
+ */
+static int
+conv_stage_init(struct conv_stage *s, int size, int parts, float *ir[2],
+                int ir_channels, long ir_length, long offset)
+{
+    int N = 2 * size, c, k, i;
+
+    s->size = size;
+    s->parts = parts;
+    for (c = 0; c < 2; c++) {
+        s->in[c]  = (float *)calloc(N, sizeof(float));
+        s->out[c] = (float *)calloc(size, sizeof(float));
+        if (!s->in[c] || !s->out[c])
+            return 0;
+    }
+    if (!parts)
+        return 1;
+
+    s->time = (float *)fftwf_malloc(N * sizeof(float));
+    s->spec = (float *)fftwf_malloc(N * sizeof(float));
+    if (!s->time || !s->spec)
+        return 0;
+    s->fft_plan  = conv_plan(N, s->time, s->spec, 0);
+    s->ifft_plan = conv_plan(N, s->spec, s->time, 1);
+    if (!s->fft_plan || !s->ifft_plan)
+        return 0;
+
+    for (c = 0; c < 2; c++) {
+        s->fdl[c] = (float *)calloc((size_t)parts * N, sizeof(float));
+        if (!s->fdl[c])
+            return 0;
+        if (c >= ir_channels) {  /* mono IR: share the left spectra */
+            s->ir[c] = s->ir[0];
+            continue;
+        }
+        s->ir[c] = (float *)calloc((size_t)parts * N, sizeof(float));
+        if (!s->ir[c])
+            return 0;
+        for (k = 0; k < parts; k++) {
+            long start = offset + (long)k * size;
+            float *h = s->ir[c] + (size_t)k * N;
+
+            for (i = 0; i < size; i++)
+                s->time[i] = (start + i < ir_length ? ir[c][start + i] : 0.0f);
+            for (; i < N; i++)
+                s->time[i] = 0.0f;
+            conv_execute(s->fft_plan, s->time, s->spec);
+            for (i = 0; i < N; i++)
+                h[i] = s->spec[i] / (float)N;  /* FFTW's inverse is unnormalized */
+            conv_stage_hc_to_split(h, size);
+        }
+    }
+
+    return 1;
+}
+
+static void
+conv_stage_free(struct conv_stage *s)
+{
+    int c;
+
+    conv_destroy_plan(s->fft_plan);
+    conv_destroy_plan(s->ifft_plan);
+    if (s->time) fftwf_free(s->time);
+    if (s->spec) fftwf_free(s->spec);
+    for (c = 0; c < 2; c++) {
+        if (s->in[c])  free(s->in[c]);
+        if (s->out[c]) free(s->out[c]);
+        if (s->fdl[c]) free(s->fdl[c]);
+    }
+    if (s->ir[1] && s->ir[1] != s->ir[0]) free(s->ir[1]);
+    if (s->ir[0]) free(s->ir[0]);
+}
+
+static void
+conv_stage_reset(struct conv_stage *s)
+{
+    int c;
+
+    s->current = 0;
+    s->valid = 0;  /* the FDL contents are ignored until refilled */
+    for (c = 0; c < 2; c++) {
+        memset(s->in[c],  0, 2 * s->size * sizeof(float));
+        memset(s->out[c], 0, s->size * sizeof(float));
+    }
+}
+
+/*
+ * conv_stage_process
+ *
+ * Transforms the last 2P input samples into the FDL, convolves the FDL with
+ * the IR partitions, and leaves the last P samples of the result, which are
+ * uncorrupted by circular wrap-around, in out[].
+ */
+static void
+conv_stage_process(struct conv_stage *s)
+{
+    int P = s->size, N = 2 * P, c, k, i, slot;
+
+    if (++s->current == s->parts)
+        s->current = 0;
+    if (s->valid < s->parts)
+        s->valid++;
+
+    for (c = 0; c < 2; c++) {
+        float *acc = s->spec,
+              *x, *h;
+
+        memcpy(s->time, s->in[c], N * sizeof(float));
+        conv_execute(s->fft_plan, s->time, s->spec);
+        x = s->fdl[c] + (size_t)s->current * N;
+        memcpy(x, s->spec, N * sizeof(float));
+        conv_stage_hc_to_split(x, P);
+
+        memset(acc, 0, N * sizeof(float));
+        slot = s->current;
+        for (k = 0; k < s->valid; k++) {
+            x = s->fdl[c] + (size_t)slot * N;
+            h = s->ir[c] + (size_t)k * N;
+            acc[0] += x[0] * h[0];
+            acc[P] += x[P] * h[P];
+            for (i = 1; i < P; i++) {
+                float xr = x[i], xi = x[P + i],
+                      hr = h[i], hi = h[P + i];
+                acc[i]     += xr * hr - xi * hi;
+                acc[P + i] += xr * hi + xi * hr;
+            }
+            if (--slot < 0)
+                slot = s->parts - 1;
+        }
+
+        conv_stage_hc_to_split(acc, P);  /* back to halfcomplex */
+        conv_execute(s->ifft_plan, s->spec, s->time);
+        memcpy(s->out[c], s->time + P, P * sizeof(float));
+    }
+}
+
+/* ==== stage 2 background thread ==== */
+
+/*
+ * conv_run_job
+ *
+ * Runs stage 2 on the next queued input block.  Called only by the worker,
+ * which alone touches the stage 2 state.
+ */
+static void
+conv_run_job(y_convolver_t *conv, unsigned int job)
+{
+    struct conv_stage *s = &conv->stage2;
+    int slot = job % CONV_QUEUE_LENGTH, ch;
+
+    if (conv->queue_restart[slot])
+        conv_stage_reset(s);
+    for (ch = 0; ch < 2; ch++) {
+        memmove(s->in[ch], s->in[ch] + CONV_TAIL_PART, CONV_TAIL_PART * sizeof(float));
+        memcpy(s->in[ch] + CONV_TAIL_PART, conv->queue_in[slot][ch], CONV_TAIL_PART * sizeof(float));
+    }
+    conv_stage_process(s);
+    for (ch = 0; ch < 2; ch++)
+        memcpy(conv->queue_out[slot][ch], s->out[ch], CONV_TAIL_PART * sizeof(float));
+}
+
+static void *
+conv_worker_function(void *arg)
+{
+    y_convolver_t *conv = (y_convolver_t *)arg;
+    unsigned int job;
+    char c = 0;
+    ssize_t rc;
+
+    while (1) {
+        rc = read(conv->wake_fd[0], &c, 1);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc != 1 || conv->quit)
+            break;
+
+        while ((job = conv->processed) != conv->dispatched && !conv->quit) {
+            __sync_synchronize();  /* see the queued input */
+            conv_run_job(conv, job);
+            __sync_synchronize();  /* publish the result */
+            conv->processed = job + 1;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * conv_collect
+ *
+ * Copies the result of the last stage 2 job into the tail for the next
+ * block, if the worker has finished it, or silences the tail if not.  This
+ * never waits for the worker.
+ */
+static void
+conv_collect(y_convolver_t *conv)
+{
+    int c, slot;
+
+    if (conv->last_job_valid &&
+        (int)(conv->processed - conv->last_job) > 0) {
+        __sync_synchronize();  /* see the worker's result */
+        slot = conv->last_job % CONV_QUEUE_LENGTH;
+        for (c = 0; c < 2; c++)
+            memcpy(conv->tail[c], conv->queue_out[slot][c], CONV_TAIL_PART * sizeof(float));
+    } else {
+        for (c = 0; c < 2; c++)
+            memset(conv->tail[c], 0, CONV_TAIL_PART * sizeof(float));
+    }
+    conv->last_job_valid = 0;
+}
+
+/*
+ * conv_dispatch
+ *
+ * Queues the stage 2 input block just completed for the worker.  If the
+ * queue is full, the block is dropped, and stage 2 restarts with the next.
+ */
+static void
+conv_dispatch(y_convolver_t *conv)
+{
+    unsigned int job = conv->dispatched;
+    int slot = job % CONV_QUEUE_LENGTH, ch;
+    char c = 0;
+
+    if (job - conv->processed >= CONV_QUEUE_LENGTH) {
+        conv->restart = 1;
+        return;
+    }
+
+    for (ch = 0; ch < 2; ch++)
+        memcpy(conv->queue_in[slot][ch], conv->feed[ch], CONV_TAIL_PART * sizeof(float));
+    conv->queue_restart[slot] = conv->restart;
+    conv->restart = 0;
+    __sync_synchronize();
+    conv->dispatched = job + 1;
+    conv->last_job = job;
+    conv->last_job_valid = 1;
+    /* the write end is nonblocking; if the pipe is full, the worker already
+     * has wake-ups enough */
+    if (write(conv->wake_fd[1], &c, 1) != 1) {
+        YDB_MESSAGE(-1, " conv_dispatch: cannot write pipe: %s\n", strerror(errno));
+    }
+}
+
+/* ==== convolver creation and destruction (non-realtime) ==== */
+
+static void
+y_convolver_free(y_convolver_t *conv)
+{
+    char c = 0;
+
+    if (!conv) return;
+
+    if (conv->thread_started) {
+        conv->quit = 1;
+        if (write(conv->wake_fd[1], &c, 1) != 1) {
+            YDB_MESSAGE(-1, " y_convolver_free: cannot write pipe: %s\n", strerror(errno));
+        }
+        pthread_join(conv->thread, NULL);
+    }
+    if (conv->wake_fd[0] >= 0) close(conv->wake_fd[0]);
+    if (conv->wake_fd[1] >= 0) close(conv->wake_fd[1]);
+
+    conv_stage_free(&conv->stage1);
+    conv_stage_free(&conv->stage2);
+    free(conv);
+}
+
+static y_convolver_t *
+y_convolver_new(float *ir[2], int ir_channels, long ir_length)
+{
+    y_convolver_t *conv = (y_convolver_t *)calloc(1, sizeof(y_convolver_t));
+    int c, i, parts1, parts2;
+
+    if (!conv) return NULL;
+    conv->wake_fd[0] = conv->wake_fd[1] = -1;
+    conv->restart = 1;
+
+    for (c = 0; c < 2; c++) {
+        float *h = ir[c < ir_channels ? c : 0];
+
+        for (i = 0; i < CONV_HEAD_LENGTH; i++)
+            conv->head[c][CONV_HEAD_LENGTH - 1 - i] = (i < ir_length ? h[i] : 0.0f);
+    }
+
+    parts1 = 0;
+    if (ir_length > CONV_HEAD_LENGTH) {
+        long l = (ir_length < CONV_TAIL_START ? ir_length : CONV_TAIL_START);
+        parts1 = (l - CONV_HEAD_LENGTH + CONV_HEAD_LENGTH - 1) / CONV_HEAD_LENGTH;
+    }
+    parts2 = 0;
+    if (ir_length > CONV_TAIL_START)
+        parts2 = (ir_length - CONV_TAIL_START + CONV_TAIL_PART - 1) / CONV_TAIL_PART;
+
+    if (!conv_stage_init(&conv->stage1, CONV_HEAD_LENGTH, parts1, ir, ir_channels,
+                         ir_length, CONV_HEAD_LENGTH) ||
+        !conv_stage_init(&conv->stage2, CONV_TAIL_PART, parts2, ir, ir_channels,
+                         ir_length, CONV_TAIL_START)) {
+        y_convolver_free(conv);
+        return NULL;
+    }
+
+    if (parts2) {
+        if (pipe(conv->wake_fd) ||
+            fcntl(conv->wake_fd[1], F_SETFL, O_NONBLOCK)) {
+            YDB_MESSAGE(-1, " y_convolver_new: could not open signal pipe: %s\n", strerror(errno));
+            y_convolver_free(conv);
+            return NULL;
+        }
+        if (pthread_create(&conv->thread, NULL, conv_worker_function, conv)) {
+            YDB_MESSAGE(-1, " y_convolver_new: could not create worker thread: %s\n", strerror(errno));
+            y_convolver_free(conv);
+            return NULL;
+        }
+        conv->thread_started = 1;
+    }
+
+    return conv;
+}
+
+/* ==== impulse response file reading ==== */
+
+static inline uint16_t
+le16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t
+le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * conv_read_wav
+ *
+ * Reads up to two channels of a RIFF WAVE file, in 8-, 16-, 24-, or 32-bit
+ * integer, or 32- or 64-bit floating point format, into newly allocated
+ * arrays.  Returns NULL on success, or an error message.
+ */
+static const char *
+conv_read_wav(const char *filename, float *ir[2], int *channels,
+              long *frames, unsigned long *rate)
+{
+    FILE *fp;
+    unsigned char hdr[40], *data = NULL;
+    unsigned long size, data_size = 0;
+    unsigned int format = 0, file_channels = 0, bits = 0, block_align = 0;
+    long i, n;
+    int c;
+
+    ir[0] = ir[1] = NULL;
+    *rate = 0;
+    if (!(fp = fopen(filename, "rb")))
+        return "could not open file";
+    if (fread(hdr, 1, 12, fp) != 12 ||
+        memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fclose(fp);
+        return "not a RIFF WAVE file";
+    }
+
+    while (fread(hdr, 1, 8, fp) == 8) {
+        size = le32(hdr + 4);
+        if (!memcmp(hdr, "fmt ", 4) && size >= 16) {
+            unsigned long want = (size < sizeof(hdr) ? size : sizeof(hdr));
+
+            if (fread(hdr, 1, want, fp) != want)
+                break;
+            format        = le16(hdr);
+            file_channels = le16(hdr + 2);
+            *rate         = le32(hdr + 4);
+            block_align   = le16(hdr + 12);
+            bits          = le16(hdr + 14);
+            if (format == 0xfffe && want >= 26)  /* WAVE_FORMAT_EXTENSIBLE */
+                format = le16(hdr + 24);
+            size -= want;
+        } else if (!memcmp(hdr, "data", 4) && format) {
+            if (!(data = (unsigned char *)malloc(size ? size : 1)))
+                break;
+            data_size = fread(data, 1, size, fp);  /* accept a truncated file */
+            break;
+        }
+        if (fseek(fp, size + (size & 1), SEEK_CUR))
+            break;
+    }
+    fclose(fp);
+
+    if (!data) {
+        return "no audio data found";
+    }
+    if (!((format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+          (format == 3 && (bits == 32 || bits == 64))) ||
+        file_channels < 1 || block_align < file_channels * bits / 8 || *rate == 0) {
+        free(data);
+        return "unsupported WAVE format";
+    }
+
+    n = data_size / block_align;
+    if (n > (long)(CONV_MAX_SECONDS * *rate))
+        n = CONV_MAX_SECONDS * *rate;
+    if (n < 1) {
+        free(data);
+        return "no audio data found";
+    }
+    *channels = (file_channels > 1 ? 2 : 1);
+    *frames = n;
+    for (c = 0; c < *channels; c++) {
+        if (!(ir[c] = (float *)malloc(n * sizeof(float)))) {
+            free(data);
+            free(ir[0]);
+            return "out of memory";
+        }
+        for (i = 0; i < n; i++) {
+            const unsigned char *p = data + i * block_align + c * bits / 8;
+            float v;
+
+            if (format == 3) {
+                if (bits == 32) {
+                    union { uint32_t u; float f; } u32;
+                    u32.u = le32(p);
+                    v = u32.f;
+                } else {
+                    union { uint64_t u; double d; } u64;
+                    u64.u = le32(p) | ((uint64_t)le32(p + 4) << 32);
+                    v = (float)u64.d;
+                }
+            } else {
+                switch (bits) {
+                  case 8:   v = (float)((int)p[0] - 128) / 128.0f;                        break;
+                  case 16:  v = (float)(int16_t)le16(p) / 32768.0f;                       break;
+                  case 24:  v = (float)((int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 |
+                                                  (uint32_t)p[2] << 24) >> 8) / 8388608.0f;  break;
+                  default:  v = (float)(int32_t)le32(p) / 2147483648.0f;                  break;
+                }
+            }
+            ir[c][i] = v;
+        }
+    }
+    free(data);
+
+    return NULL;
+}
+
+/*
+ * conv_resample
+ *
+ * Linearly interpolates an impulse response recorded at another rate to the
+ * plugin's rate.  Good enough for the diffuse tail of a room, which is most
+ * of what an IR is; for best results, use IRs recorded at the host's rate.
+ */
+static float *
+conv_resample(float *ir, long frames, double ratio, long *new_frames)
+{
+    long n = (long)ceil((double)frames * ratio), i, j;
+    float *out;
+    double pos, frac;
+
+    if (!(out = (float *)malloc(n * sizeof(float))))
+        return NULL;
+    for (i = 0; i < n; i++) {
+        pos = (double)i / ratio;
+        j = (long)pos;
+        frac = pos - (double)j;
+        out[i] = (j + 1 < frames ? (float)((1.0 - frac) * ir[j] + frac * ir[j + 1])
+                                 : (j < frames ? (float)((1.0 - frac) * ir[j]) : 0.0f));
+    }
+    *new_frames = n;
+    return out;
+}
+
+/*
+ * effect_convolution_load
+ *
+ * Loads an impulse response file and swaps it into the synth, or, if
+ * filename is NULL, removes any loaded IR.  Called from the configure
+ * handler, never from the audio thread.
+ */
+char *
+effect_convolution_load(y_synth_t *synth, const char *filename)
+{
+    y_convolver_t *conv = NULL, *old;
+    float *ir[2], energy, e;
+    const char *error;
+    unsigned long rate;
+    long frames, i;
+    int channels, c;
+
+    if (filename) {
+        if ((error = conv_read_wav(filename, ir, &channels, &frames, &rate)) != NULL)
+            return dssi_configure_message("error: could not load impulse response '%s': %s",
+                                          filename, error);
+
+        if (rate != (unsigned long)lrintf(synth->sample_rate)) {
+            long new_frames = frames;
+
+            for (c = 0; c < channels; c++) {
+                float *r = conv_resample(ir[c], frames, (double)synth->sample_rate / (double)rate,
+                                         &new_frames);
+                if (r) {
+                    free(ir[c]);
+                    ir[c] = r;
+                } else
+                    error = "out of memory";
+            }
+            frames = new_frames;
+        }
+
+        /* normalize to unit energy in the louder channel, so that IRs of
+         * differing lengths and recording levels sound about equally loud */
+        energy = 0.0f;
+        for (c = 0; c < channels; c++) {
+            for (e = 0.0f, i = 0; i < frames; i++)
+                e += ir[c][i] * ir[c][i];
+            if (e > energy) energy = e;
+        }
+        if (energy > 0.0f) {
+            e = 1.0f / sqrtf(energy);
+            for (c = 0; c < channels; c++)
+                for (i = 0; i < frames; i++)
+                    ir[c][i] *= e;
+        }
+
+        if (!error)
+            conv = y_convolver_new(ir, channels, frames);
+        for (c = 0; c < channels; c++)
+            free(ir[c]);
+        if (!conv)
+            return dssi_configure_message("error: could not load impulse response '%s': out of memory",
+                                          filename);
+    }
+
+    dssp_voicelist_mutex_lock(synth);
+    old = synth->convolver;
+    synth->convolver = conv;  /* starts out silent, so needs no reset */
+    dssp_voicelist_mutex_unlock(synth);
+
+    y_convolver_free(old);
+
+    return NULL;
+}
+
+/* ==== effect interface ==== */
+
+/*
+ * effect_convolution_setup
+ *
+ * Called from the audio thread when the effect mode changes to convolution.
+ * The convolver keeps its own buffers, so there is nothing to request from
+ * the effect buffer, and resetting it costs only a few small memsets.
+ */
+void
+effect_convolution_setup(y_synth_t *synth)
+{
+    y_convolver_t *conv = synth->convolver;
+    int c;
+
+    if (!conv) return;
+
+    conv_stage_reset(&conv->stage1);
+    /* stage 2 belongs to the worker, so have it reset that before the next
+     * job, and drop the result of any job still outstanding */
+    conv->restart = 1;
+    conv->last_job_valid = 0;
+    for (c = 0; c < 2; c++) {
+        memset(conv->feed[c], 0, CONV_TAIL_PART * sizeof(float));
+        memset(conv->tail[c], 0, CONV_TAIL_PART * sizeof(float));
+    }
+    conv->pos1 = 0;
+    conv->pos2 = 0;
+}
+
+/*
+ * effect_convolution_cleanup
+ */
+void
+effect_convolution_cleanup(y_synth_t *synth)
+{
+    y_convolver_free(synth->convolver);
+    synth->convolver = NULL;
+}
+
+/*
+ * conv_process
+ *
+ * Convolves up to CONV_HEAD_LENGTH samples, not crossing a stage 1 block
+ * boundary, and runs the stages at the ends of their blocks.
+ */
+static inline void
+conv_process(y_convolver_t *conv, float *in_left, float *in_right,
+             float *out_left, float *out_right, int n)
+{
+    float *in[2] = { in_left, in_right },
+          *out[2] = { out_left, out_right };
+    int c, i, j;
+
+    for (c = 0; c < 2; c++) {
+        float *x  = conv->stage1.in[c] + CONV_HEAD_LENGTH + conv->pos1,
+              *h  = conv->head[c],
+              *s1 = conv->stage1.out[c] + conv->pos1,
+              *s2 = conv->tail[c] + conv->pos2;
+
+        memcpy(x, in[c], n * sizeof(float));
+        memcpy(conv->feed[c] + conv->pos2, in[c], n * sizeof(float));
+        for (i = 0; i < n; i++) {
+            const float *xp = x + i - (CONV_HEAD_LENGTH - 1);
+            float y = s1[i] + s2[i];
+
+            for (j = 0; j < CONV_HEAD_LENGTH; j++)
+                y += h[j] * xp[j];
+            out[c][i] = y;
+        }
+    }
+    conv->pos1 += n;
+    conv->pos2 += n;
+
+    if (conv->pos1 == CONV_HEAD_LENGTH) {
+        if (conv->stage1.parts)
+            conv_stage_process(&conv->stage1);
+        for (c = 0; c < 2; c++)
+            memmove(conv->stage1.in[c], conv->stage1.in[c] + CONV_HEAD_LENGTH,
+                    CONV_HEAD_LENGTH * sizeof(float));
+        conv->pos1 = 0;
+    }
+    if (conv->pos2 == CONV_TAIL_PART) {
+        if (conv->stage2.parts) {
+            conv_collect(conv);
+            conv_dispatch(conv);
+        }
+        conv->pos2 = 0;
+    }
+}
+
+void
+effect_convolution_process(y_synth_t *synth, unsigned long frames,
+                           LADSPA_Data *out_left, LADSPA_Data *out_right)
+{
+    y_convolver_t *conv = synth->convolver;
+    float wet, wet_delta;
+    float dc_r = synth->dc_block_r,
+          l_xnm1 = synth->dc_block_l_xnm1,
+          l_ynm1 = synth->dc_block_l_ynm1,
+          r_xnm1 = synth->dc_block_r_xnm1,
+          r_ynm1 = synth->dc_block_r_ynm1;
+    float sl[CONV_HEAD_LENGTH], sr[CONV_HEAD_LENGTH],
+          xl[CONV_HEAD_LENGTH], xr[CONV_HEAD_LENGTH];
+    LADSPA_Data *in_left = synth->voice_bus_l,
+                *in_right = synth->voice_bus_r;
+    int i, n;
+
+    wet = effects_mix_ramp(synth, frames, &wet_delta);
+
+    while (frames) {
+        n = (conv ? CONV_HEAD_LENGTH - conv->pos1 : CONV_HEAD_LENGTH);
+        if (n > frames) n = frames;
+
+        /* DC blocker */
+        for (i = 0; i < n; i++) {
+            sl[i] = l_ynm1 = in_left[i] - l_xnm1 + dc_r * l_ynm1;
+            l_xnm1 = in_left[i];
+            sr[i] = r_ynm1 = in_right[i] - r_xnm1 + dc_r * r_ynm1;
+            r_xnm1 = in_right[i];
+        }
+
+        if (conv)
+            conv_process(conv, sl, sr, xl, xr, n);
+        else {  /* no impulse response loaded */
+            memset(xl, 0, n * sizeof(float));
+            memset(xr, 0, n * sizeof(float));
+        }
+
+        for (i = 0; i < n; i++) {
+            wet += wet_delta;
+            out_left[i]  = wet * xl[i] + (1.0f - wet) * sl[i];
+            out_right[i] = wet * xr[i] + (1.0f - wet) * sr[i];
+        }
+
+        frames -= n;
+        in_left += n;
+        in_right += n;
+        out_left += n;
+        out_right += n;
+    }
+
+    synth->dc_block_l_xnm1 = l_xnm1;
+    synth->dc_block_l_ynm1 = l_ynm1;
+    synth->dc_block_r_xnm1 = r_xnm1;
+    synth->dc_block_r_ynm1 = r_ynm1;
+}
@@ -87,6 +87,16 @@ effect_reverb_request_buffers(y_synth_t *synth)
     Delay_init(&plate->tank.delay[2],   synth, L(9));
     Delay_init(&plate->tank.lattice[1], synth, L(10));
     Delay_init(&plate->tank.delay[3],   synth, L(11));
+
+    /* Plate_process_block() can handle no more samples at once than the
+     * shortest delay.  (The output taps are all well short of their delays'
+     * lengths, so they don't limit it further.) */
+    plate->block_max = Y_CONTROL_PERIOD;
+    for (i = 0; i < 12; ++i)
+        if (i != 4 && i != 5 && plate->block_max > L(i))  /* not the modulated lattices */
+            plate->block_max = L(i);
+    if (plate->block_max < 1)
+        plate->block_max = 1;
 #   undef L
 
 #   define T(i) ((int) (_Plate_t[i] * plate->fs))
@@ -105,7 +115,7 @@ effect_reverb_request_buffers(y_synth_t *synth)
 
 void effect_reverb_setup(y_synth_t *synth)
 {
-    struct Plate *plate = (struct Plate *)synth->effect_buffer;
+    struct Plate *plate = (struct Plate *)effects_region_buffer(synth);
     int i;
 
     OnePoleLP_reset(&plate->input.bandwidth);
@@ -127,109 +137,143 @@ void effect_reverb_setup(y_synth_t *synth)
     Sine_set_f3(&plate->tank.mlattice[1].lfo, 1.2, plate->fs, .5 * M_PI);
 }
 
-static inline void
-Plate_process (struct Plate *plate, float x, float decay, float * _xl, float * _xr)
+/*
+ * Plate_process_block
+ *
+ * Runs the plate over a block of n mono input samples in x[], which must be
+ * no longer than plate->block_max.  Since that is shorter than any of the
+ * (unmodulated) delays, each stage can be run over the whole block in turn,
+ * rather than running the whole plate a sample at a time.
+ */
+static void
+Plate_process_block(struct Plate *plate, float *x, float decay,
+                    float *xl, float *xr, int n)
 {
-    register float xl, xr;
+    float y[Y_CONTROL_PERIOD];
+    int i;
 
-    x = OnePoleLP_process(&plate->input.bandwidth, x);
+    OnePoleLP_process_block(&plate->input.bandwidth, x, n);
 
     /* lh */
-    x = Lattice_process(&plate->input.lattice[0], x, plate->indiff1);
-    x = Lattice_process(&plate->input.lattice[1], x, plate->indiff1);
-    
+    Lattice_process_block(&plate->input.lattice[0], x, n, plate->indiff1);
+    Lattice_process_block(&plate->input.lattice[1], x, n, plate->indiff1);
+
     /* rh */
-    x = Lattice_process(&plate->input.lattice[2], x, plate->indiff2);
-    x = Lattice_process(&plate->input.lattice[3], x, plate->indiff2);
+    Lattice_process_block(&plate->input.lattice[2], x, n, plate->indiff2);
+    Lattice_process_block(&plate->input.lattice[3], x, n, plate->indiff2);
 
     /* summation point */
-    xl = x + decay * Delay_get(&plate->tank.delay[3]);
-    xr = x + decay * Delay_get(&plate->tank.delay[1]);
+    Delay_get_block(&plate->tank.delay[3], y, n);
+    for (i = 0; i < n; i++)
+        xl[i] = x[i] + decay * y[i];
+    Delay_get_block(&plate->tank.delay[1], y, n);
+    for (i = 0; i < n; i++)
+        xr[i] = x[i] + decay * y[i];
 
     /* lh */
-    xl = ModLattice_process(&plate->tank.mlattice[0], xl, plate->dediff1);
-    xl = Delay_putget(&plate->tank.delay[0], xl);
-    xl = OnePoleLP_process(&plate->tank.damping[0], xl);
-    xl *= decay;
-    xl = Lattice_process(&plate->tank.lattice[0], xl, plate->dediff2);
-    Delay_put(&plate->tank.delay[1], xl);
+    ModLattice_process_block(&plate->tank.mlattice[0], xl, n, plate->dediff1);
+    Delay_putget_block(&plate->tank.delay[0], xl, n);
+    OnePoleLP_process_block(&plate->tank.damping[0], xl, n);
+    for (i = 0; i < n; i++)
+        xl[i] *= decay;
+    Lattice_process_block(&plate->tank.lattice[0], xl, n, plate->dediff2);
+    Delay_put_block(&plate->tank.delay[1], xl, n);
 
     /* rh */
-    xr = ModLattice_process(&plate->tank.mlattice[1], xr, plate->dediff1);
-    xr = Delay_putget(&plate->tank.delay[2], xr);
-    xr = OnePoleLP_process(&plate->tank.damping[1], xr);
-    xr *= decay;
-    xr = Lattice_process(&plate->tank.lattice[1], xr, plate->dediff2);
-    Delay_put(&plate->tank.delay[3], xr);
+    ModLattice_process_block(&plate->tank.mlattice[1], xr, n, plate->dediff1);
+    Delay_putget_block(&plate->tank.delay[2], xr, n);
+    OnePoleLP_process_block(&plate->tank.damping[1], xr, n);
+    for (i = 0; i < n; i++)
+        xr[i] *= decay;
+    Lattice_process_block(&plate->tank.lattice[1], xr, n, plate->dediff2);
+    Delay_put_block(&plate->tank.delay[3], xr, n);
 
     /* gather output */
-    xl  = .6 * Delay_peek(&plate->tank.delay[2], plate->tank.taps[0]);
-    xl += .6 * Delay_peek(&plate->tank.delay[2], plate->tank.taps[1]);
-    xl -= .6 * Delay_peek(&plate->tank.lattice[1], plate->tank.taps[2]);
-    xl += .6 * Delay_peek(&plate->tank.delay[3], plate->tank.taps[3]);
-    xl -= .6 * Delay_peek(&plate->tank.delay[0], plate->tank.taps[4]);
-    xl += .6 * Delay_peek(&plate->tank.lattice[0], plate->tank.taps[5]);
-
-    xr  = .6 * Delay_peek(&plate->tank.delay[0], plate->tank.taps[6]);
-    xr += .6 * Delay_peek(&plate->tank.delay[0], plate->tank.taps[7]);
-    xr -= .6 * Delay_peek(&plate->tank.lattice[0], plate->tank.taps[8]);
-    xr += .6 * Delay_peek(&plate->tank.delay[1], plate->tank.taps[9]);
-    xr -= .6 * Delay_peek(&plate->tank.delay[2], plate->tank.taps[10]);
-    xr += .6 * Delay_peek(&plate->tank.lattice[1], plate->tank.taps[11]);
-
-    *_xl = xl;
-    *_xr = xr;
+    memset(xl, 0, n * sizeof(float));
+    Delay_peek_block_add(&plate->tank.delay[2],    plate->tank.taps[0],   .6f, xl, n);
+    Delay_peek_block_add(&plate->tank.delay[2],    plate->tank.taps[1],   .6f, xl, n);
+    Delay_peek_block_add(&plate->tank.lattice[1], plate->tank.taps[2],  -.6f, xl, n);
+    Delay_peek_block_add(&plate->tank.delay[3],    plate->tank.taps[3],   .6f, xl, n);
+    Delay_peek_block_add(&plate->tank.delay[0],    plate->tank.taps[4],  -.6f, xl, n);
+    Delay_peek_block_add(&plate->tank.lattice[0],  plate->tank.taps[5],   .6f, xl, n);
+
+    memset(xr, 0, n * sizeof(float));
+    Delay_peek_block_add(&plate->tank.delay[0],    plate->tank.taps[6],   .6f, xr, n);
+    Delay_peek_block_add(&plate->tank.delay[0],    plate->tank.taps[7],   .6f, xr, n);
+    Delay_peek_block_add(&plate->tank.lattice[0],  plate->tank.taps[8],  -.6f, xr, n);
+    Delay_peek_block_add(&plate->tank.delay[1],    plate->tank.taps[9],   .6f, xr, n);
+    Delay_peek_block_add(&plate->tank.delay[2],    plate->tank.taps[10], -.6f, xr, n);
+    Delay_peek_block_add(&plate->tank.lattice[1],  plate->tank.taps[11],  .6f, xr, n);
 }
 
 void
 effect_reverb_process(y_synth_t *synth, unsigned long frames,
                       LADSPA_Data *out_left, LADSPA_Data *out_right)
 {
-    struct Plate *plate = (struct Plate *)synth->effect_buffer;
-    double d, damp;
-    float decay, blend, dry;
-    int i;
-
-    blend = *(synth->effect_mix);
-    dry = 1.0f - blend;
+    struct Plate *plate = (struct Plate *)effects_region_buffer(synth);
+    float d, decay, blend, blend_delta;
+    float dc_r = synth->dc_block_r,
+          l_xnm1 = synth->dc_block_l_xnm1,
+          l_ynm1 = synth->dc_block_l_ynm1,
+          r_xnm1 = synth->dc_block_r_xnm1,
+          r_ynm1 = synth->dc_block_r_ynm1;
+    float sl[Y_CONTROL_PERIOD], sr[Y_CONTROL_PERIOD], x[Y_CONTROL_PERIOD],
+          xl[Y_CONTROL_PERIOD], xr[Y_CONTROL_PERIOD];
+    LADSPA_Data *in_left = synth->voice_bus_l,
+                *in_right = synth->voice_bus_r;
+    int i, n;
+
+    blend = effects_mix_ramp(synth, frames, &blend_delta);
 
     /* originally:
      *   d = *(synth->effect_param4) * 0.994f + 0.005f;
      *   OnePoleLP_set(&plate->input.bandwidth, exp(-M_PI * (1. - d)));
      * a quick approximation of the above: */
     d = *(synth->effect_param4);
-    d = ((1.26595 * d - 0.614577) * d + 0.305691) * d + 0.0422856;
+    d = ((1.26595f * d - 0.614577f) * d + 0.305691f) * d + 0.0422856f;
     OnePoleLP_set(&plate->input.bandwidth, d);                       /* "bandwidth" */
 
     decay = *(synth->effect_param5) * 0.749f;                        /* "tail" */
 
     d = *(synth->effect_param6) * 0.9995f + 0.0005f;
-    damp = exp(-M_PI * d);                                           /* "damping" */
-    OnePoleLP_set(&plate->tank.damping[0], damp);
-    OnePoleLP_set(&plate->tank.damping[1], damp);
+    d = expf(-M_PI * d);                                             /* "damping" */
+    OnePoleLP_set(&plate->tank.damping[0], d);
+    OnePoleLP_set(&plate->tank.damping[1], d);
 
-    for (i = 0; i < frames; ++i)
-    {
-        float sl, sr, x, xl, xr;
+    while (frames) {
+        n = (frames > plate->block_max ? plate->block_max : frames);
 
         /* DC blocker */
-        sl = synth->voice_bus_l[i] - synth->dc_block_l_xnm1 +
-                 synth->dc_block_r * synth->dc_block_l_ynm1;
-        synth->dc_block_l_ynm1 = sl;
-        synth->dc_block_l_xnm1 = synth->voice_bus_l[i];
-        sr = synth->voice_bus_r[i] - synth->dc_block_r_xnm1 +
-                 synth->dc_block_r * synth->dc_block_r_ynm1;
-        synth->dc_block_r_ynm1 = sr;
-        synth->dc_block_r_xnm1 = synth->voice_bus_r[i];
+        for (i = 0; i < n; i++) {
+            sl[i] = l_ynm1 = in_left[i] - l_xnm1 + dc_r * l_ynm1;
+            l_xnm1 = in_left[i];
+            sr[i] = r_ynm1 = in_right[i] - r_xnm1 + dc_r * r_ynm1;
+            r_xnm1 = in_right[i];
+        }
 
         /* Plate2x2 reverb */
-        x = (sl + sr) * 0.5f;
+        for (i = 0; i < n; i++)
+            x[i] = (sl[i] + sr[i]) * 0.5f;
 
-        Plate_process (plate, x, decay, &xl, &xr);
+        Plate_process_block(plate, x, decay, xl, xr, n);
 
-        out_left[i]  = blend * xl + dry * sl;
-        out_right[i] = blend * xr + dry * sr;
+        for (i = 0; i < n; i++) {
+            blend += blend_delta;
+            out_left[i]  = blend * xl[i] + (1.0f - blend) * sl[i];
+            out_right[i] = blend * xr[i] + (1.0f - blend) * sr[i];
+        }
+
+        frames -= n;
+        in_left += n;
+        in_right += n;
+        out_left += n;
+        out_right += n;
     }
+
+    synth->dc_block_l_xnm1 = l_xnm1;
+    synth->dc_block_l_ynm1 = l_ynm1;
+    synth->dc_block_r_xnm1 = r_xnm1;
+    synth->dc_block_r_ynm1 = r_ynm1;
 }
 
 /* ==== Dual Delay ==== */
@@ -254,7 +298,7 @@ effect_delay_request_buffers(y_synth_t *synth)
 
 void effect_delay_setup(y_synth_t *synth)
 {
-    struct DualDelay *delay = (struct DualDelay *)synth->effect_buffer;
+    struct DualDelay *delay = (struct DualDelay *)effects_region_buffer(synth);
 
     Delay_reset(&delay->delay_l);
     Delay_reset(&delay->delay_r);
@@ -266,12 +310,11 @@ void
 effect_delay_process(y_synth_t *synth, unsigned long frames,
                      LADSPA_Data *out_left, LADSPA_Data *out_right)
 {
-    struct DualDelay *delay = (struct DualDelay *)synth->effect_buffer;
-    float wet, dry, fb, fa, fia, damping;
+    struct DualDelay *delay = (struct DualDelay *)effects_region_buffer(synth);
+    float wet, wet_delta, dry, fb, fa, fia, damping;
     int i, delay_l, delay_r;
 
-    wet = *(synth->effect_mix);
-    dry = 1.0f - wet;
+    wet = effects_mix_ramp(synth, frames, &wet_delta);
 
     fb = *(synth->effect_param2);
     fa = *(synth->effect_param3);
@@ -308,6 +351,8 @@ effect_delay_process(y_synth_t *synth, unsigned long frames,
             Delay_put(&delay->delay_l, fia * il + fa * ir);
             Delay_put(&delay->delay_r, fia * ir + fa * il);
 
+            wet += wet_delta;
+            dry = 1.0f - wet;
             out_left[i]  = wet * xl + dry * sl;
             out_right[i] = wet * xr + dry * sr;
         }
@@ -340,6 +385,8 @@ effect_delay_process(y_synth_t *synth, unsigned long frames,
             Delay_put(&delay->delay_l, fia * il + fa * ir);
             Delay_put(&delay->delay_r, fia * ir + fa * il);
 
+            wet += wet_delta;
+            dry = 1.0f - wet;
             out_left[i]  = wet * xl + dry * sl;
             out_right[i] = wet * xr + dry * sr;
         }
@@ -24,6 +24,7 @@
 #ifndef _EFFECT_REVERB_H
 #define _EFFECT_REVERB_H
 
+#include <string.h>
 #include <math.h>
 
 #include "whysynth_types.h"
@@ -58,6 +59,17 @@ OnePoleLP_process(struct OnePoleLP *this, float x)
     return this->y1 = this->a0 * x + this->b1 * this->y1;
 }
 
+static inline void
+OnePoleLP_process_block(struct OnePoleLP *this, float *x, int n)
+{
+    float a0 = this->a0, b1 = this->b1, y1 = this->y1;
+    int i;
+
+    for (i = 0; i < n; i++)
+        x[i] = y1 = a0 * x[i] + b1 * y1;
+    this->y1 = y1;
+}
+
 // static inline void
 // OnePoleLP_decay (struct OnePoleLP *this, double d)
 // {
@@ -128,6 +140,57 @@ Delay_putget (struct Delay *this, float x)
     return Delay_get(this);
 }
 
+/* Block versions of the above, for n samples at a time.  These are only
+ * equivalent to n calls of the single-sample versions if n is no greater
+ * than the delay length, so that nothing read was written in the same
+ * block. */
+static inline void
+Delay_get_block(struct Delay *this, float *y, int n)
+{
+    int run = this->size + 1 - this->read;
+
+    if (run > n) run = n;
+    memcpy(y, this->data + this->read, run * sizeof(float));
+    memcpy(y + run, this->data, (n - run) * sizeof(float));
+    this->read = (this->read + n) & this->size;
+}
+
+static inline void
+Delay_put_block(struct Delay *this, const float *x, int n)
+{
+    int run = this->size + 1 - this->write;
+
+    if (run > n) run = n;
+    memcpy(this->data + this->write, x, run * sizeof(float));
+    memcpy(this->data, x + run, (n - run) * sizeof(float));
+    this->write = (this->write + n) & this->size;
+}
+
+static inline void
+Delay_putget_block(struct Delay *this, float *x, int n)
+{
+    Delay_put_block(this, x, n);
+    Delay_get_block(this, x, n);
+}
+
+/* adds gain * Delay_peek(this, t) to each acc[i], as it would have been
+ * just after the put of sample i of the block just written */
+static inline void
+Delay_peek_block_add(struct Delay *this, int t, float gain, float *acc, int n)
+{
+    int start = (this->write - n + 1 - t) & this->size,
+        run = this->size + 1 - start,
+        i;
+    float *data = this->data + start;
+
+    if (run > n) run = n;
+    for (i = 0; i < run; i++)
+        acc[i] += gain * data[i];
+    data = this->data - run;
+    for (; i < n; i++)
+        acc[i] += gain * data[i];
+}
+
 /* fractional lookup, linear interpolation */
 static inline float
 Delay_get_at (struct Delay *this, float f)
@@ -175,6 +238,20 @@ Lattice_process(struct Delay *delay, float x, double d)
     return d * x + y;
 };
 
+static inline void
+Lattice_process_block(struct Delay *delay, float *x, int n, float d)
+{
+    float y[Y_CONTROL_PERIOD];
+    int i;
+
+    Delay_get_block(delay, y, n);
+    for (i = 0; i < n; i++)
+        x[i] -= d * y[i];
+    Delay_put_block(delay, x, n);
+    for (i = 0; i < n; i++)
+        x[i] = d * x[i] + y[i];
+}
+
 struct Sine
 {
     int z;
@@ -198,6 +275,10 @@ Sine_set_f3 (struct Sine *this, double f, double fs, double phase)
 }
 
 /* advance and return 1 sample */
+/* !FIX! For the plate's 1.2Hz LFO, b rounds to exactly 2.0f at any common
+ * sample rate, so this produces a slow ramp rather than a sine, and the
+ * modulated lattices' read index drifts steadily around their delay lines.
+ * That's part of the plate's sound now, so it's left alone. */
 static inline double
 Sine_get(struct Sine *this)
 {
@@ -239,9 +320,40 @@ ModLattice_process (struct ModLattice *this, float x, double d)
     return y - d * x; /* note sign */
 }
 
+/* This reads and writes a sample at a time, since the read index doesn't
+ * stay a fixed distance behind the write index (see Sine_get() above) */
+static inline void
+ModLattice_process_block(struct ModLattice *this, float *x, int n, float d)
+{
+    struct Delay *delay = &this->delay;
+    struct Sine *lfo = &this->lfo;
+    float s, f, y;
+    int i, k, z = lfo->z;
+
+    for (i = 0; i < n; i++) {
+        /* Sine_get() */
+        s = lfo->b * lfo->y[z];
+        z ^= 1;
+        s -= lfo->y[z];
+        lfo->y[z] = s;
+        /* Delay_get_at() */
+        f = this->n0 + this->width * s;
+        k = lrintf(f - 0.5f);
+        f -= (float)k;
+        k = delay->write - k;
+        y = (1.0f - f) * delay->data[k & delay->size] +
+            f * delay->data[(k - 1) & delay->size];
+        x[i] += d * y;
+        Delay_put(delay, x[i]);
+        x[i] = y - d * x[i];
+    }
+    lfo->z = z;
+}
+
 struct Plate
 {
     double fs;
+    int block_max;  /* largest block Plate_process_block() can do at once */
 
     float indiff1, indiff2, dediff1, dediff2;
 
@@ -38,6 +38,7 @@
 #define _DEFAULT_SOURCE 1
 #define _ISOC99_SOURCE  1
 
+#include <string.h>
 #include <math.h>
 
 #include <ladspa.h>
@@ -46,6 +47,20 @@
 #include "dssp_event.h"
 #include "effects.h"
 
+/* The eight delay lines are processed in parallel, one per lane of a
+ * GCC/clang vector.  By default their arithmetic is done in single
+ * precision; define SCREVERB_DOUBLE_PRECISION to get the original (slower)
+ * double precision behavior. */
+// #define SCREVERB_DOUBLE_PRECISION
+
+#ifdef SCREVERB_DOUBLE_PRECISION
+typedef double sc_float;
+#else
+typedef float  sc_float;
+#endif
+typedef sc_float sc_vec  __attribute__((vector_size(8 * sizeof(sc_float))));
+typedef int      sc_ivec __attribute__((vector_size(8 * sizeof(int))));
+
 #define DEFAULT_SRATE   44100.0
 // #define MIN_SRATE       5000.0
 // #define MAX_SRATE       1000000.0
@@ -73,22 +88,19 @@ static const double reverbParams[8][4] = {
 static const double outputGain  = 0.35;
 static const double jpScale     = 0.25;
 
-typedef struct {
-    int         writePos;
-    int         bufferSize;
-    int         readPos;
-    int         readPosFrac;
-    int         readPosFrac_inc;
-    int         seedVal;
-    int         randLine_cnt;
-    double      filterState;
-    float       *buf;
-} delayLine;
-
+/* delay line state, stored 'structure of arrays' style, indexed by line */
 typedef struct {
     double     dampFact;
     float      prv_LPFreq;
-    delayLine  delayLines[8];
+    int        writePos[8];
+    int        bufferSize[8];
+    int        readPos[8];
+    int        readPosFrac[8];
+    int        readPosFrac_inc[8];
+    int        seedVal[8];
+    int        randLine_cnt[8];
+    sc_float   filterState[8];
+    float     *buf[8];
 } SC_REVERB;
 
 static int
@@ -114,53 +126,54 @@ pitch_mod(y_synth_t *synth)
 }
 
 static void
-next_random_lineseg(y_synth_t *synth, SC_REVERB *p, delayLine *lp, int n)
+next_random_lineseg(y_synth_t *synth, SC_REVERB *p, int n)
 {
     double  prvDel, nxtDel, phs_incVal;
 
     /* update random seed */
-    if (lp->seedVal < 0)
-        lp->seedVal += 0x10000;
-    lp->seedVal = (lp->seedVal * 15625 + 1) & 0xFFFF;
-    if (lp->seedVal >= 0x8000)
-        lp->seedVal -= 0x10000;
+    if (p->seedVal[n] < 0)
+        p->seedVal[n] += 0x10000;
+    p->seedVal[n] = (p->seedVal[n] * 15625 + 1) & 0xFFFF;
+    if (p->seedVal[n] >= 0x8000)
+        p->seedVal[n] -= 0x10000;
     /* length of next segment in samples */
-    lp->randLine_cnt = (int) (((double)synth->sample_rate / reverbParams[n][2]) + 0.5);
-    prvDel = (double) lp->writePos;
-    prvDel -= ((double) lp->readPos
-               + ((double) lp->readPosFrac / (double) DELAYPOS_SCALE));
+    p->randLine_cnt[n] = (int) (((double)synth->sample_rate / reverbParams[n][2]) + 0.5);
+    prvDel = (double) p->writePos[n];
+    prvDel -= ((double) p->readPos[n]
+               + ((double) p->readPosFrac[n] / (double) DELAYPOS_SCALE));
     while (prvDel < 0.0)
-        prvDel += (double) lp->bufferSize;
+        prvDel += (double) p->bufferSize[n];
     prvDel = prvDel / (double)synth->sample_rate;    /* previous delay time in seconds */
-    nxtDel = (double) lp->seedVal * reverbParams[n][1] / 32768.0;
+    nxtDel = (double) p->seedVal[n] * reverbParams[n][1] / 32768.0;
     /* next delay time in seconds */
     /* was: nxtDel = reverbParams[n][0] + (nxtDel * (double) *(p->iPitchMod)); */
     nxtDel = reverbParams[n][0] + (nxtDel * pitch_mod(synth));
     /* calculate phase increment per sample */
-    phs_incVal = (prvDel - nxtDel) / (double) lp->randLine_cnt;
+    phs_incVal = (prvDel - nxtDel) / (double) p->randLine_cnt[n];
     phs_incVal = phs_incVal * (double)synth->sample_rate + 1.0;
-    lp->readPosFrac_inc = (int) (phs_incVal * DELAYPOS_SCALE + 0.5);
+    p->readPosFrac_inc[n] = (int) (phs_incVal * DELAYPOS_SCALE + 0.5);
 }
 
 static void
-init_delay_line(y_synth_t *synth, SC_REVERB *p, delayLine *lp, int n)
+init_delay_line(y_synth_t *synth, SC_REVERB *p, int n)
 {
     double  readPos;
 
     /* delay line bufferSize and buffer address already set up */
-    lp->writePos = 0;
+    p->writePos[n] = 0;
     /* set random seed */
-    lp->seedVal = (int) (reverbParams[n][3] + 0.5);
+    p->seedVal[n] = (int) (reverbParams[n][3] + 0.5);
     /* set initial delay time */
-    readPos = (double) lp->seedVal * reverbParams[n][1] / 32768.0;
+    readPos = (double) p->seedVal[n] * reverbParams[n][1] / 32768.0;
     /* was: readPos = reverbParams[n][0] + (readPos * (double) *(p->iPitchMod)); */
     readPos = reverbParams[n][0] + (readPos * pitch_mod(synth));
-    readPos = (double) lp->bufferSize - (readPos * (double)synth->sample_rate);
-    lp->readPos = (int) readPos;
-    readPos = (readPos - (double) lp->readPos) * (double) DELAYPOS_SCALE;
-    lp->readPosFrac = (int) (readPos + 0.5);
+    readPos = (double) p->bufferSize[n] - (readPos * (double)synth->sample_rate);
+    p->readPos[n] = (int) readPos;
+    readPos = (readPos - (double) p->readPos[n]) * (double) DELAYPOS_SCALE;
+    p->readPosFrac[n] = (int) (readPos + 0.5);
+    p->filterState[n] = 0.0;
     /* initialise first random line segment */
-    next_random_lineseg(synth, p, lp, n);
+    next_random_lineseg(synth, p, n);
     /* delay line already cleared to zero */
 }
 
@@ -177,39 +190,54 @@ effect_screverb_request_buffers(y_synth_t *synth)
     /* calculate the number of bytes to allocate */
     nBytes = 0;
     for (i = 0; i < 8; i++) {
-        p->delayLines[i].bufferSize = delay_line_max_samples(synth, i);
-        nBytes = p->delayLines[i].bufferSize * sizeof(float);
+        p->bufferSize[i] = delay_line_max_samples(synth, i);
+        nBytes = p->bufferSize[i] * sizeof(float);
         nBytes = (nBytes + 15) & (~15);
-        p->delayLines[i].buf = (float *) effects_request_buffer(synth, nBytes);
+        p->buf[i] = (float *) effects_request_buffer(synth, nBytes);
     }
 }
 
 void
 effect_screverb_setup(y_synth_t *synth)
 {
-    SC_REVERB *p = (SC_REVERB *)synth->effect_buffer;
+    SC_REVERB *p = (SC_REVERB *)effects_region_buffer(synth);
     int i;
 
     /* set up delay lines */
     for (i = 0; i < 8; i++)
-        init_delay_line(synth, p, &p->delayLines[i], i);
+        init_delay_line(synth, p, i);
     p->dampFact = 1.0;
     p->prv_LPFreq = -1.0f;
 }
 
+/*
+ * effect_screverb_process
+ *
+ * The per-line state is loaded into vectors for the duration of the call.
+ * Only the delay line writes and the interpolation reads are done a lane at
+ * a time, since without AVX2 there are no scatter or gather instructions.
+ */
 void
 effect_screverb_process(y_synth_t *synth, unsigned long sample_count,
                         LADSPA_Data *out_left, LADSPA_Data *out_right)
 {
-    SC_REVERB *p = (SC_REVERB *)synth->effect_buffer;
-    float      wet, dry;
-    double     ainL, ainR, aoutL, aoutR, feedback;
-    double     vm1, v0, v1, v2, am1, a0, a1, a2, frac;
-    delayLine *lp;
-    int        i, n, readPos;
+    SC_REVERB *p = (SC_REVERB *)effects_region_buffer(synth);
+    float      wet, wet_delta, dry;
+    float      dc_r = synth->dc_block_r,
+               l_xnm1 = synth->dc_block_l_xnm1,
+               l_ynm1 = synth->dc_block_l_ynm1,
+               r_xnm1 = synth->dc_block_r_xnm1,
+               r_ynm1 = synth->dc_block_r_ynm1;
+    sc_float   ainL, ainR, junction, aoutL, aoutR, feedback, dampFact;
+    sc_vec     filterState, ain, vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+    sc_ivec    writePos, bufferSize, readPos, readPosFrac, readPosFrac_inc,
+               randLine_cnt;
+    sc_float   lane_in[8], lane_vm1[8], lane_v0[8], lane_v1[8], lane_v2[8];
+    int        lane_writePos[8], lane_readPos[8], lane_count[8];
+    float     *buf;
+    int        i, n, pos, size;
 
-    wet = *(synth->effect_mix);
-    dry = 1.0f - wet;
+    wet = effects_mix_ramp(synth, sample_count, &wet_delta);
 
 // *(synth->effect_param4) = kfblvl  = kFeedBack
 // *(synth->effect_param5) = kfco    = kLPFreq
@@ -222,82 +250,123 @@ effect_screverb_process(y_synth_t *synth, unsigned long sample_count,
         p->dampFact = 2.0 - cos((double) p->prv_LPFreq * M_PI);
         p->dampFact = p->dampFact - sqrt(p->dampFact * p->dampFact - 1.0);
     }
-    feedback = sqrt(*(synth->effect_param4));
+    dampFact = (sc_float)p->dampFact;
+    feedback = (sc_float)sqrt(*(synth->effect_param4));
+
+    memcpy(&filterState,     p->filterState,     sizeof(sc_vec));
+    memcpy(&writePos,        p->writePos,        sizeof(sc_ivec));
+    memcpy(&bufferSize,      p->bufferSize,      sizeof(sc_ivec));
+    memcpy(&readPos,         p->readPos,         sizeof(sc_ivec));
+    memcpy(&readPosFrac,     p->readPosFrac,     sizeof(sc_ivec));
+    memcpy(&readPosFrac_inc, p->readPosFrac_inc, sizeof(sc_ivec));
+    memcpy(&randLine_cnt,    p->randLine_cnt,    sizeof(sc_ivec));
+
     /* update delay lines */
     for (i = 0; i < sample_count; i++) {
         /* DC blocker */
-        synth->dc_block_l_ynm1 = synth->voice_bus_l[i] - synth->dc_block_l_xnm1 +
-                                     synth->dc_block_r * synth->dc_block_l_ynm1;
-        ainL = (double)synth->dc_block_l_ynm1;
-        synth->dc_block_l_xnm1 = synth->voice_bus_l[i];
-        synth->dc_block_r_ynm1 = synth->voice_bus_r[i] - synth->dc_block_r_xnm1 +
-                                     synth->dc_block_r * synth->dc_block_r_ynm1;
-        ainR = (double)synth->dc_block_r_ynm1;
-        synth->dc_block_r_xnm1 = synth->voice_bus_r[i];
+        l_ynm1 = synth->voice_bus_l[i] - l_xnm1 + dc_r * l_ynm1;
+        l_xnm1 = synth->voice_bus_l[i];
+        r_ynm1 = synth->voice_bus_r[i] - r_xnm1 + dc_r * r_ynm1;
+        r_xnm1 = synth->voice_bus_r[i];
         /* calculate "resultant junction pressure" and mix to input signals */
-        aoutL = 0.0;
+        junction = (filterState[0] + filterState[1] + filterState[2] + filterState[3] +
+                    filterState[4] + filterState[5] + filterState[6] + filterState[7]) *
+                   (sc_float)jpScale;
+        ainL = (sc_float)l_ynm1 + junction;
+        ainR = (sc_float)r_ynm1 + junction;
+        ain = (sc_vec){ ainL, ainR, ainL, ainR, ainL, ainR, ainL, ainR };
+
+        /* send input signal and feedback to delay lines */
+        ain -= filterState;
+        memcpy(lane_in, &ain, sizeof(sc_vec));
+        memcpy(lane_writePos, &writePos, sizeof(sc_ivec));
         for (n = 0; n < 8; n++)
-            aoutL += p->delayLines[n].filterState;
-        aoutL *= jpScale;
-        ainR += aoutL;
-        ainL += aoutL;
-        aoutL = aoutR = 0.0;
-        /* loop through all delay lines */
+            p->buf[n][lane_writePos[n]] = (float)lane_in[n];
+        writePos += 1;
+        writePos -= (writePos >= bufferSize) & bufferSize;
+
+        /* advance read positions (readPosFrac is never negative, so this
+         * needs no test) */
+        readPos += readPosFrac >> DELAYPOS_SHIFT;
+        readPosFrac &= DELAYPOS_MASK;
+        readPos -= (readPos >= bufferSize) & bufferSize;
+        frac = __builtin_convertvector(readPosFrac, sc_vec) *
+                   (sc_float) (1.0 / (double) DELAYPOS_SCALE);
+
+        /* read four samples from each line for interpolation */
+        memcpy(lane_readPos, &readPos, sizeof(sc_ivec));
         for (n = 0; n < 8; n++) {
-            lp = &p->delayLines[n];
-            /* send input signal and feedback to delay line */
-            lp->buf[lp->writePos] = (float) ((n & 1 ? ainR : ainL)
-                                             - lp->filterState);
-            if (++lp->writePos >= lp->bufferSize)
-                lp->writePos -= lp->bufferSize;
-            /* read from delay line with cubic interpolation */
-            if (lp->readPosFrac >= DELAYPOS_SCALE) {
-                lp->readPos += (lp->readPosFrac >> DELAYPOS_SHIFT);
-                lp->readPosFrac &= DELAYPOS_MASK;
-            }
-            if (lp->readPos >= lp->bufferSize)
-                lp->readPos -= lp->bufferSize;
-            readPos = lp->readPos;
-            frac = (double) lp->readPosFrac * (1.0 / (double) DELAYPOS_SCALE);
-            /* calculate interpolation coefficients */
-            a2 = frac * frac; a2 -= 1.0; a2 *= (1.0 / 6.0);
-            a1 = frac; a1 += 1.0; a1 *= 0.5; am1 = a1 - 1.0;
-            a0 = 3.0 * a2; a1 -= a0; am1 -= a2; a0 -= frac;
-            /* read four samples for interpolation */
-            if (readPos > 0 && readPos < (lp->bufferSize - 2)) {
-                vm1 = (double) (lp->buf[readPos - 1]);
-                v0 = (double) (lp->buf[readPos]);
-                v1 = (double) (lp->buf[readPos + 1]);
-                v2 = (double) (lp->buf[readPos + 2]);
+            buf = p->buf[n];
+            pos = lane_readPos[n];
+            size = p->bufferSize[n];
+            if (pos > 0 && pos < (size - 2)) {
+                lane_vm1[n] = buf[pos - 1];
+                lane_v0[n]  = buf[pos];
+                lane_v1[n]  = buf[pos + 1];
+                lane_v2[n]  = buf[pos + 2];
             } else {
                 /* at buffer wrap-around, need to check index */
-                if (--readPos < 0) readPos += lp->bufferSize;
-                vm1 = (double) lp->buf[readPos];
-                if (++readPos >= lp->bufferSize) readPos -= lp->bufferSize;
-                v0 = (double) lp->buf[readPos];
-                if (++readPos >= lp->bufferSize) readPos -= lp->bufferSize;
-                v1 = (double) lp->buf[readPos];
-                if (++readPos >= lp->bufferSize) readPos -= lp->bufferSize;
-                v2 = (double) lp->buf[readPos];
+                if (--pos < 0) pos += size;
+                lane_vm1[n] = buf[pos];
+                if (++pos >= size) pos -= size;
+                lane_v0[n] = buf[pos];
+                if (++pos >= size) pos -= size;
+                lane_v1[n] = buf[pos];
+                if (++pos >= size) pos -= size;
+                lane_v2[n] = buf[pos];
             }
-            v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
-            /* update buffer read position */
-            lp->readPosFrac += lp->readPosFrac_inc;
-            /* apply feedback gain and lowpass filter */
-            v0 *= feedback;
-            v0 = (lp->filterState - v0) * p->dampFact + v0;
-            lp->filterState = v0;
-            /* mix to output */
-            if (n & 1)
-                aoutR += v0;
-            else
-                aoutL += v0;
-            /* start next random line segment if current one has reached endpoint */
-            if (--(lp->randLine_cnt) <= 0)
-                next_random_lineseg(synth, p, lp, n);
         }
-        out_left[i]  = wet * (float) (aoutL * outputGain) + dry * synth->voice_bus_l[i];
-        out_right[i] = wet * (float) (aoutR * outputGain) + dry * synth->voice_bus_r[i];
+        memcpy(&vm1, lane_vm1, sizeof(sc_vec));
+        memcpy(&v0,  lane_v0,  sizeof(sc_vec));
+        memcpy(&v1,  lane_v1,  sizeof(sc_vec));
+        memcpy(&v2,  lane_v2,  sizeof(sc_vec));
+
+        /* calculate interpolation coefficients, and interpolate */
+        a2 = frac * frac; a2 -= 1.0; a2 *= (sc_float)(1.0 / 6.0);
+        a1 = frac; a1 += 1.0; a1 *= 0.5; am1 = a1 - 1.0;
+        a0 = 3.0 * a2; a1 -= a0; am1 -= a2; a0 -= frac;
+        v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
+        /* update buffer read position */
+        readPosFrac += readPosFrac_inc;
+        /* apply feedback gain and lowpass filter */
+        v0 *= feedback;
+        filterState = (filterState - v0) * dampFact + v0;
+
+        /* mix to output */
+        aoutL = filterState[0] + filterState[2] + filterState[4] + filterState[6];
+        aoutR = filterState[1] + filterState[3] + filterState[5] + filterState[7];
+        wet += wet_delta;
+        dry = 1.0f - wet;
+        out_left[i]  = wet * (float) (aoutL * (sc_float)outputGain) + dry * synth->voice_bus_l[i];
+        out_right[i] = wet * (float) (aoutR * (sc_float)outputGain) + dry * synth->voice_bus_r[i];
+
+        /* start next random line segment for any line whose current one has
+         * reached its endpoint (rare, so the state makes a round trip through
+         * *p for it) */
+        randLine_cnt -= 1;
+        memcpy(lane_count, &randLine_cnt, sizeof(sc_ivec));
+        if ((lane_count[0] <= 0) | (lane_count[1] <= 0) | (lane_count[2] <= 0) |
+            (lane_count[3] <= 0) | (lane_count[4] <= 0) | (lane_count[5] <= 0) |
+            (lane_count[6] <= 0) | (lane_count[7] <= 0)) {
+            memcpy(p->writePos,     &writePos,     sizeof(sc_ivec));
+            memcpy(p->readPos,      &readPos,      sizeof(sc_ivec));
+            memcpy(p->readPosFrac,  &readPosFrac,  sizeof(sc_ivec));
+            memcpy(p->randLine_cnt, &randLine_cnt, sizeof(sc_ivec));
+            for (n = 0; n < 8; n++)
+                if (p->randLine_cnt[n] <= 0)
+                    next_random_lineseg(synth, p, n);
+            memcpy(&readPosFrac_inc, p->readPosFrac_inc, sizeof(sc_ivec));
+            memcpy(&randLine_cnt,    p->randLine_cnt,    sizeof(sc_ivec));
+        }
     }
-}
 
+    memcpy(p->filterState,  &filterState,  sizeof(sc_vec));
+    memcpy(p->writePos,     &writePos,     sizeof(sc_ivec));
+    memcpy(p->readPos,      &readPos,      sizeof(sc_ivec));
+    memcpy(p->readPosFrac,  &readPosFrac,  sizeof(sc_ivec));
+    memcpy(p->randLine_cnt, &randLine_cnt, sizeof(sc_ivec));
+    synth->dc_block_l_xnm1 = l_xnm1;
+    synth->dc_block_l_ynm1 = l_ynm1;
+    synth->dc_block_r_xnm1 = r_xnm1;
+    synth->dc_block_r_ynm1 = r_ynm1;
+}
@@ -29,6 +29,7 @@
 #include "whysynth_types.h"
 #include "dssp_event.h"
 #include "effects.h"
+#include "sampleset.h"
 
 /* Okay, this is kinda goofy, the result of having changed my mind at least
  * three times....
@@ -55,6 +56,14 @@
  * effects_request_silencing_of_subsequent_allocations().  Any buffers allocated
  * after this call will be silenced before the effect_<name>_process() function
  * is called.
+ *
+ * Each effect gets its own region of the buffer, so that the silencing need
+ * not happen in the audio thread: when the effect mode changes, the region of
+ * the effect being left is marked dirty, and the non-realtime worker thread
+ * clears it in the background (see effects_clear_regions()).  An effect whose
+ * region is clean starts at once.  If the effect is switched back to before
+ * the worker has finished clearing its region, only the dry signal is output
+ * until it is done; the audio thread never clears the region itself.
  */
 
 /*
@@ -66,37 +75,89 @@ effects_request_buffer(y_synth_t *synth, size_t size)
     void *p = (void *)((char *)(synth->effect_buffer) + synth->effect_buffer_allocation);
 
     synth->effect_buffer_allocation += size;
-    if (synth->effect_buffer_highwater < synth->effect_buffer_allocation)
-        synth->effect_buffer_highwater = synth->effect_buffer_allocation;
-    /* printf("allocation = %ld, highwater = %ld\n", synth->effect_buffer_allocation, synth->effect_buffer_highwater); */
+    /* printf("allocation = %ld\n", synth->effect_buffer_allocation); */
     return p;
 }
 
 /*
- * effects_setup
+ * effects_layout_regions
+ *
+ * Sizes each effect's region with a dry run of its request_buffers()
+ * function, lays the regions out one after another, and returns the total
+ * size of the effect buffer, or 0 if out of memory.
  */
-int
-effects_setup(y_synth_t *synth)
+static size_t
+effects_layout_regions(y_synth_t *synth)
 {
+    size_t size[Y_EFFECT_MODE_COUNT + 1], total;
+    int mode;
+
     synth->effect_buffer = (void *)malloc(4096);
     if (!synth->effect_buffer)
         return 0;
 
-    synth->effect_buffer_highwater = 0;
+    memset(size, 0, sizeof(size));
     effects_start_allocation(synth);
     effect_reverb_request_buffers(synth);
+    size[1] = synth->effect_buffer_allocation;
     effects_start_allocation(synth);
     effect_delay_request_buffers(synth);
+    size[2] = synth->effect_buffer_allocation;
     effects_start_allocation(synth);
     effect_screverb_request_buffers(synth);
+    size[3] = synth->effect_buffer_allocation;
+    /* convolution (mode 4) keeps its state in the convolver, so needs no region */
+    free(synth->effect_buffer);
+    synth->effect_buffer = NULL;
 
-    if (synth->effect_buffer_highwater > 4096) {
-        free(synth->effect_buffer);
-        synth->effect_buffer = (void *)calloc(1, synth->effect_buffer_highwater);
-        if (!synth->effect_buffer)
-            return 0;
+    total = 0;
+    for (mode = 0; mode <= Y_EFFECT_MODE_COUNT; mode++) {
+        synth->effect_region[mode].start = total;
+        synth->effect_region[mode].silence = total;
+        total += (size[mode] + 15) & ~(size_t)15;  /* keep each region 16-byte aligned */
+        synth->effect_region[mode].end = total;
+        synth->effect_region[mode].state = Y_EFFECT_REGION_CLEAN;
     }
 
+    return total;
+}
+
+/*
+ * effects_buffer_size
+ *
+ * Returns the size of effect buffer that effects_setup() will need at the
+ * given sample rate, or 0 if out of memory.
+ */
+size_t
+effects_buffer_size(unsigned long sample_rate)
+{
+    y_synth_t *probe = (y_synth_t *)calloc(1, sizeof(y_synth_t));
+    size_t size;
+
+    if (!probe)
+        return 0;
+    probe->sample_rate = (float)sample_rate;
+    size = effects_layout_regions(probe);
+    free(probe);
+
+    return size;
+}
+
+/*
+ * effects_setup
+ *
+ * Lays out the effect regions within buffer, which must be zero-filled and
+ * at least effects_buffer_size() bytes long.
+ */
+int
+effects_setup(y_synth_t *synth, char *buffer)
+{
+    if (!buffer || !effects_layout_regions(synth))
+        return 0;
+
+    synth->effect_buffer = buffer;
+    synth->effect_region_pending = 0;
+
     return 1;
 }
 
@@ -106,8 +167,58 @@ effects_setup(y_synth_t *synth)
 void
 effects_cleanup(y_synth_t *synth)
 {
-    if (synth->effect_buffer) free(synth->effect_buffer);
-    synth->effect_buffer = NULL;
+    synth->effect_buffer = NULL;  /* belongs to the instance's arena */
+    effect_convolution_cleanup(synth);
+}
+
+/*
+ * effects_clear_regions
+ *
+ * Called from the non-realtime worker thread, with global.instance_list_mutex
+ * held (but not global.sampleset_mutex, which the audio thread tries), to
+ * silence any regions the audio thread has left dirty.
+ */
+void
+effects_clear_regions(y_synth_t *synth)
+{
+    struct y_effect_region *region;
+    int mode;
+
+    if (!synth->effect_buffer)
+        return;
+
+    for (mode = 1; mode <= Y_EFFECT_MODE_COUNT; mode++) {
+        region = &synth->effect_region[mode];
+        if (!__sync_bool_compare_and_swap(&region->state, Y_EFFECT_REGION_DIRTY,
+                                          Y_EFFECT_REGION_CLEARING))
+            continue;
+        memset(synth->effect_buffer + region->silence, 0, region->end - region->silence);
+        __sync_synchronize();
+        region->state = Y_EFFECT_REGION_CLEAN;
+    }
+}
+
+/*
+ * effects_release_region
+ *
+ * Called from the audio thread when the current effect is switched away from,
+ * to hand its region over to the worker thread for silencing.
+ */
+void
+effects_release_region(y_synth_t *synth)
+{
+    struct y_effect_region *region;
+
+    if (synth->last_effect_mode <= 0)
+        return;
+    region = &synth->effect_region[synth->last_effect_mode];
+    if (region->end == region->silence) {  /* nothing to silence */
+        __sync_bool_compare_and_swap(&region->state, Y_EFFECT_REGION_IN_USE,
+                                     Y_EFFECT_REGION_CLEAN);
+    } else if (__sync_bool_compare_and_swap(&region->state, Y_EFFECT_REGION_IN_USE,
+                                            Y_EFFECT_REGION_DIRTY)) {
+        sampleset_signal_worker();
+    }
 }
 
 /*
@@ -120,11 +231,18 @@ effects_process(y_synth_t *synth, unsigned long sample_count,
     unsigned long i;
     int current_effect_mode = lrintf(*(synth->effect_mode)); /* will not be 0 */
 
+    if (current_effect_mode < 0 || current_effect_mode > Y_EFFECT_MODE_COUNT)
+        current_effect_mode = 0;  /* unknown mode: DC blocker only */
+
     if (current_effect_mode != synth->last_effect_mode) {
+        struct y_effect_region *region;
 
+        effects_release_region(synth);
         synth->last_effect_mode = current_effect_mode;
+        synth->effect_mix_last = *(synth->effect_mix);  /* start without a mix ramp */
+        region = &synth->effect_region[current_effect_mode];
 
-        effects_start_allocation(synth);
+        synth->effect_buffer_allocation = region->start;
         /* assume we need to silence entire allocation unless effect says otherwise */
         effects_request_silencing_of_subsequent_allocations(synth);
         switch(current_effect_mode) {
@@ -142,15 +260,36 @@ effects_process(y_synth_t *synth, unsigned long sample_count,
             effect_screverb_request_buffers(synth);
             effect_screverb_setup(synth);
             break;
+
+          case 4:  /* Convolution: uses no effect buffer */
+            effect_convolution_setup(synth);
+            break;
+        }
+
+        region->silence = synth->effect_buffer_silence_count;
+        synth->effect_region_pending = 0;
+        synth->effect_buffer_silence_count = 0;   /* the worker silences regions */
+        if (!__sync_bool_compare_and_swap(&region->state, Y_EFFECT_REGION_CLEAN,
+                                          Y_EFFECT_REGION_IN_USE)) {
+            /* the worker is clearing it, or hasn't got to it yet: run dry
+             * until it is done, rather than clearing it here */
+            synth->effect_region_pending = 1;
+            sampleset_signal_worker();
         }
     }
 
-    if (synth->effect_buffer_silence_count) /* buffer is still dirty */
+    if (synth->effect_region_pending &&
+        __sync_bool_compare_and_swap(&synth->effect_region[current_effect_mode].state,
+                                     Y_EFFECT_REGION_CLEAN, Y_EFFECT_REGION_IN_USE))
+        synth->effect_region_pending = 0;
+
+    if (synth->effect_region_pending)  /* region is still dirty */
         current_effect_mode = 0;
 
     switch(current_effect_mode) {
 
-      case 0:  /* effect buffer is still dirty, so silence some of it after running the DC blocker */
+      case 0:  /* no effect, or its region is still dirty and the worker thread
+                * is silencing it, so just run the DC blocker */
         {   float r = synth->dc_block_r,
                   l_xnm1 = synth->dc_block_l_xnm1,
                   l_ynm1 = synth->dc_block_l_ynm1,
@@ -158,6 +297,8 @@ effects_process(y_synth_t *synth, unsigned long sample_count,
                   r_ynm1 = synth->dc_block_r_ynm1;
             float dry = 1.0f - *(synth->effect_mix);
 
+            synth->effect_mix_last = *(synth->effect_mix);
+
             for (i = 0; i < sample_count; i++) {
                 l_ynm1 = synth->voice_bus_l[i] - l_xnm1 + r * l_ynm1;
                 l_xnm1 = synth->voice_bus_l[i];
@@ -171,15 +312,6 @@ effects_process(y_synth_t *synth, unsigned long sample_count,
             synth->dc_block_r_xnm1 = r_xnm1;
             synth->dc_block_r_ynm1 = r_ynm1;
 
-            i = synth->effect_buffer_allocation - synth->effect_buffer_silence_count;
-            if (i > 8 * sample_count * sizeof(float)) {
-                i = 8 * sample_count * sizeof(float);
-                memset(synth->effect_buffer + synth->effect_buffer_silence_count, 0, i);
-                synth->effect_buffer_silence_count += i;
-            } else {
-                memset(synth->effect_buffer + synth->effect_buffer_silence_count, 0, i);
-                synth->effect_buffer_silence_count = 0;
-            }
         }
         break;
 
@@ -194,6 +326,10 @@ effects_process(y_synth_t *synth, unsigned long sample_count,
       case 3:  /* Sean Costello's reverb */
         effect_screverb_process(synth, sample_count, out_left, out_right);
         break;
+
+      case 4:  /* Convolution */
+        effect_convolution_process(synth, sample_count, out_left, out_right);
+        break;
     }
 }
 
@@ -45,10 +45,43 @@ effects_request_silencing_of_subsequent_allocations(y_synth_t *synth)
     synth->effect_buffer_silence_count = synth->effect_buffer_allocation;
 }
 
+/*
+ * effects_region_buffer
+ *
+ * Returns the start of the current effect's region of the effect buffer,
+ * where its request_buffers() function put its state.
+ */
+static inline void *
+effects_region_buffer(y_synth_t *synth)
+{
+    return synth->effect_buffer + synth->effect_region[synth->last_effect_mode].start;
+}
+
+/*
+ * effects_mix_ramp
+ *
+ * Returns the effect mix as it stood at the end of the previous effect block,
+ * and sets *delta to the per-sample step that brings it to the current port
+ * value by the end of this block, so that a mix change made mid-buffer glides
+ * across the block instead of stepping at its start.
+ */
+static inline float
+effects_mix_ramp(y_synth_t *synth, unsigned long sample_count, float *delta)
+{
+    float start = synth->effect_mix_last;
+
+    synth->effect_mix_last = *(synth->effect_mix);
+    *delta = (synth->effect_mix_last - start) / (float)sample_count;
+    return start;
+}
+
 /* in effects.c: */
 void *effects_request_buffer(y_synth_t *synth, size_t size);
-int   effects_setup(y_synth_t *synth);
+size_t effects_buffer_size(unsigned long sample_rate);
+int   effects_setup(y_synth_t *synth, char *buffer);
 void  effects_cleanup(y_synth_t *synth);
+void  effects_clear_regions(y_synth_t *synth);
+void  effects_release_region(y_synth_t *synth);
 void  effects_process(y_synth_t *synth, unsigned long sample_count,
                       LADSPA_Data *out_left, LADSPA_Data *out_right);
 
@@ -68,4 +101,11 @@ void effect_screverb_setup(y_synth_t *synth);
 void effect_screverb_process(y_synth_t *synth, unsigned long sample_count,
                              LADSPA_Data *out_left, LADSPA_Data *out_right);
 
+/* in effect_convolution.c: */
+char *effect_convolution_load(y_synth_t *synth, const char *filename);
+void  effect_convolution_setup(y_synth_t *synth);
+void  effect_convolution_cleanup(y_synth_t *synth);
+void  effect_convolution_process(y_synth_t *synth, unsigned long sample_count,
+                                 LADSPA_Data *out_left, LADSPA_Data *out_right);
+
 #endif /* _EFFECTS_H */
@@ -308,9 +308,10 @@ on_save_file_chooser_response(GtkDialog *dialog, gint response, gpointer data)
             set_file_chooser_path(GTK_FILE_CHOOSER(open_file_chooser), filename);
 
         mode_item = gtk_combo_box_get_active(GTK_COMBO_BOX(save_file_mode_combo));
-        if (mode_item == 0 || mode_item == 1) {
+        if (mode_item >= 0 && mode_item <= 2) {
 
-            int format = 1 - mode_item; /* format 0: backward-compatible, format 1: current */
+            /* format 0: backward-compatible, format 1: current, format 2: binary bank */
+            int format = (mode_item == 2 ? Y_PATCH_FORMAT_BANK : 1 - mode_item);
 
             if (gui_data_save(filename, save_file_start, save_file_end, format, &message)) {
 
@@ -334,7 +335,7 @@ on_save_file_chooser_response(GtkDialog *dialog, gint response, gpointer data)
 
             }
 #ifdef DEVELOPER
-        } else if (mode_item == 2) {
+        } else if (mode_item == 3) {
             if (gui_data_save_as_c(filename, save_file_start, save_file_end, &message)) {
 
                 display_notice("Save Patches as 'C' succeeded:", message);
@@ -1076,9 +1077,21 @@ on_edit_save_position_ok( GtkWidget *widget, gpointer data )
                        PATCHES_LIST_COL_NAME, patches[position].name,
                        -1);
 
-    /* our patch bank is now dirty, so we need to save a temporary copy
-     * for the plugin to load */
-    if (gui_data_save_dirty_patches_to_tmp()) {
+    /* our patch bank is now dirty, so the plugin needs to load it from a
+     * temporary copy -- but if the plugin already has our temporary copy,
+     * store just this patch into it, and send the plugin just this patch */
+    if (last_configure_load_was_from_tmp && gui_data_update_tmp_patch(position)) {
+        char *value = (char *)malloc(Y_PATCH_ENCODED_SIZE +
+                                     strlen(patches_tmp_filename) + 16);
+
+        sprintf(value, "%d ", position);
+        y_data_encode_patch(&patches[position], value + strlen(value));
+        strcat(value, " ");
+        strcat(value, patches_tmp_filename);
+        lo_send(osc_host_address, osc_configure_path, "ss", "patch", value);
+        free(value);
+
+    } else if (gui_data_save_dirty_patches_to_tmp()) {
         lo_send(osc_host_address, osc_configure_path, "ss", "load",
                 patches_tmp_filename);
         last_configure_load_was_from_tmp = 1;
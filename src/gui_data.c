@@ -49,127 +49,6 @@
 #include "gui_main.h"
 #include "common_data.h"
 
-static void
-patch_write_text(FILE *file, char *text, int maxlen)
-{
-    int i;
-
-    for (i = 0; i < maxlen; i++) {
-        if (!text[i]) {
-            break;
-        } else if (text[i] < 33 || text[i] > 126 ||
-                   text[i] == '%') {
-            fprintf(file, "%%%02x", (unsigned char)text[i]);
-        } else {
-            fputc(text[i], file);
-        }
-    }
-}
-
-static int
-patch_write_osc(FILE *file, int index, struct posc *osc)
-{
-    return fprintf(file, "oscY %d %d %d %d %.6g %d %.6g %.6g %.6g %d %.6g %d %.6g %.6g %.6g\n",
-                   index, osc->mode, osc->waveform, osc->pitch, osc->detune,
-                   osc->pitch_mod_src, osc->pitch_mod_amt, osc->mparam1,
-                   osc->mparam2, osc->mmod_src, osc->mmod_amt,
-                   osc->amp_mod_src, osc->amp_mod_amt,
-                   osc->level_a, osc->level_b);
-}
-
-static int
-patch_write_vcf(FILE *file, int index, struct pvcf *vcf)
-{
-    return fprintf(file, "vcfY %d %d %d %.6g %d %.6g %.6g %.6g\n",
-                   index, vcf->mode, vcf->source, vcf->frequency,
-                   vcf->freq_mod_src, vcf->freq_mod_amt, vcf->qres,
-                   vcf->mparam);
-}
-
-static int
-patch_write_lfo(FILE *file, char which, struct plfo *lfo)
-{
-    return fprintf(file, "lfoY %c %.6g %d %.6g %d %.6g\n",
-                   which, lfo->frequency, lfo->waveform, lfo->delay,
-                   lfo->amp_mod_src, lfo->amp_mod_amt);
-}
-
-static int
-patch_write_eg(FILE *file, char which, struct peg *eg)
-{
-    return fprintf(file, "egY %c %d %d %.6g %.6g %d %.6g %.6g %d %.6g %.6g %d %.6g %.6g %.6g %.6g %d %.6g\n",
-                   which, eg->mode,
-                   eg->shape1, eg->time1, eg->level1,
-                   eg->shape2, eg->time2, eg->level2,
-                   eg->shape3, eg->time3, eg->level3,
-                   eg->shape4, eg->time4,
-                   eg->vel_level_sens, eg->vel_time_scale, eg->kbd_time_scale,
-                   eg->amp_mod_src, eg->amp_mod_amt);
-}
-
-int
-gui_data_write_patch(FILE *file, y_patch_t *patch, int format)
-{
-    fprintf(file, "# WhySynth patch\n");
-    fprintf(file, "WhySynth patch format %d begin\n", format);
-
-    fprintf(file, "name ");
-    patch_write_text(file, patch->name, 30);
-    if (strlen(patch->category)) {
-        if (format == 0) {
-            fputc(' ', file); /* piggy back category on the name field */
-        } else {
-            fputc('\n', file); /* put it on its own line */
-        }
-        fprintf(file, "category ");
-        patch_write_text(file, patch->category, 10);
-    }
-    fputc('\n', file);
-
-    if (strlen(patch->comment)) {
-        fprintf(file, "comment ");
-        patch_write_text(file, patch->comment, 60);
-        fputc('\n', file);
-    }
-
-    /* -PORTS- */
-    patch_write_osc(file, 1, &patch->osc1);
-    patch_write_osc(file, 2, &patch->osc2);
-    patch_write_osc(file, 3, &patch->osc3);
-    patch_write_osc(file, 4, &patch->osc4);
-    patch_write_vcf(file, 1, &patch->vcf1);
-    patch_write_vcf(file, 2, &patch->vcf2);
-    fprintf(file, "mix %.6g %.6g %.6g %.6g %.6g %.6g %.6g %.6g\n",
-            patch->busa_level, patch->busa_pan,
-            patch->busb_level, patch->busb_pan,
-            patch->vcf1_level, patch->vcf1_pan,
-            patch->vcf2_level, patch->vcf2_pan);
-    fprintf(file, "volume %.6g\n", patch->volume);
-    fprintf(file, "effects %d %.6g %.6g %.6g %.6g %.6g %.6g %.6g\n",
-            patch->effect_mode, patch->effect_param1, patch->effect_param2,
-            patch->effect_param3, patch->effect_param4, patch->effect_param5,
-            patch->effect_param6, patch->effect_mix);
-    fprintf(file, "glide %.6g\n", patch->glide_time);
-    fprintf(file, "bend %d\n", patch->bend_range);
-    patch_write_lfo(file, 'g', &patch->glfo);
-    patch_write_lfo(file, 'v', &patch->vlfo);
-    patch_write_lfo(file, 'm', &patch->mlfo);
-    fprintf(file, "mlfo %.6g %.6g\n", patch->mlfo_phase_spread,
-            patch->mlfo_random_freq);
-    patch_write_eg(file, 'o', &patch->ego);
-    patch_write_eg(file, '1', &patch->eg1);
-    patch_write_eg(file, '2', &patch->eg2);
-    patch_write_eg(file, '3', &patch->eg3);
-    patch_write_eg(file, '4', &patch->eg4);
-    fprintf(file, "modmix %.6g %d %.6g %d %.6g\n", patch->modmix_bias,
-            patch->modmix_mod1_src, patch->modmix_mod1_amt,
-            patch->modmix_mod2_src, patch->modmix_mod2_amt);
-
-    fprintf(file, "WhySynth patch end\n");
-
-    return 1;  /* -FIX- error handling yet to be implemented */
-}
-
 #if (THREAD_LOCALE_LOCALE_H || THREAD_LOCALE_XLOCALE_H)
 /* it would be nice if glibc had fprintf_l() and sscanf_l().... */
 
@@ -213,21 +92,28 @@ gui_data_save(char *filename, int start, int end, int format, char **message)
 
     GDB_MESSAGE(GDB_IO, " gui_data_save: attempting to save '%s'\n", filename);
 
-    if ((fh = fopen(filename, "wb")) == NULL) {
-        if (message) *message = strdup("could not open file for writing");
-        return 0;
-    }
-    y_set_C_numeric_locale();
-    for (i = start; i <= end; i++) {
-        if (!gui_data_write_patch(fh, &patches[i], format)) {
-            y_restore_old_numeric_locale();
-            fclose(fh);
+    if (format == Y_PATCH_FORMAT_BANK) {
+        if (!y_data_save_bank(filename, &patches[start], end - start + 1)) {
             if (message) *message = strdup("error while writing file");
             return 0;
         }
+    } else {
+        if ((fh = fopen(filename, "wb")) == NULL) {
+            if (message) *message = strdup("could not open file for writing");
+            return 0;
+        }
+        y_set_C_numeric_locale();
+        for (i = start; i <= end; i++) {
+            if (!y_data_write_patch(fh, &patches[i], format)) {
+                y_restore_old_numeric_locale();
+                fclose(fh);
+                if (message) *message = strdup("error while writing file");
+                return 0;
+            }
+        }
+        y_restore_old_numeric_locale();
+        fclose(fh);
     }
-    y_restore_old_numeric_locale();
-    fclose(fh);
 
     if (message) {
         snprintf(buffer, 20, "wrote %d patches", end - start + 1);
@@ -238,27 +124,24 @@ gui_data_save(char *filename, int start, int end, int format, char **message)
 
 /*
  * gui_data_save_dirty_patches_to_tmp
+ *
+ * The temporary bank is a binary one, so the plugin can load it without
+ * parsing it, and so gui_data_update_tmp_patch() can store single patches
+ * into it without formatting the rest.
  */
 int
 gui_data_save_dirty_patches_to_tmp(void)
 {
-    FILE *fh;
-    int i;
+    return y_data_save_bank(patches_tmp_filename, patches, patch_count);
+}
 
-    if ((fh = fopen(patches_tmp_filename, "wb")) == NULL) {
-        return 0;
-    }
-    y_set_C_numeric_locale();
-    for (i = 0; i < patch_count; i++) {
-        if (!gui_data_write_patch(fh, &patches[i], 1)) {
-            y_restore_old_numeric_locale();
-            fclose(fh);
-            return 0;
-        }
-    }
-    y_restore_old_numeric_locale();
-    fclose(fh);
-    return 1;
+/*
+ * gui_data_update_tmp_patch
+ */
+int
+gui_data_update_tmp_patch(int index)
+{
+    return y_data_update_bank(patches_tmp_filename, index, &patches[index]);
 }
 
 /*
@@ -291,26 +174,44 @@ gui_data_check_patches_allocation(int patch_index)
 int
 gui_data_load(const char *filename, int position, char **message)
 {
-    FILE *fh;
+    char *text;
+    const char *p;
     int count = 0;
     int index = position;
     char buffer[32];
+    y_patch_t *bank;
 
     GDB_MESSAGE(GDB_IO, " gui_data_load: attempting to load '%s'\n", filename);
 
-    if ((fh = fopen(filename, "rb")) == NULL) {
-        if (message) *message = strdup("could not open file for reading");
+    switch (y_data_read_bank(filename, &bank, &count)) {
+      case 1:
+        gui_data_check_patches_allocation(position + count - 1);
+        memcpy(&patches[position], bank, count * sizeof(y_patch_t));
+        free(bank);
+        index = position + count;
+        break;
+
+      case -1:
+        if (message) *message = strdup("patch bank is damaged or incompatible");
         return 0;
-    }
 
-    while (1) {
-        gui_data_check_patches_allocation(index);
-        if (!y_data_read_patch(fh, &patches[index]))
-            break;
-        count++;
-        index++;
+      default:  /* not a binary bank, so parse it as text */
+        if ((text = y_data_read_file(filename)) == NULL) {
+            if (message) *message = strdup("could not open file for reading");
+            return 0;
+        }
+
+        p = text;
+        while (1) {
+            gui_data_check_patches_allocation(index);
+            if (!y_data_parse_patch(&p, &patches[index]))
+                break;
+            count++;
+            index++;
+        }
+        free(text);
+        break;
     }
-    fclose(fh);
 
     if (!count) {
         if (message) *message = strdup("no patches recognized");
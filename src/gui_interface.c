@@ -954,6 +954,8 @@ create_save_file_chooser (const char *tag)
                                    "Current (version 1)");
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(save_file_mode_combo),
                                    "Backward-compatible (version 0)");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(save_file_mode_combo),
+                                   "Binary Bank (fast loading)");
 #ifdef DEVELOPER
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(save_file_mode_combo), "'C' Source Code");
 #endif /* DEVELOPER */
@@ -1136,6 +1138,7 @@ struct y_effect_modes_t y_effect_modes[Y_EFFECT_MODE_COUNT + 2] = {
     { "Plate Reverb",    0,  1,  NULL,    NULL,        NULL,           "Bandwidth",   "Tail",           "Damping" },
     { "Dual Delay",      0,  2,  NULL,    "Feedback",  "Feed Across",  "Left Delay",  "Right Delay",    "Damping" },
     { "SC Reverb",       0,  3,  NULL,    NULL,        NULL,           "Feedback",    "Low Pass Freq",  "Pitch Mod" },
+    { "Convolution",     0,  4,  NULL,    NULL,        NULL,           NULL,          NULL,             NULL },
     { NULL }
 };
 
@@ -168,6 +168,10 @@ osc_configure_handler(const char *path, const char *types, lo_arg **argv,
 
         update_load(value);
 
+    } else if (!strcmp(key, "patch")) {
+
+        /* a patch we stored ourselves, into the bank 'load' names */
+
     } else if (!strcmp(key, "polyphony")) {
 
         update_polyphony(value);
@@ -239,11 +239,13 @@ padsynth_render(y_sample_t *sample)
     if (global.padsynth_table_size != N) {
         padsynth_free_temp();
         if (global.padsynth_ifft_plan) {
+            pthread_mutex_lock(&global.fftw_planner_mutex);
 #ifdef FFTW_VERSION_2
             rfftw_destroy_plan(global.padsynth_ifft_plan);
 #else
             fftwf_destroy_plan(global.padsynth_ifft_plan);
 #endif
+            pthread_mutex_unlock(&global.fftw_planner_mutex);
             global.padsynth_ifft_plan = NULL;
         }
         global.padsynth_table_size = N;
@@ -256,7 +258,9 @@ padsynth_render(y_sample_t *sample)
         return 0;
     outfreqs = global.padsynth_outfreqs;
     smp = global.padsynth_outsamples;
-    if (!global.padsynth_ifft_plan)
+    if (!global.padsynth_ifft_plan) {
+        /* the convolution effect may be planning in a configure call */
+        pthread_mutex_lock(&global.fftw_planner_mutex);
         global.padsynth_ifft_plan =
 #ifdef FFTW_VERSION_2
             (void *)rfftw_create_plan(N, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE);
@@ -265,6 +269,8 @@ padsynth_render(y_sample_t *sample)
                                       global.padsynth_outsamples,
                                       FFTW_HC2R, FFTW_ESTIMATE);
 #endif
+        pthread_mutex_unlock(&global.fftw_planner_mutex);
+    }
     if (!global.padsynth_ifft_plan)
         return 0;
 
@@ -517,7 +523,7 @@ bspline_interp(float x, float ym1, float y0, float y1, float y2)
     return ((c3 * x + c2) * x + c1) * x + c0;
 }
 
-void
+int
 padsynth_oscillator(unsigned long sample_count, y_sosc_t *sosc,
                     y_voice_t *voice, struct vosc *vosc, int index, float w0)
 {
@@ -619,7 +625,7 @@ padsynth_oscillator(unsigned long sample_count, y_sosc_t *sosc,
         }
 
         vosc->pos0 = (double)pos;
-        return;
+        return 0;
     }
 
     if (sosc->sampleset->param3 & 1) {  /* mono */
@@ -816,5 +822,6 @@ padsynth_oscillator(unsigned long sample_count, y_sosc_t *sosc,
         vosc->pos1 = posl1;
       }
     }
+    return 1;
 }
 
@@ -28,7 +28,7 @@ void padsynth_fini(void);
 void padsynth_free_temp(void);
 void padsynth_sampletable_setup(y_sampleset_t *sampleset);
 int  padsynth_render(y_sample_t *sample);
-void padsynth_oscillator(unsigned long sample_count, y_sosc_t *sosc,
+int  padsynth_oscillator(unsigned long sample_count, y_sosc_t *sosc,
                          y_voice_t *voice, struct vosc *vosc,
                          int index, float w);
 
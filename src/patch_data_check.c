@@ -0,0 +1,251 @@
+/* WhySynth DSSI software synthesizer plugin and GUI
+ *
+ * Copyright (C) 2004-2017 Sean Bolton and others.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/* patch_data_check.c
+ *
+ * Round-trip test and benchmark for the patch file code in common_data.c,
+ * run by 'make check'.  Each patch file named on the command line (by
+ * default, the banks in extra/) is parsed, written back as text and
+ * re-parsed, then written as a binary bank, updated, and read back, and
+ * each patch encoded and decoded as for the 'patch' configure key; every
+ * copy must match the first parse exactly.  The time taken to parse each
+ * file is reported.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "whysynth_types.h"
+#include "whysynth_voice.h"
+#include "common_data.h"
+
+#ifndef Y_PATCH_DIR
+#define Y_PATCH_DIR  "../extra"
+#endif
+
+#define TMP_TEXT_FILE  "patch_data_check.tmp"
+#define TMP_BANK_FILE  "patch_data_check.bank"
+
+/* times each file is parsed for the benchmark */
+#define BENCHMARK_PASSES  20
+
+static const char *default_files[] = {
+    "current_default_patches.WhySynth",
+    "more_K4_interpretations.WhySynth",
+    "version_20051005_patches.WhySynth",
+    "version_20051231_patches.WhySynth",
+    "version_20090608_patches.WhySynth",
+    "version_20100922_patches.WhySynth",
+    "version_20120903_patches.WhySynth",
+    NULL
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * parse_file
+ *
+ * Parses all the patches in a text patch file into a malloc()ed array,
+ * returning the number parsed, or -1 if the file could not be read.
+ */
+static int
+parse_file(const char *filename, y_patch_t **patches)
+{
+    char *text;
+    const char *p;
+    int count = 0, allocated = 0;
+    y_patch_t *bank = NULL;
+
+    if ((text = y_data_read_file(filename)) == NULL)
+        return -1;
+
+    p = text;
+    while (1) {
+        if (count >= allocated) {
+            allocated = allocated ? allocated * 2 : 128;
+            bank = (y_patch_t *)realloc(bank, allocated * sizeof(y_patch_t));
+            if (!bank) {
+                fprintf(stderr, "out of memory\n");
+                exit(1);
+            }
+        }
+        if (!y_data_parse_patch(&p, &bank[count]))
+            break;
+        count++;
+    }
+    free(text);
+
+    *patches = bank;
+    return count;
+}
+
+/*
+ * compare_patches
+ *
+ * Returns the number of patches which differ between two sets.
+ */
+static int
+compare_patches(const char *filename, const char *what, y_patch_t *a,
+                y_patch_t *b, int count)
+{
+    int i, errors = 0;
+
+    for (i = 0; i < count; i++) {
+        if (memcmp(&a[i], &b[i], sizeof(y_patch_t))) {
+            fprintf(stderr, "%s: patch %d '%s' changed by %s\n",
+                    filename, i, a[i].name, what);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/*
+ * check_file
+ *
+ * Runs the round trips and benchmark on one patch file, returning the
+ * number of errors found.
+ */
+static int
+check_file(const char *filename)
+{
+    y_patch_t *patches, *copy, decoded;
+    char encoded[Y_PATCH_ENCODED_SIZE + 1];
+    const char *end;
+    FILE *fh;
+    double start, elapsed;
+    int count, copy_count, i, errors = 0;
+
+    if ((count = parse_file(filename, &patches)) <= 0) {
+        fprintf(stderr, "%s: %s\n", filename,
+                count < 0 ? "could not read file" : "no patches recognized");
+        return 1;
+    }
+
+    /* benchmark */
+    start = now();
+    for (i = 0; i < BENCHMARK_PASSES; i++) {
+        parse_file(filename, &copy);
+        free(copy);
+    }
+    elapsed = (now() - start) / BENCHMARK_PASSES;
+    printf("%s: %d patches, parsed in %.3f ms (%.2f us per patch)\n",
+           filename, count, elapsed * 1e3, elapsed * 1e6 / count);
+
+    /* text */
+    if ((fh = fopen(TMP_TEXT_FILE, "wb")) == NULL) {
+        fprintf(stderr, "could not open '%s' for writing\n", TMP_TEXT_FILE);
+        free(patches);
+        return 1;
+    }
+    for (i = 0; i < count; i++)
+        y_data_write_patch(fh, &patches[i], 1);
+    if (fclose(fh)) {
+        fprintf(stderr, "error while writing '%s'\n", TMP_TEXT_FILE);
+        errors++;
+    } else if ((copy_count = parse_file(TMP_TEXT_FILE, &copy)) != count) {
+        fprintf(stderr, "%s: %d patches written as text, %d read back\n",
+                filename, count, copy_count);
+        errors++;
+        if (copy_count >= 0)
+            free(copy);
+    } else {
+        errors += compare_patches(filename, "text round trip", patches, copy, count);
+        free(copy);
+    }
+    unlink(TMP_TEXT_FILE);
+
+    /* binary bank */
+    if (!y_data_save_bank(TMP_BANK_FILE, patches, count)) {
+        fprintf(stderr, "error while writing '%s'\n", TMP_BANK_FILE);
+        errors++;
+    } else if (y_data_read_bank(TMP_BANK_FILE, &copy, &copy_count) != 1 ||
+               copy_count != count) {
+        fprintf(stderr, "%s: binary bank could not be read back\n", filename);
+        errors++;
+    } else {
+        errors += compare_patches(filename, "binary bank round trip", patches, copy, count);
+        free(copy);
+
+        /* store one record over another, and append one */
+        if (!y_data_update_bank(TMP_BANK_FILE, 0, &patches[count - 1]) ||
+            !y_data_update_bank(TMP_BANK_FILE, count, &patches[0]) ||
+            y_data_read_bank(TMP_BANK_FILE, &copy, &copy_count) != 1 ||
+            copy_count != count + 1) {
+            fprintf(stderr, "%s: binary bank could not be updated\n", filename);
+            errors++;
+        } else {
+            errors += compare_patches(filename, "bank update", &patches[count - 1], copy, 1);
+            errors += compare_patches(filename, "bank update", &patches[1], &copy[1], count - 1);
+            errors += compare_patches(filename, "bank append", &patches[0], &copy[count], 1);
+            free(copy);
+        }
+    }
+    unlink(TMP_BANK_FILE);
+
+    /* configure key encoding */
+    for (i = 0; i < count; i++) {
+        y_data_encode_patch(&patches[i], encoded);
+        end = y_data_decode_patch(encoded, &decoded);
+        if (!end || *end || memcmp(&patches[i], &decoded, sizeof(y_patch_t))) {
+            fprintf(stderr, "%s: patch %d '%s' changed by encoding\n",
+                    filename, i, patches[i].name);
+            errors++;
+        }
+    }
+
+    free(patches);
+    return errors;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char path[1024];
+    int i, errors = 0;
+
+    if (argc > 1) {
+        for (i = 1; i < argc; i++)
+            errors += check_file(argv[i]);
+    } else {
+        for (i = 0; default_files[i]; i++) {
+            snprintf(path, sizeof(path), "%s/%s", Y_PATCH_DIR, default_files[i]);
+            errors += check_file(path);
+        }
+    }
+
+    if (errors)
+        fprintf(stderr, "%d errors\n", errors);
+    return errors ? 1 : 0;
+}
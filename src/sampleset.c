@@ -35,17 +35,19 @@
 #include "whysynth_types.h"
 #include "whysynth.h"
 #include "whysynth_ports.h"
+#include "dssp_synth.h"
 #include "dssp_event.h"
 #include "wave_tables.h"
 #include "sampleset.h"
 #include "padsynth.h"
+#include "effects.h"
 
 /* ==== utility routines ==== */
 
 static inline void
 signal_worker_thread(void)
 {
-    char c;
+    char c = 0;
 
     if (write(global.sampleset_pipe_fd[1], &c, 1) != 1) {
         YDB_MESSAGE(-1, " sampleset signal_worker_thread ERROR: cannot write pipe: %s\n", strerror(errno));
@@ -205,10 +207,14 @@ int
 sampleset_init(void)
 {
     pthread_mutex_init(&global.sampleset_mutex, NULL);
+    pthread_mutex_init(&global.instance_list_mutex, NULL);
+    pthread_mutex_init(&global.fftw_planner_mutex, NULL);
+    global.instance_list = NULL;
     global.sampleset_pipe_fd[0] = -1;
     global.sampleset_pipe_fd[1] = -1;
     global.worker_thread_started = 0;
     global.worker_thread_done = 0;
+    global.oscillators_reserved = 0;
     global.samplesets_allocated = 0;
     global.active_sampleset_list = NULL;
     global.free_sampleset_list = NULL;
@@ -249,49 +255,133 @@ sampleset_init(void)
     return 1;
 }
 
+/*
+ * sampleset_reserve
+ *
+ * Makes sure enough samplesets and samples are allocated for another
+ * 'oscillators' oscillators, four for each part of each instance.
+ */
 int
-sampleset_instantiate(y_synth_t *synth)
+sampleset_reserve(int oscillators)
 {
-    /* make sure enough samplesets and samples are allocated for instance count */
-    while (global.samplesets_allocated < global.instance_count * 4 + 1) {
+    int rv = 1;
+
+    pthread_mutex_lock(&global.sampleset_mutex);
+
+    global.oscillators_reserved += oscillators;
+
+    while (global.samplesets_allocated < global.oscillators_reserved + 1) {
         y_sampleset_t *ss = (y_sampleset_t *)calloc(1, sizeof(y_sampleset_t));
-        if (!ss)
-            return 0;
+        if (!ss) {
+            rv = 0;
+            break;
+        }
         ss->next = global.free_sampleset_list;
         global.free_sampleset_list = ss;
         global.samplesets_allocated++;
     }
 
-    while (global.samples_allocated < global.instance_count * 4 * WAVETABLE_MAX_WAVES + 1) {
+    while (rv && global.samples_allocated < global.oscillators_reserved * WAVETABLE_MAX_WAVES + 1) {
         y_sample_t *s = (y_sample_t *)calloc(1, sizeof(y_sample_t));
-        if (!s)
-            return 0;
+        if (!s) {
+            rv = 0;
+            break;
+        }
         s->next = global.free_sample_list;
         global.free_sample_list = s;
         global.samples_allocated++;
     }
 
+    if (!rv)
+        global.oscillators_reserved -= oscillators;
+
+    pthread_mutex_unlock(&global.sampleset_mutex);
+
+    return rv;
+}
+
+int
+sampleset_instantiate(y_synth_t *synth)
+{
+    /* make sure enough samplesets and samples are allocated for part 0 */
+    if (!sampleset_reserve(4))
+        return 0;
+    synth->parts_reserved = 1;
+
+    /* let the worker thread find the instance's effect buffer */
+    pthread_mutex_lock(&global.instance_list_mutex);
+    synth->next_instance = global.instance_list;
+    global.instance_list = synth;
+    pthread_mutex_unlock(&global.instance_list_mutex);
+
     return 1;
 }
 
+/*
+ * sampleset_release_oscillators
+ *
+ * Releases any samplesets held by a part's oscillators, returning true if
+ * there were any.  The sampleset mutex must be locked before calling this.
+ */
+static int
+sampleset_release_oscillators(y_part_t *part)
+{
+    y_sosc_t *sosc[4] = { &part->osc1, &part->osc2, &part->osc3, &part->osc4 };
+    int i, released = 0;
+
+    for (i = 0; i < 4; i++) {
+        if (sosc[i]->sampleset) {
+            sampleset_release(sosc[i]->sampleset);
+            sosc[i]->sampleset = NULL;
+            released = 1;
+        }
+    }
+    return released;
+}
+
+/*
+ * sampleset_part_release
+ *
+ * Releases the samplesets of a part no longer in use.  The part must not
+ * be rendered while this is called.
+ */
+void
+sampleset_part_release(y_part_t *part)
+{
+    pthread_mutex_lock(&global.sampleset_mutex);
+    if (sampleset_release_oscillators(part))
+        signal_worker_thread();
+    pthread_mutex_unlock(&global.sampleset_mutex);
+}
+
 void
 sampleset_cleanup(y_synth_t *synth)
 {
-    if (synth->osc1.sampleset ||
-        synth->osc2.sampleset ||
-        synth->osc3.sampleset ||
-        synth->osc4.sampleset) {
-
-        pthread_mutex_lock(&global.sampleset_mutex);
+    y_synth_t **prev;
+    int i, released;
+
+    /* once this returns, the worker thread is no longer clearing any of
+     * the instance's effect regions */
+    pthread_mutex_lock(&global.instance_list_mutex);
+    for (prev = &global.instance_list; *prev; prev = &(*prev)->next_instance) {
+        if (*prev == synth) {
+            *prev = synth->next_instance;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&global.instance_list_mutex);
 
-        if (synth->osc1.sampleset) sampleset_release(synth->osc1.sampleset);
-        if (synth->osc2.sampleset) sampleset_release(synth->osc2.sampleset);
-        if (synth->osc3.sampleset) sampleset_release(synth->osc3.sampleset);
-        if (synth->osc4.sampleset) sampleset_release(synth->osc4.sampleset);
+    pthread_mutex_lock(&global.sampleset_mutex);
 
+    released = 0;
+    for (i = 0; i < Y_MAX_PARTS && synth->part[i]; i++)
+        released |= sampleset_release_oscillators(synth->part[i]);
+    if (released)
         signal_worker_thread();
-        pthread_mutex_unlock(&global.sampleset_mutex);
-    }
+
+    global.oscillators_reserved -= 4 * synth->parts_reserved;
+
+    pthread_mutex_unlock(&global.sampleset_mutex);
 }
 
 void
@@ -352,6 +442,7 @@ sampleset_worker_function(void *arg)
         i;
     y_sampleset_t *ss, *render_ss = NULL;
     y_sample_t *sample, *needs_freeing_sample_list, *prev;
+    y_synth_t *synth;
 
     /* -FIX- ardour has:
      *    pthread_setcancelstate (PTHREAD_CANCEL_ENABLE, 0);
@@ -364,6 +455,18 @@ sampleset_worker_function(void *arg)
 
         YDB_MESSAGE(YDB_SAMPLE, " sampleset_worker_function: what needs to be done?\n");
 
+        /* silence any effect buffer regions left dirty by effect mode
+         * changes.  This doesn't need the sampleset mutex (the regions are
+         * handed over by their state), and mustn't hold it through the
+         * memset()s, or the audio threads' trylocks would fail meanwhile. */
+        pthread_mutex_lock(&global.instance_list_mutex);
+        for (synth = global.instance_list; synth; synth = synth->next_instance) {
+            effects_clear_regions(synth);
+            if (synth->adding_bus_wanted && !synth->adding_bus)
+                y_synth_add_adding_bus(synth);
+        }
+        pthread_mutex_unlock(&global.instance_list_mutex);
+
         pthread_mutex_lock(&global.sampleset_mutex);
 
         /* loop until no samples needing to be rendered are found */
@@ -528,6 +631,35 @@ sampleset_worker_function(void *arg)
 
 /* ==== realtime support routines ==== */
 
+/*
+ * sampleset_signal_worker
+ *
+ * wake the non-realtime worker thread, e.g. to have it silence an effect
+ * buffer region (the pipe is nonblocking, so this is safe from the audio thread)
+ */
+void
+sampleset_signal_worker(void)
+{
+    signal_worker_thread();
+}
+
+/*
+ * sampleset_check_lock
+ *
+ * make sure we hold the sampleset mutex, returning false if it could not be
+ * obtained without waiting
+ */
+static inline int
+sampleset_check_lock(y_synth_t *synth, int *changed)
+{
+    if (*changed || !pthread_mutex_trylock(&global.sampleset_mutex)) {
+        *changed = 1;
+        return 1;
+    }
+    synth->telemetry.sampleset_busy++;
+    return 0;
+}
+
 static inline void
 sampleset_check_oscillator(y_synth_t *synth, y_sosc_t *sosc,
                            int *changed)
@@ -550,8 +682,7 @@ sampleset_check_oscillator(y_synth_t *synth, y_sosc_t *sosc,
                 param1 != ss->param1 || param2 != ss->param2 ||
                 param3 != ss->param3 || param4 != ss->param4) {
 
-                if (*changed || !pthread_mutex_trylock(&global.sampleset_mutex)) {
-                    *changed = 1;
+                if (sampleset_check_lock(synth, changed)) {
                     /* YDB_MESSAGE(YDB_SAMPLE, " sampleset_check_oscillator: change on oscillator %p\n", sosc); */
                     sampleset_release(sosc->sampleset);
                     sosc->sampleset = sampleset_setup(sosc, mode, waveform,
@@ -559,8 +690,7 @@ sampleset_check_oscillator(y_synth_t *synth, y_sosc_t *sosc,
                 }
             }
         } else { /* set up new sampleset */
-            if (*changed || !pthread_mutex_trylock(&global.sampleset_mutex)) {
-                *changed = 1;
+            if (sampleset_check_lock(synth, changed)) {
                 /* YDB_MESSAGE(YDB_SAMPLE, " sampleset_check_oscillator: new for oscillator %p\n", sosc); */
                 sosc->sampleset = sampleset_setup(sosc, mode, waveform,
                                                   param1, param2, param3, param4);
@@ -568,8 +698,7 @@ sampleset_check_oscillator(y_synth_t *synth, y_sosc_t *sosc,
         }
     } else {
         if (sosc->sampleset) { /* free sampleset resource we are no longer using */
-            if (*changed || !pthread_mutex_trylock(&global.sampleset_mutex)) {
-                *changed = 1;
+            if (sampleset_check_lock(synth, changed)) {
                 /* YDB_MESSAGE(YDB_SAMPLE, " sampleset_check_oscillator: freeing for oscillator %p\n", sosc); */
                 sampleset_release(sosc->sampleset);
                 sosc->sampleset = NULL;
@@ -581,12 +710,16 @@ sampleset_check_oscillator(y_synth_t *synth, y_sosc_t *sosc,
 void
 sampleset_check_oscillators(y_synth_t *synth)
 {
-    int changed = 0;
-
-    sampleset_check_oscillator(synth, &synth->osc1, &changed);
-    sampleset_check_oscillator(synth, &synth->osc2, &changed);
-    sampleset_check_oscillator(synth, &synth->osc3, &changed);
-    sampleset_check_oscillator(synth, &synth->osc4, &changed);
+    int i, changed = 0;
+    y_part_t *part;
+
+    for (i = 0; i < synth->parts; i++) {
+        part = synth->part[i];
+        sampleset_check_oscillator(synth, &part->osc1, &changed);
+        sampleset_check_oscillator(synth, &part->osc2, &changed);
+        sampleset_check_oscillator(synth, &part->osc3, &changed);
+        sampleset_check_oscillator(synth, &part->osc4, &changed);
+    }
 
     if (changed) {
         signal_worker_thread();
@@ -66,7 +66,9 @@ struct _y_sampleset_t {
 };
 
 int  sampleset_init(void);
+int  sampleset_reserve(int oscillators);
 int  sampleset_instantiate(y_synth_t *synth);
+void sampleset_part_release(y_part_t *part);
 void sampleset_cleanup(y_synth_t *synth);
 void sampleset_fini(void);
 
@@ -75,6 +77,7 @@ y_sample_t *sampleset_find_sample(y_sampleset_t *ss, int index);
 
 void *sampleset_worker_function(void *arg);
 
+void sampleset_signal_worker(void);
 void sampleset_check_oscillators(y_synth_t *synth);
 y_sampleset_t *sampleset_setup(y_sosc_t *sosc, int mode, int waveform,
                                int param1, int param2, int param3, int param4);
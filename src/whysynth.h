@@ -69,8 +69,9 @@
 
 /* ==== end of debugging ==== */
 
-#define Y_MAX_POLYPHONY     64
+#define Y_MAX_POLYPHONY     256
 #define Y_DEFAULT_POLYPHONY 12
+#define Y_MAX_PARTS         16  /* one per MIDI channel */
 
 #endif /* _WHYSYNTH_H */
 
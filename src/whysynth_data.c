@@ -29,6 +29,18 @@
 #include "dssp_event.h"
 #include "common_data.h"
 
+/*
+ * y_data_free_patches
+ */
+void
+y_data_free_patches(y_synth_t *synth)
+{
+    if (synth->patches) {
+        free(synth->patches);
+        synth->patches = NULL;
+    }
+}
+
 /*
  * y_data_check_patches_allocation
  */
@@ -43,7 +55,7 @@ y_data_check_patches_allocation(y_synth_t *synth, int patch_index)
 
         if (synth->patches) {
             memcpy(p, synth->patches, synth->patches_allocated * sizeof(y_patch_t));
-            free(synth->patches);
+            y_data_free_patches(synth);
         }
         synth->patches = p;
 
@@ -70,37 +82,176 @@ y_data_friendly_patches(y_synth_t *synth)
     synth->patch_count = y_friendly_patch_count;
 }
 
+/*
+ * y_data_grow_bank
+ *
+ * Makes room for patch 'index' in a private bank under construction,
+ * returning false if out of memory.
+ */
+static int
+y_data_grow_bank(y_patch_t **bank, int *allocated, int index)
+{
+    if (index >= *allocated) {
+
+        int n = *allocated ? *allocated : 0x80;
+        y_patch_t *p;
+
+        while (n <= index)
+            n *= 2;
+        if (!(p = (y_patch_t *)realloc(*bank, n * sizeof(y_patch_t))))
+            return 0;
+        *bank = p;
+        *allocated = n;
+    }
+    return 1;
+}
+
+/*
+ * y_data_install_bank
+ *
+ * Replaces the synth's patches with a new bank, holding patches_mutex
+ * only long enough to swap pointers, then frees the old bank once the
+ * audio thread can no longer see it.
+ */
+static void
+y_data_install_bank(y_synth_t *synth, y_patch_t *bank, int allocated,
+                    int count)
+{
+    y_patch_t *old_patches;
+
+    pthread_mutex_lock(&synth->patches_mutex);
+
+    old_patches = synth->patches;
+    synth->patches           = bank;
+    synth->patches_allocated = allocated;
+    synth->patch_count       = count;
+
+    pthread_mutex_unlock(&synth->patches_mutex);
+
+    if (old_patches)
+        free(old_patches);
+}
+
+/*
+ * y_data_complete_bank
+ *
+ * Fills out a private bank of 'count' new patches with any of the current
+ * patches beyond them, and the rest of its allocation with the init
+ * voice, returning the new patch count.  The current patches may be read
+ * here without patches_mutex, since only configure() modifies them, and
+ * the host does not call it concurrently.
+ */
+static int
+y_data_complete_bank(y_synth_t *synth, y_patch_t *bank, int allocated,
+                     int count)
+{
+    int i;
+
+    if (count < synth->patch_count) {
+        memcpy(&bank[count], &synth->patches[count],
+               (synth->patch_count - count) * sizeof(y_patch_t));
+        count = synth->patch_count;
+    }
+    for (i = count; i < allocated; i++) {
+        memcpy(&bank[i], &y_init_voice, sizeof(y_patch_t));
+    }
+
+    return count;
+}
+
 /*
  * y_data_load
+ *
+ * Loads a patch bank, parsing (or reading) it without holding
+ * patches_mutex, so that the audio thread may continue to change
+ * programs while a large bank is loaded.  The records of a binary bank
+ * are read in as they are, without parsing.
  */
 char *
 y_data_load(y_synth_t *synth, char *filename)
 {
-    FILE *fh;
-    int count = 0;
+    char *text;
+    const char *p;
+    int count = 0, allocated = 0;
+    y_patch_t *bank = NULL;
 
-    if ((fh = fopen(filename, "rb")) == NULL)
-        return dssi_configure_message("load error: could not open file '%s'", filename);
+    switch (y_data_read_bank(filename, &bank, &count)) {
+      case 1:
+        allocated = count;
+        /* make room for any current patches beyond it */
+        if (!y_data_grow_bank(&bank, &allocated, synth->patch_count - 1)) {
+            free(bank);
+            return dssi_configure_message("load error: out of memory");
+        }
+        break;
 
-    pthread_mutex_lock(&synth->patches_mutex);
+      case -1:
+        return dssi_configure_message("load error: patch bank '%s' is damaged or incompatible", filename);
 
-    while (1) {
-        y_data_check_patches_allocation(synth, count);
-        if (!y_data_read_patch(fh, &synth->patches[count]))
-            break;
-        count++;
-    }
-    fclose(fh);
+      default:  /* not a binary bank, so parse it as text */
+        if ((text = y_data_read_file(filename)) == NULL)
+            return dssi_configure_message("load error: could not open file '%s'", filename);
 
-    if (!count) {
-        pthread_mutex_unlock(&synth->patches_mutex);
-        return dssi_configure_message("load error: no patches recognized in patch file '%s'", filename);
+        p = text;
+        while (1) {
+            if (!y_data_grow_bank(&bank, &allocated, count)) {
+                free(text);
+                free(bank);
+                return dssi_configure_message("load error: out of memory");
+            }
+            if (!y_data_parse_patch(&p, &bank[count]))
+                break;
+            count++;
+        }
+        free(text);
+
+        if (!count) {
+            free(bank);
+            return dssi_configure_message("load error: no patches recognized in patch file '%s'", filename);
+        }
+        if (!y_data_grow_bank(&bank, &allocated, synth->patch_count - 1)) {
+            free(bank);
+            return dssi_configure_message("load error: out of memory");
+        }
+        break;
     }
-    if (count > synth->patch_count)
-        synth->patch_count = count;
 
-    pthread_mutex_unlock(&synth->patches_mutex);
+    count = y_data_complete_bank(synth, bank, allocated, count);
+    y_data_install_bank(synth, bank, allocated, count);
 
     return NULL; /* success */
 }
 
+/*
+ * y_data_store_patch
+ *
+ * Stores a single patch, over an existing one or just past the last
+ * (which the caller must check), leaving the rest of the bank untouched.
+ */
+char *
+y_data_store_patch(y_synth_t *synth, int index, y_patch_t *patch)
+{
+    y_patch_t *bank = NULL;
+    int allocated = 0, count;
+
+    if (index >= synth->patches_allocated) {
+        /* grow into a new bank, installed just as a loaded one would be */
+        if (!y_data_grow_bank(&bank, &allocated, index))
+            return dssi_configure_message("error: out of memory");
+        memcpy(bank, synth->patches, synth->patch_count * sizeof(y_patch_t));
+        memcpy(&bank[index], patch, sizeof(y_patch_t));
+        count = y_data_complete_bank(synth, bank, allocated, index + 1);
+        y_data_install_bank(synth, bank, allocated, count);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&synth->patches_mutex);
+
+    memcpy(&synth->patches[index], patch, sizeof(y_patch_t));
+    if (index == synth->patch_count)
+        synth->patch_count++;
+
+    pthread_mutex_unlock(&synth->patches_mutex);
+
+    return NULL;
+}
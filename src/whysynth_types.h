@@ -26,6 +26,7 @@ typedef struct _y_sosc_t              y_sosc_t;
 typedef struct _y_svcf_t              y_svcf_t;
 typedef struct _y_slfo_t              y_slfo_t;
 typedef struct _y_seg_t               y_seg_t;
+typedef struct _y_part_t              y_part_t;
 typedef struct _y_synth_t             y_synth_t;
 typedef struct _y_voice_t             y_voice_t;
 typedef struct _grain_t               grain_t;
@@ -33,5 +34,7 @@ typedef struct _grain_envelope_data_t grain_envelope_data_t;
 typedef struct _y_sample_t            y_sample_t;
 typedef struct _y_sampleset_t         y_sampleset_t;
 typedef struct _y_patch_t             y_patch_t;
+typedef struct _y_convolver_t         y_convolver_t;
+typedef struct _y_arena_t             y_arena_t;
 
 #endif /* _WHYSYNTH_TYPES_H */
@@ -33,23 +33,89 @@
 #include "whysynth.h"
 #include "dssp_event.h"
 #include "whysynth_voice.h"
+#include "arena.h"
+#include "agran_oscillator.h"
 
 #include "wave_tables.h"
 #include "whysynth_voice_inline.h"
 
 /*
- * y_voice_new
+ * voice_block_grain_count
  */
-y_voice_t *
-y_voice_new(y_synth_t *synth)
+static int
+voice_block_grain_count(int first, int count)
+{
+    int grains = (first + count) * AG_GRAINS_PER_VOICE;
+
+    if (grains < AG_MIN_GRAIN_COUNT)
+        grains = AG_MIN_GRAIN_COUNT;
+    if (first) {
+        first *= AG_GRAINS_PER_VOICE;
+        grains -= (first < AG_MIN_GRAIN_COUNT ? AG_MIN_GRAIN_COUNT : first);
+    }
+    return grains;
+}
+
+/*
+ * y_voice_block_size
+ *
+ * Returns the arena space needed by y_voice_add_block() for count voices
+ * following the first already allocated.
+ */
+size_t
+y_voice_block_size(int first, int count)
+{
+    return count * arena_round(sizeof(y_voice_t)) +
+           arena_round(count * sizeof(struct y_voice_bus)) +
+           arena_round(voice_block_grain_count(first, count) * sizeof(grain_t));
+}
+
+/*
+ * y_voice_add_block
+ *
+ * Adds count voices to the end of synth->voice[], with their oscillator bus
+ * sets and grains, all allocated from arena.  The voices are laid out back to
+ * back, followed by the buses.  The caller must hold the voicelist mutex if
+ * the synth is running.
+ */
+int
+y_voice_add_block(y_synth_t *synth, y_arena_t *arena, int count)
 {
     y_voice_t *voice;
+    struct y_voice_bus *bus;
+    int i, grains, first = synth->voices_allocated;
+
+    if (first + count > Y_MAX_POLYPHONY)
+        return 0;
 
-    voice = (y_voice_t *)calloc(sizeof(y_voice_t), 1);
-    if (voice) {
+    for (i = first; i < first + count; i++) {
+        voice = (y_voice_t *)arena_alloc(arena, sizeof(y_voice_t));
+        if (!voice)
+            return 0;
         voice->status = Y_VOICE_OFF;
+        voice->part = synth->part[0];
+        voice->index = i;
+        synth->voice[i] = voice;
     }
-    return voice;
+    bus = (struct y_voice_bus *)arena_alloc(arena, count * sizeof(struct y_voice_bus));
+    if (!bus)
+        return 0;
+    grains = voice_block_grain_count(first, count);
+    if (grains && !new_grain_array(synth, arena, grains))
+        return 0;
+
+    /* bus sets are stacked so the first is taken first */
+    memmove(&synth->free_voice_bus[count], synth->free_voice_bus,
+            synth->free_voice_bus_count * sizeof(struct y_voice_bus *));
+    for (i = 0; i < count; i++)
+        synth->free_voice_bus[i] = &bus[count - 1 - i];
+    synth->free_voice_bus_count += count;
+
+    for (i = first; i < first + count; i++)
+        synth->voice_free_map[i >> 5] |= 1u << (i & 31);
+    synth->voices_allocated = first + count;
+
+    return 1;
 }
 
 float eg_shape_coeffs[][4] = {
@@ -211,11 +277,13 @@ y_eg_restart(y_synth_t *synth, y_seg_t *seg, y_voice_t *voice, struct veg *veg,
 static void
 y_voice_restart_egs(y_synth_t *synth, y_voice_t *voice)
 {
-    y_eg_restart(synth, &synth->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
-    y_eg_restart(synth, &synth->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
-    y_eg_restart(synth, &synth->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
-    y_eg_restart(synth, &synth->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
-    y_eg_restart(synth, &synth->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
+    y_part_t *part = voice->part;
+
+    y_eg_restart(synth, &part->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
+    y_eg_restart(synth, &part->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
+    y_eg_restart(synth, &part->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
+    y_eg_restart(synth, &part->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
+    y_eg_restart(synth, &part->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
 }
 
 /*
@@ -291,11 +359,13 @@ y_eg_release(y_synth_t *synth, y_seg_t *seg, y_voice_t *voice, struct veg *veg,
 static inline void
 y_voice_release_egs(y_synth_t *synth, y_voice_t *voice)
 {
-    y_eg_release(synth, &synth->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
-    y_eg_release(synth, &synth->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
-    y_eg_release(synth, &synth->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
-    y_eg_release(synth, &synth->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
-    y_eg_release(synth, &synth->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
+    y_part_t *part = voice->part;
+
+    y_eg_release(synth, &part->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
+    y_eg_release(synth, &part->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
+    y_eg_release(synth, &part->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
+    y_eg_release(synth, &part->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
+    y_eg_release(synth, &part->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
 }
 
 /*
@@ -305,9 +375,10 @@ void
 y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
                      unsigned char key, unsigned char velocity)
 {
+    y_part_t *part = voice->part;
     int i;
 
-    voice->key      = key;
+    y_voice_set_key(synth, voice, key);
     voice->velocity = velocity;
 
     if (!synth->monophonic || !(_ON(voice) || _SUSTAINED(voice))) {
@@ -319,26 +390,26 @@ y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
         voice->target_pitch = y_pitch[key];
         switch(synth->glide) {
           case Y_GLIDE_MODE_LEGATO:
-            if (synth->held_keys[0] >= 0) {
-                voice->prev_pitch = y_pitch[synth->held_keys[0]];
+            if (part->held_keys[0] >= 0) {
+                voice->prev_pitch = y_pitch[part->held_keys[0]];
             } else {
                 voice->prev_pitch = voice->target_pitch;
             }
             break;
 
           case Y_GLIDE_MODE_INITIAL:
-            if (synth->held_keys[0] >= 0) {
+            if (part->held_keys[0] >= 0) {
                 voice->prev_pitch = voice->target_pitch;
             } else {
-                voice->prev_pitch = synth->last_noteon_pitch;
+                voice->prev_pitch = part->last_noteon_pitch;
             }
             break;
 
           case Y_GLIDE_MODE_ALWAYS:
-            if (synth->held_keys[0] >= 0) {
-                voice->prev_pitch = y_pitch[synth->held_keys[0]];
+            if (part->held_keys[0] >= 0) {
+                voice->prev_pitch = y_pitch[part->held_keys[0]];
             } else {
-                voice->prev_pitch = synth->last_noteon_pitch;
+                voice->prev_pitch = part->last_noteon_pitch;
             }
             break;
 
@@ -376,29 +447,31 @@ y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
             voice->mod[Y_MOD_VELOCITY].next_value = voice->mod[Y_MOD_VELOCITY].value;
             voice->mod[Y_MOD_VELOCITY].delta = 0.0f;
             /* Y_MOD_GLFO set in y_voice_render() */
-            y_voice_setup_lfo(synth, &synth->vlfo, &voice->vlfo, 0.0f, 0.0f,
+            y_voice_setup_lfo(synth, &part->vlfo, &voice->vlfo, 0.0f, 0.0f,
                               voice->mod, &voice->mod[Y_MOD_VLFO]);
-            y_voice_setup_lfo(synth, &synth->mlfo, &voice->mlfo0,
-                              0.0f, *(synth->mlfo_random_freq),
+            y_voice_setup_lfo(synth, &part->mlfo, &voice->mlfo0,
+                              0.0f, *(part->mlfo_random_freq),
                               voice->mod, &voice->mod[Y_MOD_MLFO0]);
-            y_voice_setup_lfo(synth, &synth->mlfo, &voice->mlfo1,
-                              *(synth->mlfo_phase_spread) / 360.0f,
-                              *(synth->mlfo_random_freq),
+            y_voice_setup_lfo(synth, &part->mlfo, &voice->mlfo1,
+                              *(part->mlfo_phase_spread) / 360.0f,
+                              *(part->mlfo_random_freq),
                               voice->mod, &voice->mod[Y_MOD_MLFO1]);
-            y_voice_setup_lfo(synth, &synth->mlfo, &voice->mlfo2,
-                              2.0f * *(synth->mlfo_phase_spread) / 360.0f,
-                              *(synth->mlfo_random_freq),
+            y_voice_setup_lfo(synth, &part->mlfo, &voice->mlfo2,
+                              2.0f * *(part->mlfo_phase_spread) / 360.0f,
+                              *(part->mlfo_random_freq),
                               voice->mod, &voice->mod[Y_MOD_MLFO2]);
-            y_voice_setup_lfo(synth, &synth->mlfo, &voice->mlfo3,
-                              3.0f * *(synth->mlfo_phase_spread) / 360.0f,
-                              *(synth->mlfo_random_freq),
+            y_voice_setup_lfo(synth, &part->mlfo, &voice->mlfo3,
+                              3.0f * *(part->mlfo_phase_spread) / 360.0f,
+                              *(part->mlfo_random_freq),
                               voice->mod, &voice->mod[Y_MOD_MLFO3]);
-            y_eg_start(synth, &synth->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
-            y_eg_start(synth, &synth->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
-            y_eg_start(synth, &synth->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
-            y_eg_start(synth, &synth->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
-            y_eg_start(synth, &synth->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
+            y_eg_start(synth, &part->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
+            y_eg_start(synth, &part->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
+            y_eg_start(synth, &part->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
+            y_eg_start(synth, &part->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
+            y_eg_start(synth, &part->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
             /* Y_MOD_MIX set in y_voice_render() */
+            voice->cc_volume = part->cc_volume;
+            voice->cc_pan    = part->cc_pan;
             voice->osc_index = Y_CONTROL_PERIOD - synth->control_remains;
 
         } else { /* monophonic voice in release phase, retrigger EGs */
@@ -411,7 +484,7 @@ y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
     } else {
 
         /* synth is monophonic, and we're modifying a playing voice */
-        // YDB_MESSAGE(YDB_NOTE, " y_voice_note_on in monophonic section: old key %d => new key %d\n", synth->held_keys[0], key);
+        // YDB_MESSAGE(YDB_NOTE, " y_voice_note_on in monophonic section: old key %d => new key %d\n", part->held_keys[0], key);
 
         /* set new pitch */
         voice->target_pitch = y_pitch[key];
@@ -422,7 +495,7 @@ y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
         /* if in 'on' or 'both' modes, and key has changed, then re-trigger EGs */
         if ((synth->monophonic == Y_MONO_MODE_ON ||
              synth->monophonic == Y_MONO_MODE_BOTH) &&
-            (synth->held_keys[0] < 0 || synth->held_keys[0] != key)) {
+            (part->held_keys[0] < 0 || part->held_keys[0] != key)) {
 
             y_voice_restart_egs(synth, voice);
         }
@@ -430,7 +503,7 @@ y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
         /* all other variables stay what they are */
 
     }
-    synth->last_noteon_pitch = voice->target_pitch;
+    part->last_noteon_pitch = voice->target_pitch;
 
     /* add new key to the list of held keys */
 
@@ -438,17 +511,17 @@ y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
      * top of the list, otherwise shift the other keys down and add it
      * to the top of the list. */
     for (i = 0; i < 7; i++) {
-        if (synth->held_keys[i] == key)
+        if (part->held_keys[i] == key)
             break;
     }
     for (; i > 0; i--) {
-        synth->held_keys[i] = synth->held_keys[i - 1];
+        part->held_keys[i] = part->held_keys[i - 1];
     }
-    synth->held_keys[0] = key;
+    part->held_keys[0] = key;
 
     if (!_PLAYING(voice)) {
 
-        y_voice_start_voice(voice);
+        y_voice_start_voice(synth, voice);
 
     } else if (!_ON(voice)) {  /* must be Y_VOICE_SUSTAINED or Y_VOICE_RELEASED */
 
@@ -464,6 +537,8 @@ void
 y_voice_note_off(y_synth_t *synth, y_voice_t *voice,
                       unsigned char key, unsigned char rvelocity)
 {
+    y_part_t *part = voice->part;
+
     // YDB_MESSAGE(YDB_NOTE, " y_voice_note_off: called for voice %p, key %d\n", voice, key);
 
     /* save release velocity */
@@ -471,14 +546,14 @@ y_voice_note_off(y_synth_t *synth, y_voice_t *voice,
 
     if (synth->monophonic) {  /* monophonic mode */
 
-        if (synth->held_keys[0] >= 0) {
+        if (part->held_keys[0] >= 0) {
 
             /* still some keys held */
 
-            if (voice->key != synth->held_keys[0]) {
+            if (voice->key != part->held_keys[0]) {
 
                 /* most-recently-played key has changed */
-                voice->key = synth->held_keys[0];
+                y_voice_set_key(synth, voice, part->held_keys[0]);
                 // YDB_MESSAGE(YDB_NOTE, " note-off in monophonic section: changing pitch to %d\n", voice->key);
                 voice->target_pitch = y_pitch[voice->key];
                 if (synth->glide == Y_GLIDE_MODE_INITIAL ||
@@ -494,7 +569,7 @@ y_voice_note_off(y_synth_t *synth, y_voice_t *voice,
 
         } else {  /* no keys still held */
 
-            if (Y_SYNTH_SUSTAINED(synth)) {
+            if (Y_PART_SUSTAINED(part)) {
 
                 /* no more keys in list, but we're sustained */
                 // YDB_MESSAGE(YDB_NOTE, " note-off in monophonic section: sustained with no held keys\n");
@@ -513,7 +588,7 @@ y_voice_note_off(y_synth_t *synth, y_voice_t *voice,
 
     } else {  /* polyphonic mode */
 
-        if (Y_SYNTH_SUSTAINED(synth)) {
+        if (Y_PART_SUSTAINED(part)) {
 
             if (!_RELEASED(voice))
                 voice->status = Y_VOICE_SUSTAINED;
@@ -544,224 +619,229 @@ y_voice_release_note(y_synth_t *synth, y_voice_t *voice)
 
 /*
  * y_voice_set_ports
+ *
+ * Sets a part's patch parameters from a patch.  Since the effect is shared
+ * by all parts, only part 0's patch sets the effect ports.
  */
 void
-y_voice_set_ports(y_synth_t *synth, y_patch_t *patch)
+y_voice_set_ports(y_synth_t *synth, y_part_t *part, y_patch_t *patch)
 {
     /* -PORTS- */
-    *(synth->osc1.mode)          = (float)patch->osc1.mode;
-    *(synth->osc1.waveform)      = (float)patch->osc1.waveform;
-    *(synth->osc1.pitch)         = (float)patch->osc1.pitch;
-    *(synth->osc1.detune)        = patch->osc1.detune;
-    *(synth->osc1.pitch_mod_src) = (float)patch->osc1.pitch_mod_src;
-    *(synth->osc1.pitch_mod_amt) = patch->osc1.pitch_mod_amt;
-    *(synth->osc1.mparam1)       = patch->osc1.mparam1;
-    *(synth->osc1.mparam2)       = patch->osc1.mparam2;
-    *(synth->osc1.mmod_src)      = (float)patch->osc1.mmod_src;
-    *(synth->osc1.mmod_amt)      = patch->osc1.mmod_amt;
-    *(synth->osc1.amp_mod_src)   = (float)patch->osc1.amp_mod_src;
-    *(synth->osc1.amp_mod_amt)   = patch->osc1.amp_mod_amt;
-    *(synth->osc1.level_a)       = patch->osc1.level_a;
-    *(synth->osc1.level_b)       = patch->osc1.level_b;
-
-    *(synth->osc2.mode)          = (float)patch->osc2.mode;
-    *(synth->osc2.waveform)      = (float)patch->osc2.waveform;
-    *(synth->osc2.pitch)         = (float)patch->osc2.pitch;
-    *(synth->osc2.detune)        = patch->osc2.detune;
-    *(synth->osc2.pitch_mod_src) = (float)patch->osc2.pitch_mod_src;
-    *(synth->osc2.pitch_mod_amt) = patch->osc2.pitch_mod_amt;
-    *(synth->osc2.mparam1)       = patch->osc2.mparam1;
-    *(synth->osc2.mparam2)       = patch->osc2.mparam2;
-    *(synth->osc2.mmod_src)      = (float)patch->osc2.mmod_src;
-    *(synth->osc2.mmod_amt)      = patch->osc2.mmod_amt;
-    *(synth->osc2.amp_mod_src)   = (float)patch->osc2.amp_mod_src;
-    *(synth->osc2.amp_mod_amt)   = patch->osc2.amp_mod_amt;
-    *(synth->osc2.level_a)       = patch->osc2.level_a;
-    *(synth->osc2.level_b)       = patch->osc2.level_b;
-
-    *(synth->osc3.mode)          = (float)patch->osc3.mode;
-    *(synth->osc3.waveform)      = (float)patch->osc3.waveform;
-    *(synth->osc3.pitch)         = (float)patch->osc3.pitch;
-    *(synth->osc3.detune)        = patch->osc3.detune;
-    *(synth->osc3.pitch_mod_src) = (float)patch->osc3.pitch_mod_src;
-    *(synth->osc3.pitch_mod_amt) = patch->osc3.pitch_mod_amt;
-    *(synth->osc3.mparam1)       = patch->osc3.mparam1;
-    *(synth->osc3.mparam2)       = patch->osc3.mparam2;
-    *(synth->osc3.mmod_src)      = (float)patch->osc3.mmod_src;
-    *(synth->osc3.mmod_amt)      = patch->osc3.mmod_amt;
-    *(synth->osc3.amp_mod_src)   = (float)patch->osc3.amp_mod_src;
-    *(synth->osc3.amp_mod_amt)   = patch->osc3.amp_mod_amt;
-    *(synth->osc3.level_a)       = patch->osc3.level_a;
-    *(synth->osc3.level_b)       = patch->osc3.level_b;
-
-    *(synth->osc4.mode)          = (float)patch->osc4.mode;
-    *(synth->osc4.waveform)      = (float)patch->osc4.waveform;
-    *(synth->osc4.pitch)         = (float)patch->osc4.pitch;
-    *(synth->osc4.detune)        = patch->osc4.detune;
-    *(synth->osc4.pitch_mod_src) = (float)patch->osc4.pitch_mod_src;
-    *(synth->osc4.pitch_mod_amt) = patch->osc4.pitch_mod_amt;
-    *(synth->osc4.mparam1)       = patch->osc4.mparam1;
-    *(synth->osc4.mparam2)       = patch->osc4.mparam2;
-    *(synth->osc4.mmod_src)      = (float)patch->osc4.mmod_src;
-    *(synth->osc4.mmod_amt)      = patch->osc4.mmod_amt;
-    *(synth->osc4.amp_mod_src)   = (float)patch->osc4.amp_mod_src;
-    *(synth->osc4.amp_mod_amt)   = patch->osc4.amp_mod_amt;
-    *(synth->osc4.level_a)       = patch->osc4.level_a;
-    *(synth->osc4.level_b)       = patch->osc4.level_b;
-
-    *(synth->vcf1.mode)         = (float)patch->vcf1.mode;
-    *(synth->vcf1.source)       = (float)patch->vcf1.source;
-    *(synth->vcf1.frequency)    = patch->vcf1.frequency;
-    *(synth->vcf1.freq_mod_src) = (float)patch->vcf1.freq_mod_src;
-    *(synth->vcf1.freq_mod_amt) = patch->vcf1.freq_mod_amt;
-    *(synth->vcf1.qres)         = patch->vcf1.qres;
-    *(synth->vcf1.mparam)       = patch->vcf1.mparam;
-
-    *(synth->vcf2.mode)         = (float)patch->vcf2.mode;
-    *(synth->vcf2.source)       = (float)patch->vcf2.source;
-    *(synth->vcf2.frequency)    = patch->vcf2.frequency;
-    *(synth->vcf2.freq_mod_src) = (float)patch->vcf2.freq_mod_src;
-    *(synth->vcf2.freq_mod_amt) = patch->vcf2.freq_mod_amt;
-    *(synth->vcf2.qres)         = patch->vcf2.qres;
-    *(synth->vcf2.mparam)       = patch->vcf2.mparam;
-
-    *(synth->busa_level)        = patch->busa_level;
-    *(synth->busa_pan)          = patch->busa_pan;
-    *(synth->busb_level)        = patch->busb_level;
-    *(synth->busb_pan)          = patch->busb_pan;
-    *(synth->vcf1_level)        = patch->vcf1_level;
-    *(synth->vcf1_pan)          = patch->vcf1_pan;
-    *(synth->vcf2_level)        = patch->vcf2_level;
-    *(synth->vcf2_pan)          = patch->vcf2_pan;
-    *(synth->volume)            = patch->volume;
-
-    *(synth->effect_mode)       = (float)patch->effect_mode;
-    *(synth->effect_param1)     = patch->effect_param1;
-    *(synth->effect_param2)     = patch->effect_param2;
-    *(synth->effect_param3)     = patch->effect_param3;
-    *(synth->effect_param4)     = patch->effect_param4;
-    *(synth->effect_param5)     = patch->effect_param5;
-    *(synth->effect_param6)     = patch->effect_param6;
-    *(synth->effect_mix)        = patch->effect_mix;
+    *(part->osc1.mode)          = (float)patch->osc1.mode;
+    *(part->osc1.waveform)      = (float)patch->osc1.waveform;
+    *(part->osc1.pitch)         = (float)patch->osc1.pitch;
+    *(part->osc1.detune)        = patch->osc1.detune;
+    *(part->osc1.pitch_mod_src) = (float)patch->osc1.pitch_mod_src;
+    *(part->osc1.pitch_mod_amt) = patch->osc1.pitch_mod_amt;
+    *(part->osc1.mparam1)       = patch->osc1.mparam1;
+    *(part->osc1.mparam2)       = patch->osc1.mparam2;
+    *(part->osc1.mmod_src)      = (float)patch->osc1.mmod_src;
+    *(part->osc1.mmod_amt)      = patch->osc1.mmod_amt;
+    *(part->osc1.amp_mod_src)   = (float)patch->osc1.amp_mod_src;
+    *(part->osc1.amp_mod_amt)   = patch->osc1.amp_mod_amt;
+    *(part->osc1.level_a)       = patch->osc1.level_a;
+    *(part->osc1.level_b)       = patch->osc1.level_b;
+
+    *(part->osc2.mode)          = (float)patch->osc2.mode;
+    *(part->osc2.waveform)      = (float)patch->osc2.waveform;
+    *(part->osc2.pitch)         = (float)patch->osc2.pitch;
+    *(part->osc2.detune)        = patch->osc2.detune;
+    *(part->osc2.pitch_mod_src) = (float)patch->osc2.pitch_mod_src;
+    *(part->osc2.pitch_mod_amt) = patch->osc2.pitch_mod_amt;
+    *(part->osc2.mparam1)       = patch->osc2.mparam1;
+    *(part->osc2.mparam2)       = patch->osc2.mparam2;
+    *(part->osc2.mmod_src)      = (float)patch->osc2.mmod_src;
+    *(part->osc2.mmod_amt)      = patch->osc2.mmod_amt;
+    *(part->osc2.amp_mod_src)   = (float)patch->osc2.amp_mod_src;
+    *(part->osc2.amp_mod_amt)   = patch->osc2.amp_mod_amt;
+    *(part->osc2.level_a)       = patch->osc2.level_a;
+    *(part->osc2.level_b)       = patch->osc2.level_b;
+
+    *(part->osc3.mode)          = (float)patch->osc3.mode;
+    *(part->osc3.waveform)      = (float)patch->osc3.waveform;
+    *(part->osc3.pitch)         = (float)patch->osc3.pitch;
+    *(part->osc3.detune)        = patch->osc3.detune;
+    *(part->osc3.pitch_mod_src) = (float)patch->osc3.pitch_mod_src;
+    *(part->osc3.pitch_mod_amt) = patch->osc3.pitch_mod_amt;
+    *(part->osc3.mparam1)       = patch->osc3.mparam1;
+    *(part->osc3.mparam2)       = patch->osc3.mparam2;
+    *(part->osc3.mmod_src)      = (float)patch->osc3.mmod_src;
+    *(part->osc3.mmod_amt)      = patch->osc3.mmod_amt;
+    *(part->osc3.amp_mod_src)   = (float)patch->osc3.amp_mod_src;
+    *(part->osc3.amp_mod_amt)   = patch->osc3.amp_mod_amt;
+    *(part->osc3.level_a)       = patch->osc3.level_a;
+    *(part->osc3.level_b)       = patch->osc3.level_b;
+
+    *(part->osc4.mode)          = (float)patch->osc4.mode;
+    *(part->osc4.waveform)      = (float)patch->osc4.waveform;
+    *(part->osc4.pitch)         = (float)patch->osc4.pitch;
+    *(part->osc4.detune)        = patch->osc4.detune;
+    *(part->osc4.pitch_mod_src) = (float)patch->osc4.pitch_mod_src;
+    *(part->osc4.pitch_mod_amt) = patch->osc4.pitch_mod_amt;
+    *(part->osc4.mparam1)       = patch->osc4.mparam1;
+    *(part->osc4.mparam2)       = patch->osc4.mparam2;
+    *(part->osc4.mmod_src)      = (float)patch->osc4.mmod_src;
+    *(part->osc4.mmod_amt)      = patch->osc4.mmod_amt;
+    *(part->osc4.amp_mod_src)   = (float)patch->osc4.amp_mod_src;
+    *(part->osc4.amp_mod_amt)   = patch->osc4.amp_mod_amt;
+    *(part->osc4.level_a)       = patch->osc4.level_a;
+    *(part->osc4.level_b)       = patch->osc4.level_b;
+
+    *(part->vcf1.mode)         = (float)patch->vcf1.mode;
+    *(part->vcf1.source)       = (float)patch->vcf1.source;
+    *(part->vcf1.frequency)    = patch->vcf1.frequency;
+    *(part->vcf1.freq_mod_src) = (float)patch->vcf1.freq_mod_src;
+    *(part->vcf1.freq_mod_amt) = patch->vcf1.freq_mod_amt;
+    *(part->vcf1.qres)         = patch->vcf1.qres;
+    *(part->vcf1.mparam)       = patch->vcf1.mparam;
+
+    *(part->vcf2.mode)         = (float)patch->vcf2.mode;
+    *(part->vcf2.source)       = (float)patch->vcf2.source;
+    *(part->vcf2.frequency)    = patch->vcf2.frequency;
+    *(part->vcf2.freq_mod_src) = (float)patch->vcf2.freq_mod_src;
+    *(part->vcf2.freq_mod_amt) = patch->vcf2.freq_mod_amt;
+    *(part->vcf2.qres)         = patch->vcf2.qres;
+    *(part->vcf2.mparam)       = patch->vcf2.mparam;
+
+    *(part->busa_level)        = patch->busa_level;
+    *(part->busa_pan)          = patch->busa_pan;
+    *(part->busb_level)        = patch->busb_level;
+    *(part->busb_pan)          = patch->busb_pan;
+    *(part->vcf1_level)        = patch->vcf1_level;
+    *(part->vcf1_pan)          = patch->vcf1_pan;
+    *(part->vcf2_level)        = patch->vcf2_level;
+    *(part->vcf2_pan)          = patch->vcf2_pan;
+    *(part->volume)            = patch->volume;
+
+    if (part == synth->part[0]) {
+        *(synth->effect_mode)   = (float)patch->effect_mode;
+        *(synth->effect_param1) = patch->effect_param1;
+        *(synth->effect_param2) = patch->effect_param2;
+        *(synth->effect_param3) = patch->effect_param3;
+        *(synth->effect_param4) = patch->effect_param4;
+        *(synth->effect_param5) = patch->effect_param5;
+        *(synth->effect_param6) = patch->effect_param6;
+        *(synth->effect_mix)    = patch->effect_mix;
+    }
                                                            
-    *(synth->glide_time)        = patch->glide_time;
-    *(synth->bend_range)        = (float)patch->bend_range;
+    *(part->glide_time)        = patch->glide_time;
+    *(part->bend_range)        = (float)patch->bend_range;
                                                            
-    *(synth->glfo.frequency)    = patch->glfo.frequency;
-    *(synth->glfo.waveform)     = (float)patch->glfo.waveform;
-    /* synth->glfo.delay always points to a 0.0f */
-    *(synth->glfo.amp_mod_src)  = (float)patch->glfo.amp_mod_src;
-    *(synth->glfo.amp_mod_amt)  = patch->glfo.amp_mod_amt;
+    *(part->glfo.frequency)    = patch->glfo.frequency;
+    *(part->glfo.waveform)     = (float)patch->glfo.waveform;
+    /* part->glfo.delay always points to a 0.0f */
+    *(part->glfo.amp_mod_src)  = (float)patch->glfo.amp_mod_src;
+    *(part->glfo.amp_mod_amt)  = patch->glfo.amp_mod_amt;
                                                            
-    *(synth->vlfo.frequency)    = patch->vlfo.frequency;
-    *(synth->vlfo.waveform)     = (float)patch->vlfo.waveform;
-    *(synth->vlfo.delay)        = patch->vlfo.delay;
-    *(synth->vlfo.amp_mod_src)  = (float)patch->vlfo.amp_mod_src;
-    *(synth->vlfo.amp_mod_amt)  = patch->vlfo.amp_mod_amt;
+    *(part->vlfo.frequency)    = patch->vlfo.frequency;
+    *(part->vlfo.waveform)     = (float)patch->vlfo.waveform;
+    *(part->vlfo.delay)        = patch->vlfo.delay;
+    *(part->vlfo.amp_mod_src)  = (float)patch->vlfo.amp_mod_src;
+    *(part->vlfo.amp_mod_amt)  = patch->vlfo.amp_mod_amt;
                                                            
-    *(synth->mlfo.frequency)    = patch->mlfo.frequency;
-    *(synth->mlfo.waveform)     = (float)patch->mlfo.waveform;
-    *(synth->mlfo.delay)        = patch->mlfo.delay;
-    *(synth->mlfo.amp_mod_src)  = (float)patch->mlfo.amp_mod_src;
-    *(synth->mlfo.amp_mod_amt)  = patch->mlfo.amp_mod_amt;
-    *(synth->mlfo_phase_spread) = patch->mlfo_phase_spread;
-    *(synth->mlfo_random_freq)  = patch->mlfo_random_freq;
-
-    *(synth->ego.mode)           = (float)patch->ego.mode;
-    *(synth->ego.shape[0])       = (float)patch->ego.shape1;
-    *(synth->ego.time[0])        = patch->ego.time1;
-    *(synth->ego.level[0])       = patch->ego.level1;
-    *(synth->ego.shape[1])       = (float)patch->ego.shape2;
-    *(synth->ego.time[1])        = patch->ego.time2;
-    *(synth->ego.level[1])       = patch->ego.level2;
-    *(synth->ego.shape[2])       = (float)patch->ego.shape3;
-    *(synth->ego.time[2])        = patch->ego.time3;
-    *(synth->ego.level[2])       = patch->ego.level3;
-    *(synth->ego.shape[3])       = (float)patch->ego.shape4;
-    *(synth->ego.time[3])        = patch->ego.time4;
-    *(synth->ego.vel_level_sens) = patch->ego.vel_level_sens;
-    *(synth->ego.vel_time_scale) = patch->ego.vel_time_scale;
-    *(synth->ego.kbd_time_scale) = patch->ego.kbd_time_scale;
-    *(synth->ego.amp_mod_src)    = (float)patch->ego.amp_mod_src;
-    *(synth->ego.amp_mod_amt)    = patch->ego.amp_mod_amt;
-
-    *(synth->eg1.mode)           = (float)patch->eg1.mode;
-    *(synth->eg1.shape[0])       = (float)patch->eg1.shape1;
-    *(synth->eg1.time[0])        = patch->eg1.time1;
-    *(synth->eg1.level[0])       = patch->eg1.level1;
-    *(synth->eg1.shape[1])       = (float)patch->eg1.shape2;
-    *(synth->eg1.time[1])        = patch->eg1.time2;
-    *(synth->eg1.level[1])       = patch->eg1.level2;
-    *(synth->eg1.shape[2])       = (float)patch->eg1.shape3;
-    *(synth->eg1.time[2])        = patch->eg1.time3;
-    *(synth->eg1.level[2])       = patch->eg1.level3;
-    *(synth->eg1.shape[3])       = (float)patch->eg1.shape4;
-    *(synth->eg1.time[3])        = patch->eg1.time4;
-    *(synth->eg1.vel_level_sens) = patch->eg1.vel_level_sens;
-    *(synth->eg1.vel_time_scale) = patch->eg1.vel_time_scale;
-    *(synth->eg1.kbd_time_scale) = patch->eg1.kbd_time_scale;
-    *(synth->eg1.amp_mod_src)    = (float)patch->eg1.amp_mod_src;
-    *(synth->eg1.amp_mod_amt)    = patch->eg1.amp_mod_amt;
-
-    *(synth->eg2.mode)           = (float)patch->eg2.mode;
-    *(synth->eg2.shape[0])       = (float)patch->eg2.shape1;
-    *(synth->eg2.time[0])        = patch->eg2.time1;
-    *(synth->eg2.level[0])       = patch->eg2.level1;
-    *(synth->eg2.shape[1])       = (float)patch->eg2.shape2;
-    *(synth->eg2.time[1])        = patch->eg2.time2;
-    *(synth->eg2.level[1])       = patch->eg2.level2;
-    *(synth->eg2.shape[2])       = (float)patch->eg2.shape3;
-    *(synth->eg2.time[2])        = patch->eg2.time3;
-    *(synth->eg2.level[2])       = patch->eg2.level3;
-    *(synth->eg2.shape[3])       = (float)patch->eg2.shape4;
-    *(synth->eg2.time[3])        = patch->eg2.time4;
-    *(synth->eg2.vel_level_sens) = patch->eg2.vel_level_sens;
-    *(synth->eg2.vel_time_scale) = patch->eg2.vel_time_scale;
-    *(synth->eg2.kbd_time_scale) = patch->eg2.kbd_time_scale;
-    *(synth->eg2.amp_mod_src)    = (float)patch->eg2.amp_mod_src;
-    *(synth->eg2.amp_mod_amt)    = patch->eg2.amp_mod_amt;
-
-    *(synth->eg3.mode)           = (float)patch->eg3.mode;
-    *(synth->eg3.shape[0])       = (float)patch->eg3.shape1;
-    *(synth->eg3.time[0])        = patch->eg3.time1;
-    *(synth->eg3.level[0])       = patch->eg3.level1;
-    *(synth->eg3.shape[1])       = (float)patch->eg3.shape2;
-    *(synth->eg3.time[1])        = patch->eg3.time2;
-    *(synth->eg3.level[1])       = patch->eg3.level2;
-    *(synth->eg3.shape[2])       = (float)patch->eg3.shape3;
-    *(synth->eg3.time[2])        = patch->eg3.time3;
-    *(synth->eg3.level[2])       = patch->eg3.level3;
-    *(synth->eg3.shape[3])       = (float)patch->eg3.shape4;
-    *(synth->eg3.time[3])        = patch->eg3.time4;
-    *(synth->eg3.vel_level_sens) = patch->eg3.vel_level_sens;
-    *(synth->eg3.vel_time_scale) = patch->eg3.vel_time_scale;
-    *(synth->eg3.kbd_time_scale) = patch->eg3.kbd_time_scale;
-    *(synth->eg3.amp_mod_src)    = (float)patch->eg3.amp_mod_src;
-    *(synth->eg3.amp_mod_amt)    = patch->eg3.amp_mod_amt;
-
-    *(synth->eg4.mode)           = (float)patch->eg4.mode;
-    *(synth->eg4.shape[0])       = (float)patch->eg4.shape1;
-    *(synth->eg4.time[0])        = patch->eg4.time1;
-    *(synth->eg4.level[0])       = patch->eg4.level1;
-    *(synth->eg4.shape[1])       = (float)patch->eg4.shape2;
-    *(synth->eg4.time[1])        = patch->eg4.time2;
-    *(synth->eg4.level[1])       = patch->eg4.level2;
-    *(synth->eg4.shape[2])       = (float)patch->eg4.shape3;
-    *(synth->eg4.time[2])        = patch->eg4.time3;
-    *(synth->eg4.level[2])       = patch->eg4.level3;
-    *(synth->eg4.shape[3])       = (float)patch->eg4.shape4;
-    *(synth->eg4.time[3])        = patch->eg4.time4;
-    *(synth->eg4.vel_level_sens) = patch->eg4.vel_level_sens;
-    *(synth->eg4.vel_time_scale) = patch->eg4.vel_time_scale;
-    *(synth->eg4.kbd_time_scale) = patch->eg4.kbd_time_scale;
-    *(synth->eg4.amp_mod_src)    = (float)patch->eg4.amp_mod_src;
-    *(synth->eg4.amp_mod_amt)    = patch->eg4.amp_mod_amt;
-
-    *(synth->modmix_bias)        = patch->modmix_bias;
-    *(synth->modmix_mod1_src)    = (float)patch->modmix_mod1_src;
-    *(synth->modmix_mod1_amt)    = patch->modmix_mod1_amt;
-    *(synth->modmix_mod2_src)    = (float)patch->modmix_mod2_src;
-    *(synth->modmix_mod2_amt)    = patch->modmix_mod2_amt;
+    *(part->mlfo.frequency)    = patch->mlfo.frequency;
+    *(part->mlfo.waveform)     = (float)patch->mlfo.waveform;
+    *(part->mlfo.delay)        = patch->mlfo.delay;
+    *(part->mlfo.amp_mod_src)  = (float)patch->mlfo.amp_mod_src;
+    *(part->mlfo.amp_mod_amt)  = patch->mlfo.amp_mod_amt;
+    *(part->mlfo_phase_spread) = patch->mlfo_phase_spread;
+    *(part->mlfo_random_freq)  = patch->mlfo_random_freq;
+
+    *(part->ego.mode)           = (float)patch->ego.mode;
+    *(part->ego.shape[0])       = (float)patch->ego.shape1;
+    *(part->ego.time[0])        = patch->ego.time1;
+    *(part->ego.level[0])       = patch->ego.level1;
+    *(part->ego.shape[1])       = (float)patch->ego.shape2;
+    *(part->ego.time[1])        = patch->ego.time2;
+    *(part->ego.level[1])       = patch->ego.level2;
+    *(part->ego.shape[2])       = (float)patch->ego.shape3;
+    *(part->ego.time[2])        = patch->ego.time3;
+    *(part->ego.level[2])       = patch->ego.level3;
+    *(part->ego.shape[3])       = (float)patch->ego.shape4;
+    *(part->ego.time[3])        = patch->ego.time4;
+    *(part->ego.vel_level_sens) = patch->ego.vel_level_sens;
+    *(part->ego.vel_time_scale) = patch->ego.vel_time_scale;
+    *(part->ego.kbd_time_scale) = patch->ego.kbd_time_scale;
+    *(part->ego.amp_mod_src)    = (float)patch->ego.amp_mod_src;
+    *(part->ego.amp_mod_amt)    = patch->ego.amp_mod_amt;
+
+    *(part->eg1.mode)           = (float)patch->eg1.mode;
+    *(part->eg1.shape[0])       = (float)patch->eg1.shape1;
+    *(part->eg1.time[0])        = patch->eg1.time1;
+    *(part->eg1.level[0])       = patch->eg1.level1;
+    *(part->eg1.shape[1])       = (float)patch->eg1.shape2;
+    *(part->eg1.time[1])        = patch->eg1.time2;
+    *(part->eg1.level[1])       = patch->eg1.level2;
+    *(part->eg1.shape[2])       = (float)patch->eg1.shape3;
+    *(part->eg1.time[2])        = patch->eg1.time3;
+    *(part->eg1.level[2])       = patch->eg1.level3;
+    *(part->eg1.shape[3])       = (float)patch->eg1.shape4;
+    *(part->eg1.time[3])        = patch->eg1.time4;
+    *(part->eg1.vel_level_sens) = patch->eg1.vel_level_sens;
+    *(part->eg1.vel_time_scale) = patch->eg1.vel_time_scale;
+    *(part->eg1.kbd_time_scale) = patch->eg1.kbd_time_scale;
+    *(part->eg1.amp_mod_src)    = (float)patch->eg1.amp_mod_src;
+    *(part->eg1.amp_mod_amt)    = patch->eg1.amp_mod_amt;
+
+    *(part->eg2.mode)           = (float)patch->eg2.mode;
+    *(part->eg2.shape[0])       = (float)patch->eg2.shape1;
+    *(part->eg2.time[0])        = patch->eg2.time1;
+    *(part->eg2.level[0])       = patch->eg2.level1;
+    *(part->eg2.shape[1])       = (float)patch->eg2.shape2;
+    *(part->eg2.time[1])        = patch->eg2.time2;
+    *(part->eg2.level[1])       = patch->eg2.level2;
+    *(part->eg2.shape[2])       = (float)patch->eg2.shape3;
+    *(part->eg2.time[2])        = patch->eg2.time3;
+    *(part->eg2.level[2])       = patch->eg2.level3;
+    *(part->eg2.shape[3])       = (float)patch->eg2.shape4;
+    *(part->eg2.time[3])        = patch->eg2.time4;
+    *(part->eg2.vel_level_sens) = patch->eg2.vel_level_sens;
+    *(part->eg2.vel_time_scale) = patch->eg2.vel_time_scale;
+    *(part->eg2.kbd_time_scale) = patch->eg2.kbd_time_scale;
+    *(part->eg2.amp_mod_src)    = (float)patch->eg2.amp_mod_src;
+    *(part->eg2.amp_mod_amt)    = patch->eg2.amp_mod_amt;
+
+    *(part->eg3.mode)           = (float)patch->eg3.mode;
+    *(part->eg3.shape[0])       = (float)patch->eg3.shape1;
+    *(part->eg3.time[0])        = patch->eg3.time1;
+    *(part->eg3.level[0])       = patch->eg3.level1;
+    *(part->eg3.shape[1])       = (float)patch->eg3.shape2;
+    *(part->eg3.time[1])        = patch->eg3.time2;
+    *(part->eg3.level[1])       = patch->eg3.level2;
+    *(part->eg3.shape[2])       = (float)patch->eg3.shape3;
+    *(part->eg3.time[2])        = patch->eg3.time3;
+    *(part->eg3.level[2])       = patch->eg3.level3;
+    *(part->eg3.shape[3])       = (float)patch->eg3.shape4;
+    *(part->eg3.time[3])        = patch->eg3.time4;
+    *(part->eg3.vel_level_sens) = patch->eg3.vel_level_sens;
+    *(part->eg3.vel_time_scale) = patch->eg3.vel_time_scale;
+    *(part->eg3.kbd_time_scale) = patch->eg3.kbd_time_scale;
+    *(part->eg3.amp_mod_src)    = (float)patch->eg3.amp_mod_src;
+    *(part->eg3.amp_mod_amt)    = patch->eg3.amp_mod_amt;
+
+    *(part->eg4.mode)           = (float)patch->eg4.mode;
+    *(part->eg4.shape[0])       = (float)patch->eg4.shape1;
+    *(part->eg4.time[0])        = patch->eg4.time1;
+    *(part->eg4.level[0])       = patch->eg4.level1;
+    *(part->eg4.shape[1])       = (float)patch->eg4.shape2;
+    *(part->eg4.time[1])        = patch->eg4.time2;
+    *(part->eg4.level[1])       = patch->eg4.level2;
+    *(part->eg4.shape[2])       = (float)patch->eg4.shape3;
+    *(part->eg4.time[2])        = patch->eg4.time3;
+    *(part->eg4.level[2])       = patch->eg4.level3;
+    *(part->eg4.shape[3])       = (float)patch->eg4.shape4;
+    *(part->eg4.time[3])        = patch->eg4.time4;
+    *(part->eg4.vel_level_sens) = patch->eg4.vel_level_sens;
+    *(part->eg4.vel_time_scale) = patch->eg4.vel_time_scale;
+    *(part->eg4.kbd_time_scale) = patch->eg4.kbd_time_scale;
+    *(part->eg4.amp_mod_src)    = (float)patch->eg4.amp_mod_src;
+    *(part->eg4.amp_mod_amt)    = patch->eg4.amp_mod_amt;
+
+    *(part->modmix_bias)        = patch->modmix_bias;
+    *(part->modmix_mod1_src)    = (float)patch->modmix_mod1_src;
+    *(part->modmix_mod1_amt)    = patch->modmix_mod1_amt;
+    *(part->modmix_mod2_src)    = (float)patch->modmix_mod2_src;
+    *(part->modmix_mod2_amt)    = patch->modmix_mod2_amt;
 }
 
 /*
@@ -770,8 +850,9 @@ y_voice_set_ports(y_synth_t *synth, y_patch_t *patch)
 void
 y_voice_update_pressure_mod(y_synth_t *synth, y_voice_t *voice)
 {
-    unsigned char kp = synth->key_pressure[voice->key];
-    unsigned char cp = synth->channel_pressure;
+    y_part_t *part = voice->part;
+    unsigned char kp = part->key_pressure[voice->key];
+    unsigned char cp = part->channel_pressure;
     float p;
 
     /* add the channel and key pressures together in a way that 'feels' good */
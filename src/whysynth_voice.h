@@ -264,20 +264,46 @@ struct vmod
     float delta;
 };
 
+/*
+ * y_voice_bus
+ *
+ * A voice's oscillator buses.  These make up more than half of a voice's
+ * memory, so rather than each voice having its own, playing voices draw
+ * them from a pool in y_synth_t (see y_voice_start_voice()), which keeps
+ * the buses in use packed together however the voices are spread.
+ */
+struct y_voice_bus
+{
+    float         osc_sync[Y_CONTROL_PERIOD];       /* buffer for sync subsample offsets */
+    float         osc_bus_a[OSC_BUS_LENGTH],
+                  osc_bus_b[OSC_BUS_LENGTH];
+};
+
 /*
  * y_voice_t
+ *
+ * Laid out with the state touched on every render burst first, and the
+ * note bookkeeping only looked at on note events last.
  */
 struct _y_voice_t
 {
-    unsigned int  note_id;
-
     unsigned char status;
     unsigned char key;
-    unsigned char velocity;
-    unsigned char rvelocity;   /* the note-off velocity */
+    y_part_t     *part;        /* the part whose patch this voice plays */
+
+    /* buses, from the synth's pool while the voice is playing, else NULL */
+    struct y_voice_bus *bus;
+    int           osc_index;                        /* shared index into osc_bus_{a,b} */
+    float        *osc_sync,                         /* bus->osc_sync */
+                 *osc_bus_a,                        /* bus->osc_bus_a */
+                 *osc_bus_b;                        /* bus->osc_bus_b */
 
     /* translated controller values */
     float         pressure;
+    float         cc_volume,   /* the part's cc_volume and cc_pan at the end */
+                  cc_pan;      /*   of the last burst, to ramp from */
+
+    float         energy;      /* sum of squared output over this control period */
 
     /* persistent voice state */
     float         prev_pitch,
@@ -302,11 +328,14 @@ struct _y_voice_t
                   eg4;
     struct vmod   mod[Y_MODS_COUNT];
 
-    /* buffers */
-    int           osc_index;                        /* shared index into osc_bus_{a,b} */
-    float         osc_sync[Y_CONTROL_PERIOD];       /* buffer for sync subsample offsets */
-    float         osc_bus_a[OSC_BUS_LENGTH],
-                  osc_bus_b[OSC_BUS_LENGTH];
+    /* note bookkeeping */
+    int           index;       /* this voice's position in synth->voice[] */
+    int           active_slot; /* its position in synth->active_voice[], while playing */
+    y_voice_t    *key_prev,    /* neighbors in synth->key_voices[key], while playing */
+                 *key_next;
+    unsigned int  note_id;
+    unsigned char velocity;
+    unsigned char rvelocity;   /* the note-off velocity */
 };
 
 #define _PLAYING(voice)    ((voice)->status != Y_VOICE_OFF)
@@ -324,13 +353,14 @@ extern float y_slope_dd_table[];
 
 /* in whysynth_voice.c */
 extern float eg_shape_coeffs[][4];
-y_voice_t *y_voice_new(y_synth_t *synth);
+size_t     y_voice_block_size(int first, int count);
+int        y_voice_add_block(y_synth_t *synth, y_arena_t *arena, int count);
 void       y_voice_note_on(y_synth_t *synth, y_voice_t *voice,
                            unsigned char key, unsigned char velocity);
 void       y_voice_note_off(y_synth_t *synth, y_voice_t *voice,
                             unsigned char key, unsigned char rvelocity);
 void       y_voice_release_note(y_synth_t *synth, y_voice_t *voice);
-void       y_voice_set_ports(y_synth_t *synth, y_patch_t *patch);
+void       y_voice_set_ports(y_synth_t *synth, y_part_t *part, y_patch_t *patch);
 void       y_voice_update_pressure_mod(y_synth_t *synth, y_voice_t *voice);
 
 /* in whysynth_voice_render.c */
@@ -344,7 +374,8 @@ void y_voice_update_lfo(y_synth_t *synth, y_slfo_t *slfo, struct vlfo *vlfo,
                         struct vmod *srcmods, struct vmod *destmod);
 void y_voice_render(y_synth_t *synth, y_voice_t *voice,
                     LADSPA_Data *out_left, LADSPA_Data *out_right,
-                    unsigned long sample_count, int do_control_update);
+                    unsigned long sample_count);
+void y_voice_control_update(y_synth_t *synth, y_voice_t *voice);
 
 /* in agran_oscillator.c */
 void free_active_grains(y_synth_t *synth, y_voice_t *voice);
@@ -352,36 +383,16 @@ void free_active_grains(y_synth_t *synth, y_voice_t *voice);
 /* ==== inline functions ==== */
 
 /*
- * y_voice_off
- * 
- * Purpose: Turns off a voice immediately, meaning that it is not processed
- * anymore by the render loop.
- */
-static inline void
-y_voice_off(y_synth_t *synth, y_voice_t* voice)
-{
-    voice->status = Y_VOICE_OFF;
-
-    /* silence the oscillator buffers for the next use */
-    memset(voice->osc_bus_a, 0, OSC_BUS_LENGTH * sizeof(float));
-    memset(voice->osc_bus_b, 0, OSC_BUS_LENGTH * sizeof(float));
-
-    /* free any still-active grains */
-    if (voice->osc1.grain_list || voice->osc2.grain_list ||
-        voice->osc3.grain_list || voice->osc4.grain_list)
-        free_active_grains(synth, voice);
-
-    /* -FIX- decrement active voice count? */
-}
-
-/*
- * y_voice_start_voice
+ * y_mod_ramp_to_next
+ *
+ * Sets a modulator's delta so that it reaches its next_value at the end of
+ * the current control period, no matter where in the period the current
+ * render burst begins.
  */
 static inline void
-y_voice_start_voice(y_voice_t *voice)
+y_mod_ramp_to_next(struct vmod *mod, unsigned long control_remains)
 {
-    voice->status = Y_VOICE_ON;
-    /* -FIX- increment active voice count? */
+    mod->delta = (mod->next_value - mod->value) / (float)control_remains;
 }
 
 #endif /* _WHYSYNTH_VOICE_H */
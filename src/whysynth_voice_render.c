@@ -466,17 +466,44 @@ y_voice_check_for_dead(y_synth_t *synth, y_voice_t *voice)
     return 0;
 }
 
+/*
+ * y_voice_check_for_silence
+ *
+ * Turns off a voice whose output over the last control period fell below
+ * the instance's silence threshold, relative to the recent peak level of
+ * all its voices together, so that a tail is culled only once it is lost
+ * under louder notes.  Only voices which have had their note
+ * off are culled, and only while their amplitude envelope is past its first
+ * segment and not rising, so that neither a slow attack nor a momentary
+ * tremolo null in a held note gets mistaken for silence.
+ */
+static inline int
+y_voice_check_for_silence(y_synth_t *synth, y_voice_t *voice)
+{
+    float energy = voice->energy;
+
+    voice->energy = 0.0f;
+
+    if (synth->silence_threshold > 0.0f && !_ON(voice) &&
+        energy < synth->silence_threshold * synth->mix_level &&
+        voice->ego.segment > 0 &&
+        voice->mod[Y_MOD_EGO].next_value <= voice->mod[Y_MOD_EGO].value) {
+
+        YDB_MESSAGE(YDB_NOTE, " y_voice_check_for_silence: culling voice %d note id %d\n", voice->index, voice->note_id);
+        y_voice_off(synth, voice);
+        synth->telemetry.voices_culled++;
+        return 1;
+    }
+    return 0;
+}
+
 /*
  * y_mod_update_pressure
  */
 static inline void
 y_mod_update_pressure(y_synth_t *synth, y_voice_t *voice)
 {
-    if (fabsf(voice->mod[Y_MOD_PRESSURE].next_value - voice->mod[Y_MOD_PRESSURE].value) > 1e-10) {
-        voice->mod[Y_MOD_PRESSURE].delta =
-           (voice->mod[Y_MOD_PRESSURE].next_value - voice->mod[Y_MOD_PRESSURE].value) /
-               (float)Y_CONTROL_PERIOD;
-    }
+    y_mod_ramp_to_next(&voice->mod[Y_MOD_PRESSURE], synth->control_remains);
 }
 
 /*
@@ -485,14 +512,15 @@ y_mod_update_pressure(y_synth_t *synth, y_voice_t *voice)
 static inline void
 y_mod_update_modmix(y_synth_t *synth, y_voice_t *voice, unsigned long sample_count)
 {
+    y_part_t *part = voice->part;
     int mod;
     float n = (float)sample_count,
-          f = *(synth->modmix_bias);
+          f = *(part->modmix_bias);
 
-    mod = y_voice_mod_index(synth->modmix_mod1_src);
-    f += *(synth->modmix_mod1_amt) * (voice->mod[mod].next_value + voice->mod[mod].delta * n);
-    mod = y_voice_mod_index(synth->modmix_mod2_src);
-    f += *(synth->modmix_mod2_amt) * (voice->mod[mod].next_value + voice->mod[mod].delta * n);
+    mod = y_voice_mod_index(part->modmix_mod1_src);
+    f += *(part->modmix_mod1_amt) * (voice->mod[mod].next_value + voice->mod[mod].delta * n);
+    mod = y_voice_mod_index(part->modmix_mod2_src);
+    f += *(part->modmix_mod2_amt) * (voice->mod[mod].next_value + voice->mod[mod].delta * n);
 
     if (f > 2.0f) f = 2.0f;
     else if (f < -2.0f) f = -2.0f;
@@ -2015,7 +2043,8 @@ oscillator(unsigned long sample_count, y_synth_t *synth, y_sosc_t *sosc,
         break;
 
       case Y_OSCILLATOR_MODE_PADSYNTH: /* PADsynth */
-        padsynth_oscillator(sample_count, sosc, voice, vosc, index, w);
+        if (!padsynth_oscillator(sample_count, sosc, voice, vosc, index, w))
+            synth->telemetry.sampleset_not_ready++;
         break;
 
       case Y_OSCILLATOR_MODE_PD: /* phase distortion */
@@ -2595,8 +2624,9 @@ vcf_resonz(unsigned long sample_count, y_svcf_t *svcf, y_voice_t *voice,
 void
 y_voice_render(y_synth_t *synth, y_voice_t *voice,
                     LADSPA_Data *out_left, LADSPA_Data *out_right,
-                    unsigned long sample_count, int do_control_update)
+                    unsigned long sample_count)
 {
+    y_part_t     *part = voice->part;
     unsigned long sample;
     float         deltat = synth->deltat;
     int           osc_index = voice->osc_index;
@@ -2604,113 +2634,114 @@ y_voice_render(y_synth_t *synth, y_voice_t *voice,
                  *vcf_source;
 
     /* calculate fundamental pitch of voice */
-    voice->current_pitch = *(synth->glide_time) * voice->target_pitch +
-                            (1.0f - *(synth->glide_time)) * voice->prev_pitch;    /* portamento */
-    if (do_control_update) {
-        voice->prev_pitch = voice->current_pitch; /* save pitch for next time */
-    }
-    voice->current_pitch *= synth->pitch_bend * *(synth->tuning);
+    voice->current_pitch = *(part->glide_time) * voice->target_pitch +
+                            (1.0f - *(part->glide_time)) * voice->prev_pitch;    /* portamento */
+    voice->current_pitch *= part->pitch_bend * *(synth->tuning);
 
     /* condition some frequently-used integer ports */
-    voice->osc1.mode        = lrintf(*(synth->osc1.mode));
-    voice->osc1.waveform    = y_voice_waveform_index(synth->osc1.waveform);
-    voice->osc2.mode        = lrintf(*(synth->osc2.mode));
-    voice->osc2.waveform    = y_voice_waveform_index(synth->osc2.waveform);
-    voice->osc3.mode        = lrintf(*(synth->osc3.mode));
-    voice->osc3.waveform    = y_voice_waveform_index(synth->osc3.waveform);
-    voice->osc4.mode        = lrintf(*(synth->osc4.mode));
-    voice->osc4.waveform    = y_voice_waveform_index(synth->osc4.waveform);
-    voice->vcf1.mode        = lrintf(*(synth->vcf1.mode));
-    voice->vcf2.mode        = lrintf(*(synth->vcf2.mode));
+    voice->osc1.mode        = lrintf(*(part->osc1.mode));
+    voice->osc1.waveform    = y_voice_waveform_index(part->osc1.waveform);
+    voice->osc2.mode        = lrintf(*(part->osc2.mode));
+    voice->osc2.waveform    = y_voice_waveform_index(part->osc2.waveform);
+    voice->osc3.mode        = lrintf(*(part->osc3.mode));
+    voice->osc3.waveform    = y_voice_waveform_index(part->osc3.waveform);
+    voice->osc4.mode        = lrintf(*(part->osc4.mode));
+    voice->osc4.waveform    = y_voice_waveform_index(part->osc4.waveform);
+    voice->vcf1.mode        = lrintf(*(part->vcf1.mode));
+    voice->vcf2.mode        = lrintf(*(part->vcf2.mode));
 
     /* update modulators */
-    voice->mod[Y_MOD_MODWHEEL] = synth->mod[Y_MOD_MODWHEEL];
+    voice->mod[Y_MOD_MODWHEEL] = part->mod[Y_MOD_MODWHEEL];
     y_mod_update_pressure(synth, voice);
-    voice->mod[Y_MOD_GLFO]     = synth->mod[Y_GLOBAL_MOD_GLFO];
-    voice->mod[Y_MOD_GLFO_UP]  = synth->mod[Y_GLOBAL_MOD_GLFO_UP];
+    voice->mod[Y_MOD_GLFO]     = part->mod[Y_GLOBAL_MOD_GLFO];
+    voice->mod[Y_MOD_GLFO_UP]  = part->mod[Y_GLOBAL_MOD_GLFO_UP];
     y_mod_update_modmix(synth, voice, sample_count);
 
     /* --- VCO section */
 
     /* -FIX- this should move into oscillators, so they can do mode-specific things with it (like ignore it?...) */
-    osc1_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(synth->osc1.pitch) + *(synth->osc1.detune));
-    osc2_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(synth->osc2.pitch) + *(synth->osc2.detune));
-    osc3_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(synth->osc3.pitch) + *(synth->osc3.detune));
-    osc4_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(synth->osc4.pitch) + *(synth->osc4.detune));
+    osc1_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(part->osc1.pitch) + *(part->osc1.detune));
+    osc2_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(part->osc2.pitch) + *(part->osc2.detune));
+    osc3_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(part->osc3.pitch) + *(part->osc3.detune));
+    osc4_omega = voice->current_pitch * pitch_to_frequency(69.0f + *(part->osc4.pitch) + *(part->osc4.detune));
 
-    oscillator(sample_count, synth, &synth->osc1, voice, &voice->osc1, osc_index, deltat * osc1_omega);
-    oscillator(sample_count, synth, &synth->osc2, voice, &voice->osc2, osc_index, deltat * osc2_omega);
-    oscillator(sample_count, synth, &synth->osc3, voice, &voice->osc3, osc_index, deltat * osc3_omega);
-    oscillator(sample_count, synth, &synth->osc4, voice, &voice->osc4, osc_index, deltat * osc4_omega);
+    oscillator(sample_count, synth, &part->osc1, voice, &voice->osc1, osc_index, deltat * osc1_omega);
+    oscillator(sample_count, synth, &part->osc2, voice, &voice->osc2, osc_index, deltat * osc2_omega);
+    oscillator(sample_count, synth, &part->osc3, voice, &voice->osc3, osc_index, deltat * osc3_omega);
+    oscillator(sample_count, synth, &part->osc4, voice, &voice->osc4, osc_index, deltat * osc4_omega);
 
     /* --- VCF section */
 
+#ifdef Y_DENORMAL_NOISE
     voice->osc_bus_a[osc_index] += 1e-20f; /* make sure things don't get too quiet... */
     voice->osc_bus_b[osc_index] += 1e-20f;
     voice->osc_bus_a[osc_index + (sample_count >> 1)] -= 1e-20f;
     voice->osc_bus_b[osc_index + (sample_count >> 1)] -= 1e-20f;
+#endif
+    /* (elsewhere, denormals are flushed to zero by y_run_synth(), so
+     * there's no need to add noise here to keep the filters out of them) */
 
-    vcf_source = (*(synth->vcf1.source) < 0.001f) ? voice->osc_bus_a :
+    vcf_source = (*(part->vcf1.source) < 0.001f) ? voice->osc_bus_a :
                                                     voice->osc_bus_b;
     vcf_source += osc_index;
-    switch (lrintf(*(synth->vcf1.mode))) {
+    switch (lrintf(*(part->vcf1.mode))) {
       default:
       case 0:
         vcf_off(sample_count, &voice->vcf1, synth->vcf1_out);
         break;
       case 1:
-        vcf_2pole(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_2pole(sample_count, &part->vcf1, voice, &voice->vcf1,
                   deltat * voice->current_pitch,
                   vcf_source, synth->vcf1_out);
         break;
       case 2:
-        vcf_4pole(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_4pole(sample_count, &part->vcf1, voice, &voice->vcf1,
                   deltat * voice->current_pitch,
                   vcf_source, synth->vcf1_out);
         break;
       case 3:
-        vcf_mvclpf(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_mvclpf(sample_count, &part->vcf1, voice, &voice->vcf1,
                    deltat * voice->current_pitch,
                    vcf_source, synth->vcf1_out);
         break;
       case 4:
-        vcf_clip4pole(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_clip4pole(sample_count, &part->vcf1, voice, &voice->vcf1,
                       deltat * voice->current_pitch,
                       vcf_source, synth->vcf1_out);
         break;
       case 5:
-        vcf_bandpass(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_bandpass(sample_count, &part->vcf1, voice, &voice->vcf1,
                      deltat * voice->current_pitch,
                      vcf_source, synth->vcf1_out);
         break;
       case 6:
-        vcf_amsynth(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_amsynth(sample_count, &part->vcf1, voice, &voice->vcf1,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf1_out);
         break;
       case 7:
-        vcf_resonz(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_resonz(sample_count, &part->vcf1, voice, &voice->vcf1,
                   deltat * voice->current_pitch,
                   vcf_source, synth->vcf1_out);
         break;
       case 8:
-        vcf_highpass_2pole(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_highpass_2pole(sample_count, &part->vcf1, voice, &voice->vcf1,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf1_out);
         break;
       case 9:
-        vcf_highpass_4pole(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_highpass_4pole(sample_count, &part->vcf1, voice, &voice->vcf1,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf1_out);
         break;
       case 10:
-        vcf_bandreject(sample_count, &synth->vcf1, voice, &voice->vcf1,
+        vcf_bandreject(sample_count, &part->vcf1, voice, &voice->vcf1,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf1_out);
         break;
     }
 
-    switch (lrintf(*(synth->vcf2.source))) {
+    switch (lrintf(*(part->vcf2.source))) {
       default:
       case 0:
         vcf_source = voice->osc_bus_a + osc_index;
@@ -2722,58 +2753,58 @@ y_voice_render(y_synth_t *synth, y_voice_t *voice,
         vcf_source = synth->vcf1_out;
         break;
     }
-    switch (lrintf(*(synth->vcf2.mode))) {
+    switch (lrintf(*(part->vcf2.mode))) {
       default:
       case 0:
         vcf_off(sample_count, &voice->vcf2, synth->vcf2_out);
         break;
       case 1:
-        vcf_2pole(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_2pole(sample_count, &part->vcf2, voice, &voice->vcf2,
                   deltat * voice->current_pitch,
                   vcf_source, synth->vcf2_out);
         break;
       case 2:
-        vcf_4pole(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_4pole(sample_count, &part->vcf2, voice, &voice->vcf2,
                   deltat * voice->current_pitch,
                   vcf_source, synth->vcf2_out);
         break;
       case 3:
-        vcf_mvclpf(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_mvclpf(sample_count, &part->vcf2, voice, &voice->vcf2,
                    deltat * voice->current_pitch,
                    vcf_source, synth->vcf2_out);
         break;
       case 4:
-        vcf_clip4pole(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_clip4pole(sample_count, &part->vcf2, voice, &voice->vcf2,
                       deltat * voice->current_pitch,
                       vcf_source, synth->vcf2_out);
         break;
       case 5:
-        vcf_bandpass(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_bandpass(sample_count, &part->vcf2, voice, &voice->vcf2,
                      deltat * voice->current_pitch,
                      vcf_source, synth->vcf2_out);
         break;
       case 6:
-        vcf_amsynth(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_amsynth(sample_count, &part->vcf2, voice, &voice->vcf2,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf2_out);
         break;
       case 7:
-        vcf_resonz(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_resonz(sample_count, &part->vcf2, voice, &voice->vcf2,
                   deltat * voice->current_pitch,
                   vcf_source, synth->vcf2_out);
         break;
       case 8:
-        vcf_highpass_2pole(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_highpass_2pole(sample_count, &part->vcf2, voice, &voice->vcf2,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf2_out);
         break;
       case 9:
-        vcf_highpass_4pole(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_highpass_4pole(sample_count, &part->vcf2, voice, &voice->vcf2,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf2_out);
         break;
       case 10:
-        vcf_bandreject(sample_count, &synth->vcf2, voice, &voice->vcf2,
+        vcf_bandreject(sample_count, &part->vcf2, voice, &voice->vcf2,
                     deltat * voice->current_pitch,
                     vcf_source, synth->vcf2_out);
         break;
@@ -2781,40 +2812,45 @@ y_voice_render(y_synth_t *synth, y_voice_t *voice,
 
     /* --- VCA section */
 
-    {   float amp_busa_l = *(synth->busa_level) * pan_cv_to_amplitude(1.0f - *(synth->busa_pan)),
-              amp_busa_r = *(synth->busa_level) * pan_cv_to_amplitude(       *(synth->busa_pan)),
-              amp_busb_l = *(synth->busb_level) * pan_cv_to_amplitude(1.0f - *(synth->busb_pan)),
-              amp_busb_r = *(synth->busb_level) * pan_cv_to_amplitude(       *(synth->busb_pan)),
-              amp_vcf1_l = *(synth->vcf1_level) * pan_cv_to_amplitude(1.0f - *(synth->vcf1_pan)),
-              amp_vcf1_r = *(synth->vcf1_level) * pan_cv_to_amplitude(       *(synth->vcf1_pan)),
-              amp_vcf2_l = *(synth->vcf2_level) * pan_cv_to_amplitude(1.0f - *(synth->vcf2_pan)),
-              amp_vcf2_r = *(synth->vcf2_level) * pan_cv_to_amplitude(       *(synth->vcf2_pan)),
-              vol_out   = volume(*(synth->volume) * synth->cc_volume),
+    {   float amp_busa_l = *(part->busa_level) * pan_cv_to_amplitude(1.0f - *(part->busa_pan)),
+              amp_busa_r = *(part->busa_level) * pan_cv_to_amplitude(       *(part->busa_pan)),
+              amp_busb_l = *(part->busb_level) * pan_cv_to_amplitude(1.0f - *(part->busb_pan)),
+              amp_busb_r = *(part->busb_level) * pan_cv_to_amplitude(       *(part->busb_pan)),
+              amp_vcf1_l = *(part->vcf1_level) * pan_cv_to_amplitude(1.0f - *(part->vcf1_pan)),
+              amp_vcf1_r = *(part->vcf1_level) * pan_cv_to_amplitude(       *(part->vcf1_pan)),
+              amp_vcf2_l = *(part->vcf2_level) * pan_cv_to_amplitude(1.0f - *(part->vcf2_pan)),
+              amp_vcf2_r = *(part->vcf2_level) * pan_cv_to_amplitude(       *(part->vcf2_pan)),
+              /* MIDI volume and pan changes (which may have been handled
+               * early, coalesced into this burst) are ramped across the
+               * burst along with the amplitude envelope */
+              vol_out   = volume(*(part->volume) * voice->cc_volume),
+              vol_end   = volume(*(part->volume) * part->cc_volume),
               vca       = vol_out * volume_cv_to_amplitude(voice->mod[Y_MOD_EGO].value),
-              vca_delta = vol_out * volume_cv_to_amplitude(voice->mod[Y_MOD_EGO].value +
+              vca_delta = vol_end * volume_cv_to_amplitude(voice->mod[Y_MOD_EGO].value +
                                                            voice->mod[Y_MOD_EGO].delta *
                                                                (float)sample_count),
-              pan_l     = pan_cv_to_amplitude(1.0f - synth->cc_pan),
-              pan_r     = pan_cv_to_amplitude(       synth->cc_pan),
-              vca_l     = vca * pan_l,
-              vca_r     = vca * pan_r,
-              vca_delta_l = vca_delta * pan_l,
-              vca_delta_r = vca_delta * pan_r;
+              vca_l     = vca * pan_cv_to_amplitude(1.0f - voice->cc_pan),
+              vca_r     = vca * pan_cv_to_amplitude(       voice->cc_pan),
+              vca_delta_l = vca_delta * pan_cv_to_amplitude(1.0f - part->cc_pan),
+              vca_delta_r = vca_delta * pan_cv_to_amplitude(       part->cc_pan);
+
+        float l, r, energy = 0.0f;
 
         vca_delta_l = (vca_delta_l - vca_l) / (float)sample_count;
         vca_delta_r = (vca_delta_r - vca_r) / (float)sample_count;
           
         for (sample = 0; sample < sample_count; sample++) {
-            out_left[sample]  += vca_l *
-                                 (amp_busa_l * voice->osc_bus_a[sample + osc_index] +
-                                  amp_busb_l * voice->osc_bus_b[sample + osc_index] +
-                                  amp_vcf1_l * synth->vcf1_out[sample] +
-                                  amp_vcf2_l * synth->vcf2_out[sample]);
-            out_right[sample] += vca_r *
-                                 (amp_busa_r * voice->osc_bus_a[sample + osc_index] +
-                                  amp_busb_r * voice->osc_bus_b[sample + osc_index] +
-                                  amp_vcf1_r * synth->vcf1_out[sample] +
-                                  amp_vcf2_r * synth->vcf2_out[sample]);
+            l = vca_l * (amp_busa_l * voice->osc_bus_a[sample + osc_index] +
+                         amp_busb_l * voice->osc_bus_b[sample + osc_index] +
+                         amp_vcf1_l * synth->vcf1_out[sample] +
+                         amp_vcf2_l * synth->vcf2_out[sample]);
+            r = vca_r * (amp_busa_r * voice->osc_bus_a[sample + osc_index] +
+                         amp_busb_r * voice->osc_bus_b[sample + osc_index] +
+                         amp_vcf1_r * synth->vcf1_out[sample] +
+                         amp_vcf2_r * synth->vcf2_out[sample]);
+            out_left[sample]  += l;
+            out_right[sample] += r;
+            energy += l * l + r * r;
             vca_l += vca_delta_l;
             vca_r += vca_delta_r;
 
@@ -2822,43 +2858,18 @@ y_voice_render(y_synth_t *synth, y_voice_t *voice,
             voice->osc_bus_a[sample + osc_index] = 0.0f;
             voice->osc_bus_b[sample + osc_index] = 0.0f;
         }
+        voice->energy += energy;
+        synth->mix_level_next += energy;
+        voice->cc_volume = part->cc_volume;
+        voice->cc_pan    = part->cc_pan;
     }
 
     osc_index += sample_count;
 
-    if (do_control_update) {
-        /* do those things that should be done only once per control-calculation
-         * interval (render burst), such as voice check-for-dead, pitch
-         * envelope calculations, volume envelope phase transition checks, etc.
-         */
-
-        /* -FIX- updating modulators _after_ rendering means a delay of up to 64 samples in
-         * the response to those we can't predict (modwheel, pressure, etc.) -- as part of the
-         * redesign, they need to be updated on the top side of the control period. */
-        voice->mod[Y_MOD_MODWHEEL].value += (float)sample_count * voice->mod[Y_MOD_MODWHEEL].delta;
-        voice->mod[Y_MOD_PRESSURE].value += (float)sample_count * voice->mod[Y_MOD_PRESSURE].delta;
-        y_voice_update_lfo(synth, &synth->vlfo, &voice->vlfo,  voice->mod, &voice->mod[Y_MOD_VLFO]);
-        y_voice_update_lfo(synth, &synth->mlfo, &voice->mlfo0, voice->mod, &voice->mod[Y_MOD_MLFO0]);
-        y_voice_update_lfo(synth, &synth->mlfo, &voice->mlfo1, voice->mod, &voice->mod[Y_MOD_MLFO1]);
-        y_voice_update_lfo(synth, &synth->mlfo, &voice->mlfo2, voice->mod, &voice->mod[Y_MOD_MLFO2]);
-        y_voice_update_lfo(synth, &synth->mlfo, &voice->mlfo3, voice->mod, &voice->mod[Y_MOD_MLFO3]);
-
-        y_voice_update_eg(&synth->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
-        /* check if we've decayed to nothing, turn off voice if so */
-        if (y_voice_check_for_dead(synth, voice))
-            return; /* we're dead now, so return */
-
-        y_voice_update_eg(&synth->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
-        y_voice_update_eg(&synth->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
-        y_voice_update_eg(&synth->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
-        y_voice_update_eg(&synth->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
-        voice->mod[Y_MOD_MIX].value += (float)sample_count * voice->mod[Y_MOD_MIX].delta;
-
-        osc_index &= OSC_BUS_MASK;
-
-    } else {
-        /* update modulator values for the incomplete control cycle */
-        int i;
+    /* advance modulator values to the end of this burst; those things that
+     * should be done only once per control period are done at the top of
+     * the next period, by y_voice_control_update() */
+    {   int i;
 
         for (i = 1; i < Y_MODS_COUNT; i++)
             voice->mod[i].value += (float)sample_count * voice->mod[i].delta;
@@ -2866,7 +2877,66 @@ y_voice_render(y_synth_t *synth, y_voice_t *voice,
 
     /* save things for next time around */
 
-    /* already saved prev_pitch above */
     voice->osc_index  = osc_index;
 }
 
+/*
+ * y_voice_control_update
+ *
+ * Do those things that should be done only once per control-calculation
+ * interval, such as voice check-for-dead, pitch envelope calculations,
+ * volume envelope phase transition checks, etc.  This is called at the top
+ * of each control period, before any events falling on that tick have been
+ * handled, so the controller modulators (modwheel, pressure) can then be
+ * ramped from wherever an event lands to the end of the period, without
+ * the render burst having to end there.
+ */
+void
+y_voice_control_update(y_synth_t *synth, y_voice_t *voice)
+{
+    y_part_t *part = voice->part;
+    float amp;
+
+    /* save pitch for next time */
+    voice->prev_pitch = *(part->glide_time) * voice->target_pitch +
+                        (1.0f - *(part->glide_time)) * voice->prev_pitch;
+
+    /* controller ramps have landed on their targets */
+    voice->mod[Y_MOD_MODWHEEL].value = voice->mod[Y_MOD_MODWHEEL].next_value;
+    voice->mod[Y_MOD_PRESSURE].value = voice->mod[Y_MOD_PRESSURE].next_value;
+
+    y_voice_update_lfo(synth, &part->vlfo, &voice->vlfo,  voice->mod, &voice->mod[Y_MOD_VLFO]);
+    y_voice_update_lfo(synth, &part->mlfo, &voice->mlfo0, voice->mod, &voice->mod[Y_MOD_MLFO0]);
+    y_voice_update_lfo(synth, &part->mlfo, &voice->mlfo1, voice->mod, &voice->mod[Y_MOD_MLFO1]);
+    y_voice_update_lfo(synth, &part->mlfo, &voice->mlfo2, voice->mod, &voice->mod[Y_MOD_MLFO2]);
+    y_voice_update_lfo(synth, &part->mlfo, &voice->mlfo3, voice->mod, &voice->mod[Y_MOD_MLFO3]);
+
+    y_voice_update_eg(&part->ego, voice, &voice->ego, &voice->mod[Y_MOD_EGO]);
+    /* check if we've decayed to nothing (or to inaudibility), turn off voice if so */
+    if (y_voice_check_for_dead(synth, voice) ||
+        y_voice_check_for_silence(synth, voice))
+        return; /* we're dead now, so return */
+
+    y_voice_update_eg(&part->eg1, voice, &voice->eg1, &voice->mod[Y_MOD_EG1]);
+    y_voice_update_eg(&part->eg2, voice, &voice->eg2, &voice->mod[Y_MOD_EG2]);
+    y_voice_update_eg(&part->eg3, voice, &voice->eg3, &voice->mod[Y_MOD_EG3]);
+    y_voice_update_eg(&part->eg4, voice, &voice->eg4, &voice->mod[Y_MOD_EG4]);
+
+    voice->osc_index &= OSC_BUS_MASK;
+
+    /* rank this voice for stealing by its state and loudness */
+    if (voice->ego.state == DSSP_EG_RUNNING && voice->ego.segment == 0) {
+        amp = 1.0f;  /* don't judge a note by its attack */
+    } else {
+        amp = fabsf(volume_cv_to_amplitude(voice->mod[Y_MOD_EGO].next_value));
+        if (amp > 1.0f) amp = 1.0f;
+    }
+    if (_ON(voice))
+        amp += Y_VOICE_PRIO_ON;
+    else if (_SUSTAINED(voice))
+        amp += Y_VOICE_PRIO_SUSTAINED;
+    else
+        amp += Y_VOICE_PRIO_RELEASED;
+    synth->voice_prio[voice->index] = amp;
+}
+